@@ -95,6 +95,8 @@ namespace boitatah
         TRANSFER_SRC            = 3,
         TRANSFER_DST            = 4,
         UNIFORM_BUFFER          = 5,
+        //uniform, vertex and index data written by the CPU every frame.
+        TRANSIENT               = 6,
 
     };
 
@@ -535,6 +537,10 @@ namespace boitatah
         case BUFFER_USAGE::UNIFORM_BUFFER:
             return VK_BUFFER_USAGE_TRANSFER_DST_BIT |
             VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+        case BUFFER_USAGE::TRANSIENT:
+            return VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
+                   VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+                   VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
         default:
             return VK_BUFFER_USAGE_TRANSFER_DST_BIT;
         }
@@ -569,7 +575,7 @@ namespace boitatah
         case SHADER_STAGE::FRAGMENT:
             return VK_SHADER_STAGE_FRAGMENT_BIT;
         case SHADER_STAGE::VERTEX_FRAGMENT:
-            return VK_SHADER_STAGE_VERTEX_BIT ||VK_SHADER_STAGE_FRAGMENT_BIT;
+            return VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
         case SHADER_STAGE::ALL_GRAPHICS:
             return VK_SHADER_STAGE_ALL_GRAPHICS;
         default:
@@ -4,13 +4,19 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
+#include <array>
+#include <exception>
+#include <mutex>
+#include <span>
 #include <vector>
 #include <string>
+#include <thread>
 #include <utility>
 #include <glm/vec2.hpp>
 
 #include <boitatah/backend/vulkan/Vulkan.hpp>
 #include <boitatah/backend/vulkan/Window.hpp>
+#include <boitatah/backend/vulkan/VkSubmissionList.hpp>
 #include <boitatah/modules/DescriptorSetManager.hpp>
 
 #include <boitatah/modules/BackBufferDesc.hpp>
@@ -20,6 +26,7 @@
 #include <boitatah/types/types.hpp>
 
 #include <boitatah/buffers/BufferManager.hpp>
+#include <boitatah/buffers/TransientRing.hpp>
 
 #include <boitatah/modules/ImageManager.hpp>
 #include <boitatah/modules/RenderTargetManager.hpp>
@@ -30,8 +37,13 @@
 #include <boitatah/modules/Swapchain.hpp>
 #include <boitatah/modules/BufferCamera.hpp>
 #include <boitatah/modules/Camera.hpp>
+#include <boitatah/modules/JobSystem.hpp>
+#include <boitatah/modules/GpuProfiler.hpp>
+#include <boitatah/modules/MemoryReport.hpp>
+#include <boitatah/modules/AllocAudit.hpp>
 #include <boitatah/collections.hpp>
 #include <boitatah/scene/Scene.hpp>
+#include <boitatah/lights/Lights.hpp>
 
 namespace boitatah
 {
@@ -49,6 +61,18 @@ namespace boitatah
     ///     debug -> bool:                  turns vulkan validation layers on/off
     ///     swapchainFormat -> IMAGE_FORMAT:the present image format.
     ///     backBufferDesc:                 render graph description. See BackBuffer.hpp   
+    ///     jobThreads -> u32:              job system threads, counting the render thread. 0 for one per core.
+    ///     recordThreads -> u32:           threads recording a stage's draws, 0 for the job thread count.
+    ///     renderThread -> bool:           submit_frame renders on a dedicated thread.
+    ///     snapshotBuffers -> u32:         frame snapshots in flight to the render thread, 2 or 3.
+    ///                                     2 paces the caller to the render thread, 3 lets it run ahead.
+    ///     frameArenaSize -> size_t:       initial bytes of the per frame arena, it grows to fit a frame.
+    ///     transientRingSize -> u32:       bytes of mapped gpu memory per frame in flight for per frame data.
+    ///     defragmentBudget -> u64:        bytes of buffer reservations moved per frame to empty sparse buffers, 0 disables it.
+    ///     allocationTrace -> const char *: file recording every buffer reserve and free, nullptr records nothing.
+    ///     hiddenWindow -> bool:           renders to a window that is never shown.
+    ///     gpuProfiling -> bool:           times the stages on the gpu with timestamp queries, see getGpuTimings.
+    ///     memoryBudget:                   memory limits that print a warning once exceeded, see MemoryBudget.
     struct RendererOptions
     {
         glm::u32vec2 windowDimensions = {800, 600};
@@ -56,8 +80,26 @@ namespace boitatah
         bool debug = false;
         IMAGE_FORMAT swapchainFormat = IMAGE_FORMAT::BGRA_8_SRGB;
         BackBufferDesc backBufferDesc;
+        uint32_t jobThreads = 0;
+        uint32_t recordThreads = 0;
+        bool renderThread = false;
+        uint32_t snapshotBuffers = 3;
+        std::size_t frameArenaSize = 64 * 1024;
+        uint32_t transientRingSize = 1 << 20;
+        uint64_t defragmentBudget = 1 << 20;
+        const char *allocationTrace = nullptr;
+        bool hiddenWindow = false;
+        bool gpuProfiling = false;
+        MemoryBudget memoryBudget;
     };
 
+    ///Stages with fewer draws per record thread are recorded in fewer chunks,
+    /// a single chunk is recorded inline in the primary buffer.
+    constexpr uint32_t DRAWS_PER_RECORD_CHUNK = 256;
+
+    ///Scene nodes per job when updating the transforms of one tree level.
+    constexpr uint32_t TRANSFORMS_PER_JOB = 512;
+
     ///Base Draw command target
     /// Holds the minimum data to render a SceneNode.
     struct RenderObject{
@@ -68,6 +110,94 @@ namespace boitatah
     ///Base drawable
     typedef SceneTree<RenderObject>  RenderScene;
 
+    ///Vertex and index buffers of a Geometry, as bound by bind_vertexbuffers.
+    struct GeometryDrawData{
+        std::array<VkBuffer, VERTEX_BUFFER_TYPE_COUNT> buffers;
+        std::array<VkDeviceSize, VERTEX_BUFFER_TYPE_COUNT> offsets;
+        uint32_t bufferCount = 0;
+        bool indexed = false;
+        VkBuffer indexBuffer = VK_NULL_HANDLE;
+        VkDeviceSize indexOffset = 0;
+    };
+
+    ///One draw of a stage, resolved on the render thread.
+    /// Recording it touches only the command buffer, so chunks of these
+    /// are recorded in parallel into secondary buffers.
+    struct StageDrawItem{
+        MaterialDrawData material;
+        GeometryDrawData geometry;
+        glm::mat4 model;
+        VulkanWriterDraw draw;
+    };
+
+    ///A scene node as drawn by a frame snapshot.
+    struct SnapshotDraw{
+        Handle<Geometry> geometry;
+        Handle<Material> material;
+        glm::mat4 model;
+    };
+
+    ///Everything a frame reads from the scene, camera and lights,
+    /// copied out by submit_frame so the caller can change them while it renders.
+    struct FrameSnapshot{
+        std::vector<SnapshotDraw> draws;
+        CameraUniforms camera;
+        Handle<LightArray> lightArray;
+        std::vector<Light> lights;
+        //read on the main thread, a resize on the render thread uses it.
+        glm::ivec2 framebufferSize{0};
+    };
+
+    ///CPU time of the phases of the last rendered frame, in milliseconds.
+    ///     transforms:     global matrices of the scene tree.
+    ///     extract:        draws copied out of the scene tree.
+    ///     wait:           waiting for the gpu to finish the frame that last used the graph.
+    ///     prepare:        uploads, releases, defragmentation and pool resets.
+    ///     record:         recording and queueing the stages.
+    ///     present:        swapchain acquire, flushing the queues and present.
+    struct FrameTimings{
+        double transforms = 0.0;
+        double extract = 0.0;
+        double wait = 0.0;
+        double prepare = 0.0;
+        double record = 0.0;
+        double present = 0.0;
+    };
+
+    ///Work recorded for one stage or a whole frame.
+    ///     commands:       draws, instances, triangles, copy commands and the binds recorded or dropped,
+    ///                     by the pass, commit, upload and present writers.
+    ///     descriptorAllocations, descriptorWrites: sets allocated and descriptors written.
+    ///     uploadedBytes:  bytes copied from the host into buffers.
+    ///     batches:        command buffers queued to the submission list.
+    ///     culled:         draws of the stage left out, geometry still uploading or no pipeline.
+    struct RenderStats{
+        VulkanWriterStats commands;
+        uint64_t descriptorAllocations = 0;
+        uint64_t descriptorWrites = 0;
+        uint64_t uploadedBytes = 0;
+        uint64_t batches = 0;
+        uint32_t culled = 0;
+    };
+
+    ///name is the stage's description name, or "stage <index>" without one.
+    struct StageStats{
+        const char* name;
+        RenderStats stats;
+    };
+
+    ///Counters of the last rendered frame.
+    ///     total:          the whole frame, with uploads, defragmentation and present outside the stages.
+    ///     queueSubmits:   vkQueueSubmit calls.
+    ///     stagingBytes:   bytes reserved in transfer source buffers once the frame was queued.
+    ///     stages:         one per backbuffer stage, in rendering order.
+    struct FrameStats{
+        RenderStats total;
+        uint64_t queueSubmits = 0;
+        uint64_t stagingBytes = 0;
+        std::vector<StageStats> stages;
+    };
+
     //////////////////////////////////////////
     ///Renderer Class
     ///Provides render object management, GPU buffer management, Camera and Lights
@@ -95,6 +225,13 @@ namespace boitatah
         MaterialManager&        getMaterialManager();
         DescriptorSetManager&   getDescriptorManager();
         Materials&              getMaterials();
+        JobSystem&              getJobSystem();
+        ///Transient memory of the frame being rendered, released when the next one starts.
+        ///Only for the rendering thread, last_frame() counts the heap allocations it missed.
+        FrameArena&             getFrameArena();
+        ///Per frame gpu data, recycled once the frame that wrote it completes.
+        ///Only for the rendering thread, bound allocations are valid for the frame being rendered.
+        TransientRing&          getTransientRing();
 #pragma endregion Managers
 
         ///Creates an orthographic camera. with a dedicated GPUBuffer.
@@ -146,11 +283,53 @@ namespace boitatah
         ///Presents the results written to the present stage of the Backbuffer.
         /// TODO maybe template it to accept other types of SceneTree along a specific
         ///     SceneTree renderfunction.
+        ///Throws with RendererOptions::renderThread, use submit_frame there.
         ///@param scene the SceneTree to be rendered.
         ///@param camera the camera to use for the render
         void render_tree(std::shared_ptr<RenderScene>      scene,
                                           BufferedCamera    &camera);
 
+        ///Copies the scene, the camera and the attached LightArray into a FrameSnapshot
+        ///and renders it like render_tree.
+        ///With RendererOptions::renderThread the snapshot is rendered on the render thread,
+        ///this returns once it is published and the next frame can be simulated meanwhile.
+        ///The attached LightArray is uploaded from the snapshot, its update() is not needed.
+        ///@param scene the SceneTree to be rendered.
+        ///@param camera the camera to use for the render
+        void submit_frame(std::shared_ptr<RenderScene>      scene,
+                                           BufferedCamera   &camera);
+
+        ///Blocks until the render thread has rendered every submitted frame.
+        ///Managers are not thread safe, call this before creating, changing or
+        ///destroying resources, materials or cameras while the render thread runs.
+        void wait_render_thread();
+
+        ///Phase timings of the last frame.
+        ///With a render thread only read them after wait_render_thread().
+        const FrameTimings& getFrameTimings() const;
+
+        ///GPU time of each stage's commit batch, render pass and stage texture copies,
+        ///and of the present copy, named after the stages.
+        ///Read back without waiting, so they are a few frames behind the last one rendered.
+        ///Empty without RendererOptions::gpuProfiling or device support.
+        ///With a render thread only read them after wait_render_thread().
+        std::span<const GpuTiming> getGpuTimings() const;
+
+        ///Counters of the last frame rendered by render_tree or submit_frame.
+        ///With a render thread only read them after wait_render_thread().
+        const FrameStats& getFrameStats() const;
+
+        ///Device heaps, buffers, staging, images, descriptor pools and handle pools,
+        ///with the RendererOptions::memoryBudget limits exceeded right now.
+        ///Builds the report, meant for tools and debugging rather than every frame.
+        ///With a render thread only call it after wait_render_thread().
+        MemoryReport getMemoryReport();
+
+        ///Heap allocations of the last frame per profiler zone, most bytes first.
+        ///Empty unless built with BOITATAH_ALLOC_AUDIT, see AllocAudit.hpp.
+        ///With a render thread only read them after wait_render_thread().
+        std::span<const alloc_audit::ScopeAllocations> getFrameAllocations() const;
+
         ///Renders one RenderScene to one Stage of the BackBuffer.
         ///This function can be used to write renderloops.
         ///TODO maybe the render_tree function should be templatized 
@@ -159,19 +338,22 @@ namespace boitatah
         ///@param scene     the SceneTree to be rendered at this stage.
         ///@param camera    the camera
         ///@param stage     the renderstage to render to.
-        ///@param wait_for_last_stage a synchronization semaphore to be waited for.
-        ///@returns a synchronization semaphore, to be inputed for the next stage.
-        VkSemaphore render_graph_stage(std::shared_ptr<RenderScene>     scene, 
+        ///Waits for the last stage rendered with the current graph before recording,
+        ///its command buffers and descriptor sets are reused.
+        ///Throws with RendererOptions::renderThread.
+        ///@param wait_for_last_stage a timeline point to be waited for, null for none.
+        ///@returns the timeline point of the stage, to be inputed for the next stage.
+        TimelinePoint render_graph_stage(std::shared_ptr<RenderScene>     scene, 
                                                     BufferedCamera      &camera, 
                                                     Handle<RenderStage> stage,
-                                                    VkSemaphore         wait_for_last_stage);
+                                                    TimelinePoint       wait_for_last_stage);
 
         ///Presents the RenderTarget to the swapchain/window.
         ///@param rendertarget  the rendertarget to present
-        ///@param stage_wait    the seamphore to wait for.
+        ///@param stage_wait    the timeline point to wait for.
         ///@param attachment_index  the attachment to display.
         void present_rendertarget(Handle<RenderTarget>    &rendertarget,
-                                    VkSemaphore             stage_wait,
+                                    TimelinePoint           stage_wait,
                                     uint32_t                attachment_index);
         
         ///Binds the vertex buffers of a Geometry to the command buffer writer.
@@ -184,16 +366,51 @@ namespace boitatah
         void bind_vertexbuffers( uint32_t            frame_index, 
                                 Handle<Geometry>    geometry, 
                                 bool                indexed, 
-                                std::vector<VERTEX_BUFFER_TYPE> vertex_buffers,
+                                const std::vector<VERTEX_BUFFER_TYPE>& vertex_buffers,
                                 VkCommandBufferWriter           &writer);
 
+        ///Resolves the buffers bind_vertexbuffers would bind, committing pending uploads.
+        void resolve_vertexbuffers( uint32_t            frame_index, 
+                                    Handle<Geometry>    geometry, 
+                                    bool                indexed, 
+                                    const std::vector<VERTEX_BUFFER_TYPE>& vertex_buffers,
+                                    GeometryDrawData    &data);
+
     private:
         // Options Members
         RendererOptions m_options;
 
         // Base objects
+        std::unique_ptr<JobSystem> m_jobs;
         std::shared_ptr<BufferManager> m_bufferManager;
         std::shared_ptr<VkCommandBufferWriter> m_buffer_writer;
+        std::unique_ptr<VkCommandBufferWriter> m_presentWriter;
+        std::shared_ptr<VkSubmissionList> m_submissions;
+        //everything queued by the last frame of each backbuffer graph.
+        std::vector<TimelineFrontier> m_frameFrontiers;
+        FrameTimings m_frameTimings;
+        //window framebuffer size of the frame being rendered, see FrameSnapshot.
+        glm::ivec2 m_framebufferSize{0};
+        std::unique_ptr<GpuProfiler> m_gpuProfiler;
+        //gpu scope names of each stage, interned on first use.
+        struct StageScopeNames{
+            const char* stage;
+            const char* commit;
+            const char* pass;
+            const char* copy;
+        };
+        std::vector<StageScopeNames> m_stageScopeNames;
+        const StageScopeNames& stage_scope_names(const RenderStage& stage);
+        FrameStats m_frameStats;
+        //the last render_stage, render_frame keeps it in the frame's stages.
+        RenderStats m_lastStageStats;
+        //commands of the pass, record and present writers, the resource manager counts its own.
+        VulkanWriterStats m_writerStats;
+        //running totals of the managers and writers, frames and stages take the difference.
+        RenderStats running_stats() const;
+        //limits of the memory budget exceeded at the last check.
+        uint32_t m_budgetExceeded = 0;
+        void check_memory_budget();
         std::shared_ptr<Swapchain> m_swapchain;
         std::shared_ptr<BackBufferManager> m_backBufferManager;
         std::shared_ptr<GPUResourceManager> m_resourceManager;
@@ -204,12 +421,87 @@ namespace boitatah
         std::shared_ptr<ImageManager> m_imageManager;
         std::shared_ptr<RenderTargetManager> m_renderTargetManager;
         std::shared_ptr<Materials> m_baseMaterials;
+        std::unique_ptr<FrameArena> m_frameArena;
+        std::unique_ptr<TransientRing> m_transientRing;
 
         std::unique_ptr<Pool<LightArray>> m_lightpool;
 
         //TODO temp member
         Handle<LightArray> lights;
 
+        //draws of the stage being recorded, reused between stages.
+        std::vector<StageDrawItem> m_stageDraws;
+
+        //a secondary command pool per backbuffer graph,
+        //buffers are reset with the pool when the graph comes around again.
+        struct RecordPool{
+            VkCommandPool pool = VK_NULL_HANDLE;
+            std::vector<VkCommandBuffer> buffers;
+            uint32_t used = 0;
+        };
+        //each record thread owns its pools and writer bound state.
+        struct RecordWorker{
+            std::unique_ptr<VkCommandBufferWriter> writer;
+            std::vector<RecordPool> pools;
+        };
+        std::vector<RecordWorker> m_recordWorkers;
+        std::vector<VkCommandBuffer> m_secondaryBuffers;
+
+        //one level of the scene tree, reused between frames.
+        std::vector<RenderScene*> m_transformLevel;
+        std::vector<RenderScene*> m_transformNext;
+
+        //updates dirty global matrices a tree level at a time,
+        //parents are done before their children are read.
+        void update_transforms(RenderScene& scene);
+
+        //nodes of the scene being extracted, reused between frames.
+        std::vector<std::weak_ptr<RenderScene>> m_sceneNodes;
+        //draws of render_tree and render_graph_stage.
+        std::vector<SnapshotDraw> m_immediateDraws;
+        //submit_frame without a render thread.
+        FrameSnapshot m_immediateSnapshot;
+
+        std::unique_ptr<Mailbox<FrameSnapshot>> m_snapshots;
+        std::thread m_renderThread;
+        std::mutex m_renderErrorMutex;
+        std::exception_ptr m_renderError;
+
+        void extract_draws(RenderScene& scene, std::vector<SnapshotDraw>& draws);
+        void extract_snapshot(RenderScene& scene, BufferedCamera& camera, FrameSnapshot& snapshot);
+        void render_snapshot(const FrameSnapshot& snapshot);
+        void render_thread_loop();
+        //rethrows what stopped the render thread.
+        void rethrow_render_error();
+
+        //camera uniforms of a stage, a transient allocation when buffer is null.
+        struct StageCamera{
+            Handle<GPUBuffer> buffer{};
+            BufferAccessData transient{};
+        };
+
+        //the frame loop of render_tree, for draws already extracted.
+        void render_frame(std::span<const SnapshotDraw> draws, const CameraUniforms& camera);
+        TimelinePoint render_stage(std::span<const SnapshotDraw> draws,
+                                   const StageCamera&            camera,
+                                   Handle<RenderStage>           stage,
+                                   TimelinePoint                 wait_for_last_stage);
+
+        //returns the draws of the stage left out.
+        uint32_t gather_stage_draws(std::span<const SnapshotDraw> nodes,
+                                    uint32_t stage_index,
+                                    uint32_t frame_index);
+        static void record_draws(VkCommandBufferWriter& writer,
+                                 std::span<StageDrawItem> draws);
+        //chunks of one stage's draws, adapted to the draw count.
+        uint32_t record_chunk_count(std::size_t draws) const;
+        void record_draws_parallel(VkCommandBufferWriter& writer,
+                                   const VulkanWriterBegin& inheritance,
+                                   uint32_t graph_index,
+                                   uint32_t chunks);
+        VkCommandBuffer acquire_secondary(RecordWorker& worker, uint32_t graph_index);
+        void reset_record_pools(uint32_t graph_index);
+
         void handleWindowResize();
         void createSwapchain();
 
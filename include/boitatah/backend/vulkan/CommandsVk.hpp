@@ -1,5 +1,6 @@
 #pragma once
 
+#include <span>
 #include <vulkan/vulkan.h>
 #include <glm/glm.hpp>
 
@@ -8,7 +9,7 @@ namespace boitatah::vk
     struct PresentCommandVk
     {
         //VkCommandBuffer commandBuffer;
-        std::vector<VkSemaphore> waitSemaphores;
+        std::span<const VkSemaphore> waitSemaphores;
         VkFence fence;
     };
 
@@ -60,8 +61,8 @@ namespace boitatah::vk
     struct CopyToBufferVk
     {
         VkDeviceMemory memory;
-        uint32_t offset;
-        uint32_t size;
+        VkDeviceSize offset;
+        VkDeviceSize size;
         void *data;
     };
 
@@ -69,10 +70,10 @@ namespace boitatah::vk
     {
         VkCommandBuffer commandBuffer;
         VkBuffer srcBuffer;
-        uint32_t srcOffset;
+        VkDeviceSize srcOffset;
         VkBuffer dstBuffer;
-        uint32_t dstOffset;
-        uint32_t size;
+        VkDeviceSize dstOffset;
+        VkDeviceSize size;
     };
 
     struct CopyImageCommandVk
@@ -127,8 +128,8 @@ namespace boitatah::vk
     // sizes and offsets in bytes
     struct CopyMappedMemoryVk
     {
-        uint32_t offset;
-        uint32_t elementSize;
+        VkDeviceSize offset;
+        VkDeviceSize elementSize;
         uint32_t elementCount;
         void *map;
         void *data;
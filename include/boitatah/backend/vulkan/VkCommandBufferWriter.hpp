@@ -1,9 +1,14 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <memory>
+#include <span>
+#include <stdexcept>
 #include <vulkan/vulkan.h>
 
 #include <boitatah/backend/vulkan/Vulkan.hpp>
+#include <boitatah/backend/vulkan/VkSubmissionList.hpp>
 
 #include <boitatah/backend/vulkan/VkCommandBufferWriterStructs.hpp>
 #include <boitatah/commands/CommandBufferWriter.hpp>
@@ -25,8 +30,67 @@ namespace boitatah::vk{
                         m_fence  = VK_NULL_HANDLE;
                     };
 
+            static constexpr uint32_t MAX_VERTEX_BINDINGS = 16;
+            static constexpr uint32_t MAX_BOUND_SETS = 8;
+
+            static constexpr uint32_t MAX_TIMELINE_WAITS = 4;
+            static constexpr uint32_t MAX_CLEAR_VALUES = 16;
+
+            //submits go to the list instead of the queue,
+            //the writer fence is then replaced by the queue timeline.
+            void set_submission_list(std::shared_ptr<VkSubmissionList> list){
+                m_submissionList = list;
+            }
+
+            //the next submit waits for the point, cleared after submitting.
+            void add_timeline_wait(const TimelinePoint& point){
+                if(m_timelineWaitCount == MAX_TIMELINE_WAITS)
+                    throw std::runtime_error("too many timeline waits on submit");
+                m_timelineWaits[m_timelineWaitCount++] = point;
+            }
+
+            //timeline value signaled by the last submit.
+            TimelinePoint get_timeline_point() const {
+                return m_submitPoint;
+            }
+
+            //id of the batch being recorded, set by the owner of the writer.
+            void set_batch_id(uint64_t batch){
+                m_batchId = batch;
+            }
+
+            uint64_t get_batch_id() const {
+                return m_batchId;
+            }
+
         private:
             std::weak_ptr<VulkanInstance> vk_instance;
+
+            std::shared_ptr<VkSubmissionList>               m_submissionList;
+            TimelinePoint                                   m_submitPoint;
+            std::array<TimelinePoint, MAX_TIMELINE_WAITS>   m_timelineWaits;
+            uint32_t                                        m_timelineWaitCount = 0;
+            uint64_t                                        m_batchId = 0;
+
+            // state bound on m_buffer, to drop binds that change nothing.
+            VkPipeline                                          m_boundPipeline = VK_NULL_HANDLE;
+            std::array<VkPipelineLayout, MAX_BOUND_SETS>        m_boundSetLayouts{};
+            std::array<VkDescriptorSet, MAX_BOUND_SETS>         m_boundSets{};
+            std::array<VkBuffer, MAX_VERTEX_BINDINGS>           m_boundVertexBuffers{};
+            std::array<VkDeviceSize, MAX_VERTEX_BINDINGS>       m_boundVertexOffsets{};
+            VkBuffer                                            m_boundIndexBuffer = VK_NULL_HANDLE;
+            VkDeviceSize                                        m_boundIndexOffset = 0;
+            VulkanWriterStats                                   m_stats;
+
+            void clear_bound_state(){
+                m_boundPipeline = VK_NULL_HANDLE;
+                m_boundSetLayouts.fill(VK_NULL_HANDLE);
+                m_boundSets.fill(VK_NULL_HANDLE);
+                m_boundVertexBuffers.fill(VK_NULL_HANDLE);
+                m_boundVertexOffsets.fill(0);
+                m_boundIndexBuffer = VK_NULL_HANDLE;
+                m_boundIndexOffset = 0;
+            }
             // CommandWriterTraits<VkCommandBufferWriter>::CommandBufferType& unwrapCommandBuffer(){
             //     return bufferWrapper.unwrap();
             // };
@@ -34,20 +98,44 @@ namespace boitatah::vk{
             void __imp_begin(const VulkanWriterBegin &command,
                                    VkCommandBuffer buffer) {
                     //auto buffer = wrappedBuffer;//unwrapCommandBuffer();
+                    clear_bound_state();
+
+                    VkCommandBufferInheritanceInfo inheritance{
+                        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+                        .renderPass = command.pass,
+                        .subpass = 0,
+                        .framebuffer = command.frame_buffer,
+                    };
+                    bool continues_pass = command.pass != VK_NULL_HANDLE;
 
                     VkCommandBufferBeginInfo beginInfo{
                         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
                         .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
                         .pInheritanceInfo = nullptr};
+                    if(continues_pass){
+                        beginInfo.flags |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+                        beginInfo.pInheritanceInfo = &inheritance;
+                    }
                     if (vkBeginCommandBuffer(buffer,&beginInfo) != VK_SUCCESS)
                     {
                         throw std::runtime_error("failed to initialize buffer");
                     }
+
+                    //dynamic state is not inherited from the primary.
+                    if(continues_pass)
+                        set_viewport_scissor(buffer, command.scissorDims, {0, 0});
+            };
+
+            void __imp_end(const VulkanWriterEnd &command,
+                                 VkCommandBuffer buffer) {
+                if (vkEndCommandBuffer(buffer) != VK_SUCCESS)
+                    throw std::runtime_error("failed to record buffer");
             };
 
             void __imp_reset(const VulkanWriterReset &command,
                                    VkCommandBuffer buffer) {
                 vkResetCommandBuffer(buffer, 0);
+                clear_bound_state();
             };
 
             void __imp_copy_buffer(const VulkanWriterCopyBuffer& command,
@@ -56,6 +144,7 @@ namespace boitatah::vk{
                         .srcOffset = command.srcOffset,
                         .dstOffset = command.dstOffset,
                         .size = command.size};
+                    m_stats.copies++;
                     vkCmdCopyBuffer(buffer,
                                     command.srcBuffer,
                                     command.dstBuffer,
@@ -68,58 +157,67 @@ namespace boitatah::vk{
                 
                 auto vk = std::shared_ptr<VulkanInstance>(vk_instance);
                 vkEndCommandBuffer(buffer);
-                
-                // if(m_fence != VK_NULL_HANDLE)
-                //     vkResetFences(vk->getDevice(), 1, &m_fence);
-                    
-                VkSubmitInfo submit{
-                    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-                    .commandBufferCount = 1,
-                    .pCommandBuffers = &buffer,
-                };
 
-                std::vector<VkPipelineStageFlags> stages{};
-
-                VkQueue queue;
+                VkQueue queue = VK_NULL_HANDLE;
+                VkPipelineStageFlags wait_stage = 0;
                 if (command.submitType == COMMAND_BUFFER_TYPE::TRANSFER)
                 {
                     queue = vk->get_transfer_queue();
-                    
-                    stages.push_back(VK_PIPELINE_STAGE_TRANSFER_BIT);
-                    for(int i = 0; i < m_wait.size(); i++)
-                        stages.push_back(VK_PIPELINE_STAGE_TRANSFER_BIT);
-                    submit.pWaitDstStageMask = stages.data();
+                    wait_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
                 }
                 
+                //graphics queue batches also record copies.
                 if (command.submitType == COMMAND_BUFFER_TYPE::GRAPHICS)
                 {
                     queue = vk->get_graphics_queue();
-                    
-                    for(int i = 0; i < m_wait.size(); i++)
-                        stages.push_back(VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT);
-                    submit.pWaitDstStageMask = stages.data();
+                    wait_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
                 }
 
-                if(m_wait.size() != 0){
-                    submit.waitSemaphoreCount = static_cast<uint32_t>(m_wait.size());
-                    submit.pWaitSemaphores = self().m_wait.data();
-                }
-
-                if (m_signal != VK_NULL_HANDLE && command.signal)
-                {
-                    submit.signalSemaphoreCount = 1;
-                    submit.pSignalSemaphores = &(self().m_signal);
+                std::array<VkPipelineStageFlags, 8> stages;
+                if(m_wait.size() > stages.size())
+                    throw std::runtime_error("too many wait semaphores on submit");
+                stages.fill(wait_stage);
+
+                uint32_t signal_count = (m_signal != VK_NULL_HANDLE && command.signal) ? 1 : 0;
+
+                if(m_submissionList){
+                    m_submitPoint = m_submissionList->enqueue(queue, buffer,
+                                                std::span(m_wait),
+                                                std::span(stages.data(), m_wait.size()),
+                                                std::span(m_timelineWaits.data(), m_timelineWaitCount),
+                                                std::span(stages.data(), m_timelineWaitCount),
+                                                std::span(&m_signal, signal_count));
+                    m_timelineWaitCount = 0;
+                    return;
                 }
+                    
+                VkSubmitInfo submit{
+                    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                    .waitSemaphoreCount = static_cast<uint32_t>(m_wait.size()),
+                    .pWaitSemaphores = m_wait.data(),
+                    .pWaitDstStageMask = stages.data(),
+                    .commandBufferCount = 1,
+                    .pCommandBuffers = &buffer,
+                    .signalSemaphoreCount = signal_count,
+                    .pSignalSemaphores = &m_signal,
+                };
 
                 vkQueueSubmit(queue, 1, &submit, m_fence);
             };
 
             bool __imp_check_transfers(){
+                if(m_submissionList)
+                    return m_submissionList->is_complete(m_submitPoint);
+
                 auto vk = std::shared_ptr<VulkanInstance>(vk_instance);
                 return vk->check_fence_status(m_fence);
             };
 
             void __imp_wait_for_transfers(){
+                if(m_submissionList){
+                    m_submissionList->wait(m_submitPoint);
+                    return;
+                }
                 if(m_fence == VK_NULL_HANDLE) return;
 
                 auto vk = std::shared_ptr<VulkanInstance>(vk_instance);
@@ -152,6 +250,9 @@ namespace boitatah::vk{
                     case VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT:
                         dstAccess = 0;
                         break;
+                    case VK_PIPELINE_STAGE_ALL_COMMANDS_BIT:
+                        dstAccess = VK_ACCESS_MEMORY_READ_BIT;
+                        break;
                     default: dstAccess = 0; break;
                 }
 
@@ -162,8 +263,8 @@ namespace boitatah::vk{
                     .dstAccessMask = dstAccess,
                     .oldLayout = command.src,
                     .newLayout = command.dst,
-                    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .srcQueueFamilyIndex = command.srcQueueFamily,
+                    .dstQueueFamilyIndex = command.dstQueueFamily,
                     .image = command.image,
                     .subresourceRange = {
                         .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
@@ -190,6 +291,29 @@ namespace boitatah::vk{
 
             }
 
+            void __imp_buffer_barrier(const VulkanWriterBufferBarrier &command,
+                                            VkCommandBuffer buffer) {
+                VkBufferMemoryBarrier barrier{
+                    .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                    .srcAccessMask = command.srcAccess,
+                    .dstAccessMask = command.dstAccess,
+                    .srcQueueFamilyIndex = command.srcQueueFamily,
+                    .dstQueueFamilyIndex = command.dstQueueFamily,
+                    .buffer = command.buffer,
+                    .offset = command.offset,
+                    .size = command.size,
+                };
+
+                vkCmdPipelineBarrier(
+                    buffer,
+                    command.srcStage,
+                    command.dstStage,
+                    0,
+                    0, nullptr,
+                    1, &barrier,
+                    0, nullptr);
+            }
+
             void __imp_copy_image(const VulkanWriterCopyImage &command,
                                         VkCommandBuffer buffer) {
 
@@ -238,6 +362,7 @@ namespace boitatah::vk{
                 }, buffer);
 
                 //copy
+                m_stats.copies++;
                 vkCmdCopyImage(buffer,
                             command.srcImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
                             command.dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
@@ -293,6 +418,7 @@ namespace boitatah::vk{
                                     command.extent.y, 
                                     command.extent.z};
 
+                m_stats.copies++;
                 vkCmdCopyBufferToImage(
                     commandBuffer,
                     command.buffer,
@@ -308,26 +434,61 @@ namespace boitatah::vk{
                     .image = command.image,                    
                     .srcStage = VK_PIPELINE_STAGE_TRANSFER_BIT,
                     .dstStage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                    .srcQueueFamily = command.srcQueueFamily,
+                    .dstQueueFamily = command.dstQueueFamily,
                 }, commandBuffer);
 
         }
 
         void __imp_begin_renderpass(const VulkanWriterBeginRenderpass &command,
                                      VkCommandBuffer command_buffer){
-            std::vector<VkClearValue> clear_colors;
-            for(auto& clear_color : command.clearColors){
-                VkClearValue cc;
-                cc.color = {{clear_color.x,
-                            clear_color.y,
-                            clear_color.z,
-                            clear_color.w}};
-                clear_colors.push_back(cc);
+            if(command.clearColors.size() > MAX_CLEAR_VALUES)
+                throw std::runtime_error("too many clear values for render pass");
+
+            std::array<VkClearValue, MAX_CLEAR_VALUES> clear_colors;
+            for(uint32_t i = 0; i < command.clearColors.size(); i++){
+                auto& clear_color = command.clearColors[i];
+                clear_colors[i].color = {{clear_color.x,
+                                          clear_color.y,
+                                          clear_color.z,
+                                          clear_color.w}};
             }
 
+            VkRect2D scissor = set_viewport_scissor(command_buffer,
+                                                    command.scissorDims,
+                                                    command.scissorOffset);
+
+            VkRenderPassBeginInfo passInfo{
+                .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+                .renderPass = command.pass,
+                .framebuffer = command.frame_buffer,
+                .renderArea = scissor,
+                .clearValueCount = static_cast<uint32_t>(command.clearColors.size()),
+                .pClearValues = clear_colors.data(),
+            };
+            vkCmdBeginRenderPass(command_buffer, &passInfo,
+                                 command.secondary ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+                                                   : VK_SUBPASS_CONTENTS_INLINE);
+        }
+
+        void __imp_execute_commands(const VulkanWriterExecuteCommands &command,
+                                          VkCommandBuffer &command_buffer){
+            if(command.buffers.empty())
+                return;
+            vkCmdExecuteCommands(command_buffer,
+                                 static_cast<uint32_t>(command.buffers.size()),
+                                 command.buffers.data());
+            //the secondaries leave their own state bound.
+            clear_bound_state();
+        }
+
+        VkRect2D set_viewport_scissor(VkCommandBuffer command_buffer,
+                                      glm::ivec2 dims,
+                                      glm::ivec2 offset){
             VkRect2D scissor = {
-                .offset = {command.scissorOffset.x, command.scissorOffset.y},
-                .extent = {.width = static_cast<uint32_t>(command.scissorDims.x),
-                        .height = static_cast<uint32_t>(command.scissorDims.y)},
+                .offset = {offset.x, offset.y},
+                .extent = {.width = static_cast<uint32_t>(dims.x),
+                        .height = static_cast<uint32_t>(dims.y)},
             };
             VkViewport viewport{
                 .x = 0.0f,
@@ -339,16 +500,7 @@ namespace boitatah::vk{
             };
             vkCmdSetViewport(command_buffer, 0, 1, &viewport);
             vkCmdSetScissor(command_buffer, 0, 1, &scissor);
-
-            VkRenderPassBeginInfo passInfo{
-                .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-                .renderPass = command.pass,
-                .framebuffer = command.frame_buffer,
-                .renderArea = scissor,
-                .clearValueCount = static_cast<uint32_t>(clear_colors.size()),
-                .pClearValues = clear_colors.data(),
-            };
-            vkCmdBeginRenderPass(command_buffer, &passInfo, VK_SUBPASS_CONTENTS_INLINE);
+            return scissor;
         }
 
         void __imp_end_renderpass(const VulkanWriterEndRenderpass &command,
@@ -358,15 +510,50 @@ namespace boitatah::vk{
 
         void __imp_bind_vertexbuffer(const VulkanWriterBindVertexBuffer &command,
                                            VkCommandBuffer    &command_buffer){
+            uint32_t count = static_cast<uint32_t>(command.buffers.size());
+            
+            //only rebind the range of slots that changed.
+            uint32_t first = count;
+            uint32_t last = 0;
+            for(uint32_t i = 0; i < count; i++){
+                uint32_t slot = command.first_binding + i;
+                if(slot < MAX_VERTEX_BINDINGS &&
+                   m_boundVertexBuffers[slot] == command.buffers[i] &&
+                   m_boundVertexOffsets[slot] == command.offsets[i])
+                    continue;
+                first = std::min(first, i);
+                last = i;
+                if(slot < MAX_VERTEX_BINDINGS){
+                    m_boundVertexBuffers[slot] = command.buffers[i];
+                    m_boundVertexOffsets[slot] = command.offsets[i];
+                }
+            }
+
+            if(first == count){
+                m_stats.skippedVertexBuffers += count;
+                return;
+            }
+
+            uint32_t bound = last - first + 1;
+            m_stats.vertexBuffers += bound;
+            m_stats.skippedVertexBuffers += count - bound;
             vkCmdBindVertexBuffers(command_buffer, 
-                                0, 
-                                static_cast<uint32_t>(command.buffers.size()), 
-                                command.buffers.data(), 
-                                command.offsets.data());
+                                command.first_binding + first, 
+                                bound, 
+                                command.buffers.data() + first, 
+                                command.offsets.data() + first);
         };
 
         void __imp_bind_indexbuffer(const VulkanWriterBindIndexBuffer &command,
                                           VkCommandBuffer &command_buffer){
+            if(m_boundIndexBuffer == command.buffers && m_boundIndexOffset == command.offsets){
+                m_stats.skippedIndexBuffers++;
+                return;
+            }
+            m_boundIndexBuffer = command.buffers;
+            m_boundIndexOffset = command.offsets;
+            m_stats.indexBuffers++;
+
             vkCmdBindIndexBuffer(command_buffer,
                                 command.buffers,
                                 command.offsets,
@@ -375,6 +562,13 @@ namespace boitatah::vk{
 
         void __imp_bind_pipeline(const VulkanWriterBindPipeline &command,
                                        VkCommandBuffer &command_buffer){
+            if(m_boundPipeline == command.pipeline){
+                m_stats.skippedPipelines++;
+                return;
+            }
+            m_boundPipeline = command.pipeline;
+            m_stats.pipelines++;
+
             vkCmdBindPipeline(command_buffer,
                               VK_PIPELINE_BIND_POINT_GRAPHICS,
                               command.pipeline);
@@ -382,14 +576,51 @@ namespace boitatah::vk{
 
         void __imp_bind_set(const VulkanWriterBindSet &command,
                                   VkCommandBuffer &command_buffer){
+            //a different layout may have disturbed the set, so it has to match too.
+            if(command.set_index < MAX_BOUND_SETS &&
+               m_boundSets[command.set_index] == command.set &&
+               m_boundSetLayouts[command.set_index] == command.layout){
+                m_stats.skippedSets++;
+                return;
+            }
+            //compatibility between layouts isn't known here, a bind with another layout
+            //is taken to disturb every set above it and every set bound with another layout.
+            if(command.set_index >= MAX_BOUND_SETS ||
+               m_boundSetLayouts[command.set_index] != command.layout){
+                for(uint32_t i = 0; i < MAX_BOUND_SETS; i++){
+                    if(i > command.set_index || m_boundSetLayouts[i] != command.layout){
+                        m_boundSets[i] = VK_NULL_HANDLE;
+                        m_boundSetLayouts[i] = VK_NULL_HANDLE;
+                    }
+                }
+            }
+            if(command.set_index < MAX_BOUND_SETS){
+                m_boundSets[command.set_index] = command.set;
+                m_boundSetLayouts[command.set_index] = command.layout;
+            }
+            m_stats.sets++;
+
             vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
                                     command.layout, command.set_index,
                                     1, &(command.set),
                                     0, nullptr);
         }
 
+        const VulkanWriterStats& __imp_get_stats(){
+            return m_stats;
+        }
+
+        void __imp_reset_stats(){
+            m_stats = {};
+        }
+
         void __imp_draw(const VulkanWriterDraw &command,
                               VkCommandBuffer &command_buffer){
+            m_stats.draws++;
+            m_stats.instances += command.instaceCount;
+            m_stats.triangles += static_cast<uint64_t>(command.indexed ? command.indexCount
+                                                                        : command.vertexCount) / 3
+                                 * command.instaceCount;
             
             if(command.indexed){
                 vkCmdDrawIndexed(command_buffer, command.indexCount,
@@ -420,6 +651,11 @@ namespace boitatah::vk{
             }
 
         }
+
+        void __imp_write_timestamp(const VulkanWriterTimestamp &command,
+                                         VkCommandBuffer &command_buffer){
+            vkCmdWriteTimestamp(command_buffer, command.stage, command.pool, command.query);
+        }
     };
 };
 
@@ -4,13 +4,19 @@
 #include <boitatah/commands/CommandBufferWriterStructs.hpp>
 #include <boitatah/BoitatahEnums.hpp>
 #include <vector>
+#include <span>
 #include <glm/glm.hpp>
 #include <glm/gtx/compatibility.hpp>
 
 namespace boitatah::vk{
 
     class VkCommandBufferWriter;
-    struct VulkanWriterBegin {} ;
+    //secondary buffers recorded inside a render pass set the pass they continue.
+    struct VulkanWriterBegin {
+        VkRenderPass pass = VK_NULL_HANDLE;
+        VkFramebuffer frame_buffer = VK_NULL_HANDLE;
+        glm::ivec2 scissorDims = {0, 0};
+    } ;
 
 
     struct VulkanWriterReset {} ;
@@ -52,21 +58,37 @@ namespace boitatah::vk{
         VkImage image;
         VkPipelineStageFlags srcStage;
         VkPipelineStageFlags dstStage;
+        //set both for a queue family ownership release or acquire.
+        uint32_t srcQueueFamily = VK_QUEUE_FAMILY_IGNORED;
+        uint32_t dstQueueFamily = VK_QUEUE_FAMILY_IGNORED;
     };
 
     struct VulkanWriterCopyBuffer {
         VkBuffer srcBuffer;
-        uint32_t srcOffset;
+        VkDeviceSize srcOffset;
         VkBuffer dstBuffer;
-        uint32_t dstOffset;
-        uint32_t size;
+        VkDeviceSize dstOffset;
+        VkDeviceSize size;
+    };
+
+    //buffer range barrier, moves ownership when the families differ.
+    struct VulkanWriterBufferBarrier {
+        VkBuffer buffer;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = VK_WHOLE_SIZE;
+        uint32_t srcQueueFamily = VK_QUEUE_FAMILY_IGNORED;
+        uint32_t dstQueueFamily = VK_QUEUE_FAMILY_IGNORED;
+        VkPipelineStageFlags srcStage;
+        VkPipelineStageFlags dstStage;
+        VkAccessFlags srcAccess;
+        VkAccessFlags dstAccess;
     };
 
     struct VulkanWriterCopyBufferToImage {
         VkBuffer buffer;
         VkImage image;
 
-        uint32_t buffOffset;
+        VkDeviceSize buffOffset;
         //uint32_t buffRow;   //in case of padding
         //uint32_t buffHeight;//in case of padding
 
@@ -80,24 +102,36 @@ namespace boitatah::vk{
 
         VkImageLayout srcImgLayout;
         VkImageLayout dstImgLayout;
+        //the transition to dstImgLayout releases the image to dstQueueFamily.
+        uint32_t srcQueueFamily = VK_QUEUE_FAMILY_IGNORED;
+        uint32_t dstQueueFamily = VK_QUEUE_FAMILY_IGNORED;
     };
 
     struct VulkanWriterBeginRenderpass {
         VkRenderPass pass;
         VkFramebuffer frame_buffer;
 
-        std::vector<glm::vec4> clearColors;
+        // one per attachment, spans over caller storage.
+        std::span<const glm::vec4> clearColors;
 
         glm::ivec2 scissorDims;
         glm::ivec2 scissorOffset;
 
         bool depth = false;
         uint32_t attachment_count = 1;
+        //the pass content comes from execute_commands.
+        bool secondary = false;
     };
 
+    struct VulkanWriterExecuteCommands {
+        std::span<const VkCommandBuffer> buffers;
+    };
+
+    // spans over caller storage, binds buffers[i] to first_binding + i.
     struct VulkanWriterBindVertexBuffer {
-        std::vector<VkBuffer> buffers;
-        std::vector<VkDeviceSize> offsets;
+        std::span<const VkBuffer> buffers;
+        std::span<const VkDeviceSize> offsets;
+        uint32_t first_binding = 0;
     };
 
     struct VulkanWriterBindIndexBuffer {
@@ -118,9 +152,72 @@ namespace boitatah::vk{
         VkShaderStageFlags stages;
     };
     
+    // spans over caller storage.
     struct VulkanPushConstants{
         VkPipelineLayout layout;
-        std::vector<VulkanPushConstant> push_constants;
+        std::span<const VulkanPushConstant> push_constants;
+    };
+
+    //writes the gpu clock once the commands before it reach stage.
+    struct VulkanWriterTimestamp {
+        VkQueryPool pool;
+        uint32_t query;
+        VkPipelineStageFlagBits stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    };
+
+    // commands recorded, and binds dropped because the state was already bound.
+    // vertex buffers count per binding slot, triangles assume triangle lists.
+    struct VulkanWriterStats{
+        uint32_t draws = 0;
+        uint32_t instances = 0;
+        uint64_t triangles = 0;
+        uint32_t copies = 0;
+
+        uint32_t pipelines = 0;
+        uint32_t sets = 0;
+        uint32_t vertexBuffers = 0;
+        uint32_t indexBuffers = 0;
+
+        uint32_t skippedPipelines = 0;
+        uint32_t skippedSets = 0;
+        uint32_t skippedVertexBuffers = 0;
+        uint32_t skippedIndexBuffers = 0;
+
+        uint32_t skipped() const {
+            return skippedPipelines + skippedSets + skippedVertexBuffers + skippedIndexBuffers;
+        }
+
+        VulkanWriterStats& operator+=(const VulkanWriterStats& other){
+            draws += other.draws;
+            instances += other.instances;
+            triangles += other.triangles;
+            copies += other.copies;
+            pipelines += other.pipelines;
+            sets += other.sets;
+            vertexBuffers += other.vertexBuffers;
+            indexBuffers += other.indexBuffers;
+            skippedPipelines += other.skippedPipelines;
+            skippedSets += other.skippedSets;
+            skippedVertexBuffers += other.skippedVertexBuffers;
+            skippedIndexBuffers += other.skippedIndexBuffers;
+            return *this;
+        }
+
+        VulkanWriterStats& operator-=(const VulkanWriterStats& other){
+            draws -= other.draws;
+            instances -= other.instances;
+            triangles -= other.triangles;
+            copies -= other.copies;
+            pipelines -= other.pipelines;
+            sets -= other.sets;
+            vertexBuffers -= other.vertexBuffers;
+            indexBuffers -= other.indexBuffers;
+            skippedPipelines -= other.skippedPipelines;
+            skippedSets -= other.skippedSets;
+            skippedVertexBuffers -= other.skippedVertexBuffers;
+            skippedIndexBuffers -= other.skippedIndexBuffers;
+            return *this;
+        }
     };
 
 };
@@ -150,8 +247,13 @@ namespace boitatah::command_buffers{
             using CopyBufferCommand = boitatah::vk::VulkanWriterCopyBuffer;
             using TransitionLayoutCommand = boitatah::vk::VulkanWriterTransitionLayout;
             using CopyBufferToImageCommand = boitatah::vk::VulkanWriterCopyBufferToImage;
+            using BufferBarrierCommand = boitatah::vk::VulkanWriterBufferBarrier;
+            using ExecuteCommandsCommand = boitatah::vk::VulkanWriterExecuteCommands;
 
             using PushConstantsCommand = boitatah::vk::VulkanPushConstants;
+            using WriteTimestampCommand = boitatah::vk::VulkanWriterTimestamp;
+
+            using Stats = boitatah::vk::VulkanWriterStats;
 
             using CommandBufferType = VkCommandBuffer;
             using SemaphoreType = VkSemaphore;
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include <boitatah/backend/vulkan/Vulkan.hpp>
+
+namespace boitatah::vk{
+
+    constexpr uint32_t MAX_SUBMISSION_QUEUES = 3;
+
+    ///A value on a queue's timeline, reached when the batch that signals it completes.
+    /// value 0 is never signaled by a batch and is always complete.
+    struct TimelinePoint{
+        uint32_t queue = 0;
+        uint64_t value = 0;
+    };
+
+    ///The last value queued on every timeline,
+    /// complete once everything queued before it is.
+    struct TimelineFrontier{
+        std::array<uint64_t, MAX_SUBMISSION_QUEUES> values{};
+    };
+
+    ///Collects the queue submissions of a frame and flushes them together.
+    /// Every queue owns a timeline semaphore, each batch signals its next value.
+    /// Each queue gets one vkQueueSubmit with one batch per submission,
+    /// split only where a binary semaphore wait needs its signal
+    /// to be submitted on another queue first.
+    class VkSubmissionList{
+        public:
+            VkSubmissionList(std::shared_ptr<VulkanInstance> vk_instance);
+            ~VkSubmissionList();
+
+            //Queues a batch. Stages have one entry per wait.
+            //returns the timeline value the batch signals.
+            TimelinePoint enqueue(VkQueue                               queue,
+                                  VkCommandBuffer                       buffer,
+                                  std::span<const VkSemaphore>          binary_waits,
+                                  std::span<const VkPipelineStageFlags> binary_stages,
+                                  std::span<const TimelinePoint>        timeline_waits,
+                                  std::span<const VkPipelineStageFlags> timeline_stages,
+                                  std::span<const VkSemaphore>          binary_signals);
+
+            //Submits everything queued.
+            void flush();
+
+            //value >= point checks, without a host wait.
+            bool is_complete(const TimelinePoint& point);
+            bool is_complete(const TimelineFrontier& frontier);
+
+            //flushes first if the point is still queued.
+            void wait(const TimelinePoint& point);
+            void wait(const TimelineFrontier& frontier);
+
+            TimelineFrontier frontier() const;
+
+            bool empty() const;
+
+            //vkQueueSubmit calls made by the last flush.
+            uint32_t get_last_submit_count() const;
+            //vkQueueSubmit calls and batches queued since creation.
+            uint64_t get_submit_count() const;
+            uint64_t get_batch_count() const;
+
+        private:
+            struct Timeline{
+                VkQueue     queue = VK_NULL_HANDLE;
+                VkSemaphore semaphore = VK_NULL_HANDLE;
+                uint64_t    enqueued = 0;
+                uint64_t    submitted = 0;
+                uint64_t    completed = 0;
+            };
+
+            struct Submission{
+                uint32_t        timeline;
+                VkCommandBuffer buffer;
+                uint32_t        wait_begin;
+                uint32_t        wait_count;
+                uint32_t        signal_begin;
+                uint32_t        signal_count;
+                uint32_t        call;
+            };
+
+            struct Call{
+                uint32_t timeline;
+                bool     open;
+            };
+
+            std::shared_ptr<VulkanInstance> m_vk;
+
+            std::array<Timeline, MAX_SUBMISSION_QUEUES> m_timelines;
+            uint32_t m_timelineCount = 0;
+
+            //waits then signals of every submission,
+            //binary semaphores have value 0.
+            std::vector<Submission>             m_submissions;
+            std::vector<VkSemaphore>            m_semaphores;
+            std::vector<uint64_t>               m_values;
+            std::vector<VkPipelineStageFlags>   m_stages;
+
+            //scratch reused between flushes.
+            std::vector<Call>                           m_calls;
+            std::vector<uint32_t>                       m_callOrder;
+            std::vector<VkSubmitInfo>                   m_submitInfos;
+            std::vector<VkTimelineSemaphoreSubmitInfo>  m_timelineInfos;
+
+            uint32_t m_lastSubmitCount = 0;
+            uint64_t m_totalSubmits = 0;
+            uint64_t m_totalBatches = 0;
+
+            uint32_t timeline_index(VkQueue queue);
+            void close_call(uint32_t call);
+            void submit_call(uint32_t call);
+    };
+}
@@ -4,9 +4,12 @@
 #define GLFW_INCLUDE_VULKAN
 
 #include <GLFW/glfw3.h>
+#include <array>
 #include <cstring>
 #include <optional>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <vulkan/vulkan.h>
 #include <vector>
 
@@ -25,6 +28,20 @@
 namespace boitatah::vk
 {
     class WindowManager;
+
+    ///Device memory of a heap.
+    ///     allocated, allocations: VkDeviceMemory this instance holds on the heap.
+    ///     budget, usage:          the driver's figures for the whole process,
+    ///                             0 without VK_EXT_memory_budget.
+    struct MemoryHeapUsage{
+        VkDeviceSize size = 0;
+        bool deviceLocal = false;
+        VkDeviceSize allocated = 0;
+        uint32_t allocations = 0;
+        VkDeviceSize budget = 0;
+        VkDeviceSize usage = 0;
+    };
+    using MemoryHeaps = std::array<MemoryHeapUsage, VK_MAX_MEMORY_HEAPS>;
     
     ///Vulkan Instance.
     /// Manages the Vulkan base structures, and logical device.
@@ -49,6 +66,10 @@ namespace boitatah::vk
             VkInstance get_instance() const;
             VkDevice get_device() const;
             VkPhysicalDevice get_physical_device() const;
+            const VkPhysicalDeviceLimits& get_device_limits() const;
+            //largest single buffer of a memory type, bound by maxMemoryAllocationSize
+            //and by a quarter of the largest matching heap, never under 128 MiB if that heap fits it.
+            VkDeviceSize get_max_buffer_size(MEMORY_PROPERTY type) const;
             VkQueue get_transfer_queue() const;
             VkQueue get_present_queue() const;
             VkQueue get_graphics_queue() const;
@@ -57,7 +78,20 @@ namespace boitatah::vk
             void attach_window(std::shared_ptr<WindowManager> window);
 
             const QueueFamilyIndices get_queuefamily_indices() const;
+            //the transfer queue belongs to another family than graphics,
+            //exclusive resources need ownership transfers between them.
+            bool has_dedicated_transfer() const;
             QueueFamilyIndices find_queuefamilies(VkPhysicalDevice device) const;
+            //the graphics queue writes timestamps and query pools can be reset from the host.
+            bool supports_gpu_timestamps() const;
+            //nanoseconds per timestamp tick.
+            float get_timestamp_period() const;
+            //bits of a graphics queue timestamp that hold a value.
+            uint32_t get_timestamp_valid_bits() const;
+            //the driver reports heap budgets, VK_EXT_memory_budget.
+            bool supports_memory_budget() const;
+            //fills the first heaps of the device, returns how many there are.
+            uint32_t get_memory_heaps(MemoryHeaps& heaps) const;
             
             // Create Vulkan Objects
             VkShaderModule create_shadermodule(const std::vector<char> &bytecode) const;
@@ -70,8 +104,10 @@ namespace boitatah::vk
             VkDescriptorSetLayout create_descriptorlayout(const DescriptorSetLayoutDesc &desc) const;
             VkFence create_fence(bool signaled) const;
             VkSemaphore create_semaphore() const;
+            VkSemaphore create_timeline_semaphore(uint64_t initial_value) const;
             BufferVkData create_buffer(const BufferDescVk & desc) const;
             VkSampler create_sampler(const SamplerData& data) const;
+            VkQueryPool create_timestamp_querypool(uint32_t count) const;
             
             //Gets the buffer alignment and memory types.
             BufferVkData get_buffer_alignment_memorytype(const BufferDescVk & desc) const;
@@ -80,6 +116,7 @@ namespace boitatah::vk
 
             //Build a VkPipeline and fills the Shader object.
             // requires shader to have shadermodules already filled.
+            // only touches the device, safe to call from compile worker threads.
             void build_shader(const ShaderDescVk &desc, Shader &shader);
             
             //Allocates vkDevice Memory.
@@ -109,6 +146,13 @@ namespace boitatah::vk
 
             //Allocates a CommandBuffer
             CommandBuffer allocate_commandbuffer(const CommandBufferDesc &desc);
+            //Allocates a CommandBuffer from a pool made with create_commandpool
+            CommandBuffer allocate_commandbuffer(const CommandBufferDesc &desc, VkCommandPool pool);
+            //Creates a transient pool for the queue family of type,
+            //for threads that record on their own.
+            VkCommandPool create_commandpool(COMMAND_BUFFER_TYPE type);
+            //Resets every buffer allocated from the pool
+            void reset_commandpool(VkCommandPool pool);
 
             // Sync Methods
             //Waits for the rendertarget to finish rendering.
@@ -121,6 +165,15 @@ namespace boitatah::vk
             void reset_fence(const VkFence &fence) const;
             //Checks the fence status
             bool check_fence_status(VkFence fence);
+            //Reads the counter of a timeline semaphore
+            uint64_t get_semaphore_value(VkSemaphore semaphore) const;
+            //Waits for a timeline semaphore to reach value
+            void wait_for_semaphore(VkSemaphore semaphore, uint64_t value) const;
+            //Resets queries from the host, they must not be in use.
+            void reset_querypool(VkQueryPool pool, uint32_t first, uint32_t count) const;
+            //Reads timestamps without waiting, results holds a value and an availability per query.
+            //returns false when some query is not available yet.
+            bool get_timestamp_results(VkQueryPool pool, uint32_t first, uint32_t count, uint64_t* results) const;
 
             //Destroys the VkPipeline, ShaderModules and supporting objects
             void destroy_shader(Shader &shader);
@@ -140,12 +193,16 @@ namespace boitatah::vk
             void destroy_fence(VkFence fence);
             //Destroys a VkSemaphore
             void destroy_semaphore(VkSemaphore semaphore);
+            //Destroys a VkCommandPool and its buffers
+            void destroy_commandpool(VkCommandPool pool);
             //Destroys  a VkDescriptorPool
             void destroy_descriptorpool(VkDescriptorPool pool);
             //Destroys a VkDescriptorSetLayout
             void destroy_descriptorset_layout(VkDescriptorSetLayout &layout);
             //Destrpys a VkSampler
             void destroy_sampler(VkSampler& sampler);
+            //Destroys a VkQueryPool
+            void destroy_querypool(VkQueryPool pool);
             
         private:
 
@@ -157,6 +214,23 @@ namespace boitatah::vk
             VkInstance instance;
             VkPhysicalDevice m_physical_device = VK_NULL_HANDLE;
             VkPhysicalDeviceProperties m_device_properties;
+            VkDeviceSize m_max_allocation_size = VK_WHOLE_SIZE;
+            bool m_host_query_reset = false;
+            uint32_t m_timestamp_valid_bits = 0;
+            bool m_memory_budget = false;
+            VkPhysicalDeviceMemoryProperties m_memory_properties{};
+
+            //every VkDeviceMemory allocated, allocations come from const create functions.
+            struct MemoryAllocation{
+                uint32_t heap;
+                VkDeviceSize size;
+            };
+            mutable std::mutex m_memory_mutex;
+            mutable std::unordered_map<VkDeviceMemory, MemoryAllocation> m_memory_allocations;
+            mutable std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> m_heap_allocated{};
+            mutable std::array<uint32_t, VK_MAX_MEMORY_HEAPS> m_heap_allocations{};
+            void track_allocation(VkDeviceMemory memory, uint32_t type, VkDeviceSize size) const;
+            void track_free(VkDeviceMemory memory) const;
             VkDebugUtilsMessengerEXT m_debug_messenger;
             // window::WindowManager *window;
             
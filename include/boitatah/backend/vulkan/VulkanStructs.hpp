@@ -19,7 +19,7 @@ namespace boitatah::vk{
     struct BufferDescVk
     {
         // uint32_t alignment;
-        uint32_t size;
+        VkDeviceSize size;
         BUFFER_USAGE usage;
         SHARING_MODE sharing;
     };
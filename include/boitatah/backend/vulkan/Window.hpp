@@ -19,6 +19,8 @@ namespace boitatah::vk{
     struct WindowDesc{
         glm::u32vec2 dimensions;
         const char* windowName;
+        //hidden windows still get a swapchain, for benchmarks.
+        bool visible = true;
     };
 
     class WindowManager {
@@ -0,0 +1,56 @@
+#pragma once
+/// PRIVATE BOITATAH HEADER
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace boitatah::buffer {
+
+    //"BTAT" read as a little endian word.
+    constexpr uint32_t ALLOCATION_TRACE_MAGIC = 0x54415442;
+    constexpr uint32_t ALLOCATION_TRACE_VERSION = 1;
+
+    enum class ALLOCATION_EVENT : uint8_t {
+        RESERVE = 0,
+        FREE = 1,
+    };
+
+    ///One reserve or free of a buffer reservation.
+    /// id pairs a free with its reserve, it is reused once freed.
+    /// size is the requested size of both.
+    struct AllocationEvent{
+        VkDeviceSize size;
+        uint32_t id;
+        uint32_t frame;
+        ALLOCATION_EVENT type;
+        uint8_t usage;
+        uint8_t sharing;
+        uint8_t padding = 0;
+    };
+    static_assert(sizeof(AllocationEvent) == 24, "allocation events are written as is");
+
+    ///Writes allocation events to a binary file,
+    /// a magic and version word followed by the raw events in host byte order.
+    class AllocationTraceRecorder{
+        public:
+            AllocationTraceRecorder(const std::string &path);
+            ~AllocationTraceRecorder(void);
+
+            void record(const AllocationEvent &event);
+            void flush();
+
+            uint64_t getEventCount() const;
+
+        private:
+            std::ofstream file;
+            //written out a few pages at a time.
+            std::vector<AllocationEvent> pending;
+            uint64_t eventCount = 0;
+    };
+
+    //reads a whole trace, throws on a missing or foreign file.
+    std::vector<AllocationEvent> readAllocationTrace(const std::string &path);
+}
@@ -18,6 +18,7 @@
 #include <boitatah/commands/CommandBufferWriterStructs.hpp>
 
 #include "BufferAllocator.hpp"
+#include "SlabAllocator.hpp"
 
 namespace boitatah::buffer
 {
@@ -47,6 +48,14 @@ namespace boitatah::buffer
             VkBuffer getBuffer() const;
             VkDeviceMemory getMemory() const;
             uint32_t getID() const;
+            // persistent map of concurrent buffers, nullptr otherwise.
+            void* getMappedMemory() const;
+            // bytes of the vulkan buffer.
+            VkDeviceSize getSize() const;
+            VkDeviceSize getLargestFreeBlockSize() const;
+            VkDeviceSize getOccupiedSpace() const;
+            // slot size of slab buffers, 0 for buddy allocated buffers.
+            VkDeviceSize getSlabSlotSize() const;
             
         private:
             const vk::VulkanInstance *vulkan;
@@ -54,16 +63,18 @@ namespace boitatah::buffer
             BufferDesc description;
             BUFFER_USAGE usage;
             SHARING_MODE sharing;
-            uint32_t alignment;
-            uint32_t actualSize;
-            uint32_t blockSize;
+            VkDeviceSize alignment;
+            VkDeviceSize actualSize;
+            VkDeviceSize blockSize;
 
             // sharing mode concurrent data
             void *mappedMemory;
             
             vk::BufferVkData bufferData;
 
+            // one of the two is set.
             std::unique_ptr<BufferAllocator> mainAllocator;
+            std::unique_ptr<SlabAllocator> slabAllocator;
             std::unique_ptr<Pool<BufferReservation>> mainReservPool;
 
             //Staged Buffer Data
@@ -76,7 +87,7 @@ namespace boitatah::buffer
             
 
             //initialization method
-            void setupBuffer(uint32_t desiredBlockSize, uint32_t partitions);
+            void setupBuffer(VkDeviceSize desiredBlockSize, uint32_t partitions);
 
             //void queueTransfers();
             //void clearTransferQueue();
@@ -85,13 +96,13 @@ namespace boitatah::buffer
 
             // for SHARINGMODE::EXCLUSIVE requires a buffer queueUpdate after
             void copyData(const Handle<BufferReservation> handle, const void * data);
-            void copyData(const Handle<BufferReservation> handle, const void * data, uint32_t size);
+            void copyData(const Handle<BufferReservation> handle, const void * data, VkDeviceSize size);
             //void copyDataFromBuffer(const Handle<BufferReservation> dst, const Handle<BufferAddress> srcBuffer);
             // returns a buffer address to the staging buffer
 
             bool getReservationData(const Handle<BufferReservation> handle, BufferReservation& reservation) const;
            
-            Handle<BufferReservation> reserve(const uint32_t request);
+            Handle<BufferReservation> reserve(const VkDeviceSize request);
             bool unreserve(const Handle<BufferReservation> reservation);
 
             //void queueTransfer(Handle<BufferAddress> src, Handle<BufferReservation> dst);
@@ -2,15 +2,20 @@
 /// PRIVATE BOITATAH HEADER
 
 #include "../collections/Pool.hpp"
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <memory>
+
+//same typedef as vulkan_core.h, so the allocator builds without the vulkan headers.
+typedef uint64_t VkDeviceSize;
+
 namespace boitatah::buffer {
 
     struct Block{
         uint32_t id;
-        uint32_t address;
-        uint32_t size;
+        VkDeviceSize address;
+        VkDeviceSize size;
     };
 
     enum BinaryTreeNodeOccupation{
@@ -27,7 +32,7 @@ namespace boitatah::buffer {
         uint32_t leftChildIndex;
         uint32_t rightChildIndex;
 
-        uint32_t largestFreeBlockSize;
+        VkDeviceSize largestFreeBlockSize;
 
         //FREE nodes are leaves;
         //1 partial;
@@ -36,11 +41,13 @@ namespace boitatah::buffer {
     };
 
     struct BufferAllocatorDesc{
-        uint32_t alignment;
+        VkDeviceSize alignment;
         //must be a multiple alignment * constant
-        uint32_t partitionSize;
+        VkDeviceSize partitionSize;
         //tree depth
         uint32_t height;
+        //largest buffer the memory heap takes, height shrinks to fit.
+        VkDeviceSize maxSize;
     };
 
     class BufferAllocator{
@@ -48,26 +55,26 @@ namespace boitatah::buffer {
             BufferAllocator(const BufferAllocatorDesc &desc);
             //~BufferAllocator(void);
 
-            bool getBlockData(Handle<Block> &handle, uint32_t &offset, uint32_t &size);
-            Handle<Block> allocate(uint32_t request);
+            bool getBlockData(Handle<Block> &handle, VkDeviceSize &offset, VkDeviceSize &size);
+            Handle<Block> allocate(VkDeviceSize request);
             bool release(Handle<Block> &handle);
 
-            uint32_t freeSpace();
-            uint32_t getOccupiedSpace();
-            uint32_t getLargestFreeBlockSize();
-            uint32_t getPartitionSize();
+            VkDeviceSize freeSpace();
+            VkDeviceSize getOccupiedSpace();
+            VkDeviceSize getLargestFreeBlockSize();
+            VkDeviceSize getPartitionSize();
             std::string coolPrint();
 
-            uint32_t getSize();
+            VkDeviceSize getSize();
 
         private:
-            uint32_t alignment;
-            uint32_t partitionSize;
-            uint32_t size;
+            VkDeviceSize alignment;
+            VkDeviceSize partitionSize;
+            VkDeviceSize size;
             uint32_t height;
             uint32_t leafQuant;
 
-            uint32_t occupiedSpace;
+            VkDeviceSize occupiedSpace = 0;
 
             std::vector<Block> blocks;
             std::vector<BinaryTreeNode> nodes;
@@ -77,13 +84,13 @@ namespace boitatah::buffer {
             //uint32_t getNodeBuddy(uint32_t index);
             uint32_t getNodeLevel(uint32_t index);
 
-            uint32_t findFreeNode(uint32_t request);
+            uint32_t findFreeNode(VkDeviceSize request);
 
             void upstreamOccupationCorrect(uint32_t index);
 
             uint32_t getBlockIndexFromId(uint32_t id);
 
-            uint32_t getMinimunFitSize(uint32_t request);
+            VkDeviceSize getMinimunFitSize(VkDeviceSize request);
 
             std::vector<uint32_t> getLeaves(uint32_t maxDepth);
 
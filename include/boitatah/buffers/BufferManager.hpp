@@ -1,8 +1,15 @@
 #pragma once
 
+#include <array>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include <boitatah/buffers/BufferStructs.hpp>
+#include <boitatah/buffers/AllocationTrace.hpp>
 #include <boitatah/backend/vulkan/Vulkan.hpp>
+#include <boitatah/backend/vulkan/VkSubmissionList.hpp>
 #include <boitatah/collections/Pool.hpp>
 
 #include <boitatah/commands/CommandBuffer.hpp>
@@ -15,19 +22,119 @@ namespace boitatah::buffer
     using namespace boitatah::vk;
     using namespace boitatah::command_buffers;
     class Buffer;
+
+    ///Sizing of the buddy buffers serving a range of requests.
+    /// Requests above the last class get a buffer of their own.
+    struct BufferSizeClass{
+        //largest request of the class.
+        VkDeviceSize maxRequest;
+        VkDeviceSize partitionSize;
+        //power of 2.
+        uint32_t partitions;
+    };
+
+    constexpr std::array<BufferSizeClass, 3> BUFFER_SIZE_CLASSES = {{
+        {.maxRequest = 16u << 10,  .partitionSize = 1u << 10,   .partitions = 1u << 10},
+        {.maxRequest = 256u << 10, .partitionSize = 16u << 10,  .partitions = 1u << 10},
+        {.maxRequest = 4u << 20,   .partitionSize = 256u << 10, .partitions = 1u << 8},
+    }};
+
+    //class of requests too large for BUFFER_SIZE_CLASSES.
+    constexpr uint32_t DEDICATED_SIZE_CLASS = BUFFER_SIZE_CLASSES.size();
+
+    //class index of a request served by buddy buffers.
+    uint32_t bufferSizeClass(VkDeviceSize request);
+
+    //buffers less occupied than this are drained by the defragmenter.
+    constexpr double DEFRAG_SPARSE_RATIO = 0.25;
+    //planning calls skipped after a buffer could not be drained.
+    constexpr uint32_t DEFRAG_RETRY_CALLS = 120;
+
+    ///Running counters of the buffer manager.
+    ///     uploadedBytes:  bytes written from the host by copyToBuffer and memoryCopy since creation.
+    ///     reservedBytes:  requested bytes of the live reservations, indexed by BUFFER_USAGE.
+    struct BufferManagerStats{
+        uint64_t uploadedBytes = 0;
+        std::array<uint64_t, static_cast<uint32_t>(BUFFER_USAGE::TRANSIENT) + 1> reservedBytes{};
+
+        uint64_t reserved(BUFFER_USAGE usage) const {
+            return reservedBytes[static_cast<uint32_t>(usage)];
+        }
+    };
+
+    ///A live buffer, largestFree is the biggest reservation it still fits.
+    struct BufferMemoryStats{
+        uint32_t id;
+        BUFFER_USAGE usage;
+        SHARING_MODE sharing;
+        VkDeviceSize size;
+        VkDeviceSize occupied;
+        VkDeviceSize largestFree;
+        //0 for buddy allocated buffers.
+        VkDeviceSize slabSlotSize;
+    };
+
     //class VkCommnadBufferWriter;
     class BufferManager : public std::enable_shared_from_this<BufferManager>
     {
         private:
-            uint32_t partitionsPerBuffer = 1u << 10;
+            //minUniformBufferOffsetAlignment, small requests share slab slots of this alignment.
+            uint32_t slabAlignment = 1;
+
+            //buffers of one usage, sharing and size class ordered by their largest free block,
+            //the first one not smaller than a request is the best fit.
+            using Bucket = std::multimap<VkDeviceSize, Handle<Buffer *>>;
+            std::unordered_map<uint64_t, Bucket> m_buckets;
+
+            //where each buffer sits in its bucket, indexed by buffer handle.
+            struct BucketEntry{
+                Bucket* bucket = nullptr;
+                Bucket::iterator position;
+                //false while the buffer is drained by the defragmenter.
+                bool listed = false;
+            };
+            std::vector<BucketEntry> m_bucketEntries;
+
+            //live addresses of each buffer, indexed by buffer handle,
+            //and the position of each address in its list, indexed by address handle.
+            std::vector<std::vector<Handle<BufferAddress>>> m_bufferAddresses;
+            std::vector<uint32_t> m_addressSlots;
+
+            //a reservation copied to another buffer, the address is patched once the copy completes.
+            struct DefragmentMove{
+                Handle<BufferAddress> address;
+                Handle<Buffer *> buffer;
+                Handle<BufferReservation> reservation;
+                TimelinePoint copied{};
+                bool recorded = false;
+                bool stamped = false;
+                //the address was freed or written while moving.
+                bool cancelled = false;
+            };
+            //an old location, freed once the frames that may read it complete.
+            struct RetiredReservation{
+                Handle<Buffer *> buffer;
+                Handle<BufferReservation> reservation;
+                TimelineFrontier frontier;
+            };
+            Handle<Buffer *> m_defragSource;
+            std::vector<DefragmentMove> m_defragMoves;
+            std::vector<RetiredReservation> m_retiredReservations;
+            uint32_t m_defragCooldown = 0;
+
+            //null unless an allocation trace is being recorded.
+            std::unique_ptr<AllocationTraceRecorder> m_trace;
+            uint32_t m_traceFrame = 0;
+
+            BufferManagerStats m_stats;
 
             std::shared_ptr<VulkanInstance>  m_vk;
             std::vector<Handle<Buffer *>> m_activeBuffers;
 
-            Pool<Buffer *> m_bufferPool = Pool<Buffer *>({.size = 1<<16, .name = "uniforms pool"});
+            Pool<Buffer *> m_bufferPool = Pool<Buffer *>({.size = 1<<16, .name = "buffer pool"});
             Pool<std::shared_ptr<Buffer>> m_stagingBufferPool = Pool<std::shared_ptr<Buffer>>({.size = 1<<16, .name = "uniforms pool"});
             
-            Pool<BufferAddress> m_addressPool = Pool<BufferAddress>({.size = 1<<20, .name = "uniforms pool"});
+            Pool<BufferAddress> m_addressPool = Pool<BufferAddress>({.size = 1<<20, .name = "buffer address pool"});
             CommandBuffer m_transferBuffer;
             VkFence m_transferFence;
 
@@ -36,7 +143,26 @@ namespace boitatah::buffer
             void releaseBuffer(Handle<Buffer*> handle);
 
             Handle<Buffer *> findOrCreateCompatibleBuffer(const BufferReservationRequest &compatibility);
-            uint32_t findCompatibleBuffer(const BufferReservationRequest &compatibility);
+            //a buffer sized by the request's class, sizeClass 0 is a slab of slabSlotSize.
+            Handle<Buffer *> createClassBuffer(const BufferReservationRequest &compatibility,
+                                               uint32_t slabSlotSize,
+                                               uint32_t sizeClass);
+            //reorders a buffer in its bucket after its largest free block changed.
+            void updateBucket(Handle<Buffer *> handle);
+            void unlistBucket(Handle<Buffer *> handle);
+            void relistBucket(Handle<Buffer *> handle);
+
+            void trackAddress(Handle<Buffer *> buffer, Handle<BufferAddress> address);
+            void untrackAddress(Handle<Buffer *> buffer, Handle<BufferAddress> address);
+
+            //sparsest exclusive buffer sharing its bucket with another one.
+            Handle<Buffer *> findDefragmentSource();
+            //cancels the pending move of an address.
+            void cancelDefragmentMove(Handle<BufferAddress> address);
+            //a pending move, cancelled or not, reserves space in the buffer.
+            bool isDefragmentDestination(Handle<Buffer *> handle) const;
+            //releases the source once nothing lives or moves in it.
+            void finishDefragmentSource();
             
 
         public:
@@ -52,7 +178,7 @@ namespace boitatah::buffer
             bool queueCopy( CommandBufferWriter<T>& writer, const Handle<BufferAddress> src, const Handle<BufferAddress> dst);
 
             //user is responsible for releasing the staged buffer
-            void memoryCopy(uint32_t dataSize, const void* data, Handle<BufferAddress>& handle);
+            void memoryCopy(VkDeviceSize dataSize, const void* data, Handle<BufferAddress>& handle);
 
             bool getAddressReservation(const Handle<BufferAddress> handle, BufferReservation& reservation);
             Handle<BufferReservation> getAddressReservation(const Handle<BufferAddress> handle);
@@ -66,6 +192,32 @@ namespace boitatah::buffer
             CommandBuffer getTransferBuffer();
 
             VkBuffer getVkBuffer(const Handle<BufferAddress> handle);
+
+            const BufferManagerStats& getStats() const;
+            void getBufferStats(std::vector<BufferMemoryStats>& stats);
+            void getPoolStats(std::vector<PoolStats>& stats) const;
+
+            ///Incremental defragmentation of exclusive buffers, from the rendering thread.
+            /// Live reservations of a sparse buffer are copied into denser buffers of its bucket
+            /// a few per frame, their addresses point to the copy once it completes,
+            /// and the emptied buffer is released.
+            /// Concurrent buffers are written by the host and are not moved.
+
+            //reserves destinations for up to byteBudget bytes, true when there are copies to record.
+            bool planDefragmentMoves(VkDeviceSize byteBudget);
+            //records the planned copies after everything queued before frontier.
+            template<class T>
+            void recordDefragmentMoves(CommandBufferWriter<T>& writer, const TimelineFrontier& frontier);
+            //the timeline point of the batch the copies were submitted in.
+            void stampDefragmentMoves(TimelinePoint copies);
+            //patches addresses of completed copies and frees what the gpu is done with.
+            void collectDefragmentMoves(VkSubmissionList& submissions);
+
+            ///Records every reserve and free to a binary trace, replayed by the allocator_replay tool.
+            void startAllocationTrace(const std::string& path);
+            void stopAllocationTrace();
+            //frame number written with the next events.
+            void nextAllocationTraceFrame();
     };
 
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <vulkan/vulkan.h>
 #include <boitatah/collections/Pool.hpp>
 #include <boitatah/BoitatahEnums.hpp>
 
@@ -11,7 +12,7 @@ namespace boitatah::buffer
     class Block;
     struct BufferReservationRequest
     {
-        uint32_t request;
+        VkDeviceSize request;
         BUFFER_USAGE usage;
         SHARING_MODE sharing;
     };
@@ -19,20 +20,23 @@ namespace boitatah::buffer
     struct BufferReservation
     {
         //Buffer* buffer;
-        uint32_t size;
-        uint32_t requestSize;
-        uint32_t offset;
+        VkDeviceSize size;
+        VkDeviceSize requestSize;
+        VkDeviceSize offset;
         Handle<Block> reservedBlock;
     };
 
     struct BufferDesc
     {
         // uint32_t alignment;
-        uint32_t estimatedElementSize;
+        VkDeviceSize estimatedElementSize;
         // power of 2.
         uint32_t partitions;
         BUFFER_USAGE usage;
         SHARING_MODE sharing;
+        // not 0 splits the buffer in SLAB_SLOTS slots of this size,
+        // partition arguments are ignored.
+        uint32_t slabSlotSize = 0;
 
         //if sharing == sharing_mode::exclusive, requires a buffermanager
         std::weak_ptr<BufferManager> bufferManager;
@@ -42,25 +46,25 @@ namespace boitatah::buffer
     struct BufferAddress{
         Handle<Buffer *> buffer;
         Handle<BufferReservation> reservation;
-        uint32_t size;
+        VkDeviceSize size;
     };
 
     struct BufferUploadDesc{
         Handle<BufferAddress> address;
-        uint32_t dataSize;
+        VkDeviceSize dataSize;
         void* data;
     };
 
     struct BufferAddressDesc
     {
-        uint32_t request;
+        VkDeviceSize request;
         BUFFER_USAGE usage;
         SHARING_MODE sharing;
     };
 
     struct BufferAccessData{
         Buffer* buffer;
-        uint32_t offset;
-        uint32_t size;
+        VkDeviceSize offset;
+        VkDeviceSize size;
     };
 }
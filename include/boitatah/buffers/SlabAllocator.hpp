@@ -0,0 +1,55 @@
+#pragma once
+/// PRIVATE BOITATAH HEADER
+
+#include "../collections/Pool.hpp"
+#include "BufferAllocator.hpp"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace boitatah::buffer {
+
+    //slots of one slab, a single summary word covers every bitmap word.
+    constexpr uint32_t SLAB_SLOTS = 64 * 64;
+
+    //size classes served by slabs, larger requests use the buddy allocator.
+    constexpr std::array<uint32_t, 4> SLAB_SIZE_CLASSES = {64, 128, 256, 512};
+
+    //slot size serving request with the given alignment, 0 when too large for a slab.
+    uint32_t slabSlotSize(VkDeviceSize request, uint32_t alignment);
+
+    struct SlabAllocatorDesc{
+        //power of 2.
+        uint32_t alignment;
+        //rounded up to alignment.
+        uint32_t slotSize;
+    };
+
+    ///Fixed size slots with free bitmaps.
+    /// A set bit marks a free slot, the summary marks words with a free slot,
+    /// so allocate and release are a couple of bit scans.
+    class SlabAllocator{
+        public:
+            SlabAllocator(const SlabAllocatorDesc &desc);
+
+            bool getBlockData(Handle<Block> &handle, VkDeviceSize &offset, VkDeviceSize &size);
+            Handle<Block> allocate(VkDeviceSize request);
+            bool release(Handle<Block> &handle);
+
+            VkDeviceSize freeSpace();
+            VkDeviceSize getOccupiedSpace();
+            VkDeviceSize getLargestFreeBlockSize();
+            VkDeviceSize getSlotSize();
+            VkDeviceSize getSize();
+
+        private:
+            VkDeviceSize slotSize;
+            VkDeviceSize size;
+            uint32_t occupiedSlots = 0;
+
+            uint64_t summary = 0;
+            std::array<uint64_t, SLAB_SLOTS / 64> freeWords;
+            //bumped on release, stale handles don't match.
+            std::vector<uint32_t> generations;
+    };
+}
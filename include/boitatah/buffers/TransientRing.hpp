@@ -0,0 +1,63 @@
+#pragma once
+
+/// PRIVATE BOITATAH HEADER
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <boitatah/backend/vulkan/Vulkan.hpp>
+#include <boitatah/backend/vulkan/VkSubmissionList.hpp>
+#include <boitatah/buffers/BufferStructs.hpp>
+
+namespace boitatah::buffer
+{
+    struct TransientAllocation{
+        void* data;
+        BufferAccessData access;
+    };
+
+    ///Bump allocator over a persistently mapped buffer,
+    /// one region per frame in flight.
+    /// Allocations live until the frame is submitted,
+    /// a region is reused once the frontier of the frame that filled it completes.
+    /// Not thread safe, allocate from the rendering thread.
+    class TransientRing{
+        public:
+            TransientRing(std::shared_ptr<vk::VulkanInstance> vk_instance,
+                          std::shared_ptr<vk::VkSubmissionList> submissions,
+                          uint32_t regionSize,
+                          uint32_t regions);
+            ~TransientRing();
+
+            TransientRing(const TransientRing&) = delete;
+            TransientRing& operator=(const TransientRing&) = delete;
+
+            //alignment 0 uses minUniformBufferOffsetAlignment.
+            //throws when the current region is full.
+            TransientAllocation allocate(uint32_t size, uint32_t alignment = 0);
+
+            //call once the frame's batches are enqueued,
+            //waits for the next region to be released by the gpu.
+            void nextFrame();
+
+            uint32_t getRegionSize() const;
+            uint32_t getRegionCount() const;
+            //bytes allocated in the current region.
+            uint32_t getUsed() const;
+
+        private:
+            std::shared_ptr<vk::VulkanInstance> m_vk;
+            std::shared_ptr<vk::VkSubmissionList> m_submissions;
+
+            std::unique_ptr<Buffer> m_buffer;
+            std::byte* m_mapped = nullptr;
+
+            uint32_t m_regionSize;
+            uint32_t m_minAlignment;
+            std::vector<vk::TimelineFrontier> m_regionFrontiers;
+
+            uint32_t m_region = 0;
+            uint32_t m_offset = 0;
+    };
+}
@@ -1,3 +1,5 @@
 #pragma once
 
-#include<boitatah/collections/Pool.hpp>
\ No newline at end of file
+#include<boitatah/collections/Pool.hpp>
+#include<boitatah/collections/Mailbox.hpp>
+#include<boitatah/collections/FrameArena.hpp>
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+namespace boitatah{
+
+    ///What one frame took from a FrameArena.
+    struct FrameArenaStats{
+        std::size_t bytes = 0;
+        uint32_t allocations = 0;
+        //allocations that did not fit the block and went to the heap.
+        uint32_t heapAllocations = 0;
+    };
+
+    ///Monotonic memory for containers that live within one frame, std::pmr compatible.
+    /// Allocations bump an offset into one block, deallocation does nothing
+    /// and reset() releases the whole frame at once.
+    /// A frame that overflows the block takes the rest from the heap,
+    /// the next reset grows the block so steady frames stay off the heap.
+    /// Not thread safe, it belongs to the thread recording the frame.
+    class FrameArena : public std::pmr::memory_resource{
+        public:
+            FrameArena(std::size_t capacity = 64 * 1024);
+            ~FrameArena();
+
+            FrameArena(const FrameArena&) = delete;
+            FrameArena& operator=(const FrameArena&) = delete;
+
+            //ends the frame, everything allocated since the last reset is released.
+            void reset();
+
+            std::size_t capacity() const;
+
+            //the frame being allocated.
+            FrameArenaStats current() const;
+            //the frame ended by the last reset.
+            FrameArenaStats last_frame() const;
+
+        private:
+            //header in front of every heap allocation.
+            struct Overflow{
+                Overflow*   next;
+                std::size_t size;
+                std::size_t alignment;
+            };
+
+            std::byte*      m_block = nullptr;
+            std::size_t     m_capacity = 0;
+            std::size_t     m_offset = 0;
+
+            Overflow*       m_overflow = nullptr;
+            std::size_t     m_overflowBytes = 0;
+
+            FrameArenaStats m_current;
+            FrameArenaStats m_last;
+
+            void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+            void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override;
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+            void release_overflow();
+    };
+}
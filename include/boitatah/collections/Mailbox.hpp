@@ -0,0 +1,129 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace boitatah{
+
+    ///Hands the latest value from a producer thread to a consumer thread.
+    /// With 3 slots the producer never waits and unread values are replaced by newer ones.
+    /// With 2 slots publish waits for the consumer to release its slot,
+    /// so the producer runs at most one value ahead.
+    template<typename T>
+    class Mailbox{
+        public:
+            Mailbox(uint32_t slots = 3);
+
+            Mailbox(const Mailbox&) = delete;
+            Mailbox& operator=(const Mailbox&) = delete;
+
+            //the producer's slot, filled before publish.
+            T& write_slot();
+
+            //makes the write slot the latest value and moves to a free slot.
+            //returns false once closed.
+            bool publish();
+
+            //releases the last acquired value and waits for a newer one.
+            //returns nullptr once closed.
+            T* acquire();
+
+            //waits until the consumer has released everything published.
+            void wait_idle();
+
+            //wakes both sides, publish and acquire fail from now on.
+            void close();
+
+        private:
+            static constexpr uint32_t NONE = UINT32_MAX;
+
+            std::vector<T>          m_slots;
+            uint32_t                m_write = 0;
+            uint32_t                m_ready = NONE;
+            uint32_t                m_read = NONE;
+            bool                    m_closed = false;
+
+            std::mutex              m_mutex;
+            std::condition_variable m_changed;
+
+            uint32_t free_slot() const;
+    };
+
+    template <typename T>
+    Mailbox<T>::Mailbox(uint32_t slots) : m_slots(slots)
+    {
+        if(slots < 2 || slots > 3)
+            throw std::runtime_error("mailbox needs 2 or 3 slots");
+    }
+
+    template <typename T>
+    T &Mailbox<T>::write_slot()
+    {
+        return m_slots[m_write];
+    }
+
+    template <typename T>
+    bool Mailbox<T>::publish()
+    {
+        std::unique_lock lock(m_mutex);
+        if(m_closed)
+            return false;
+
+        //an unread value is dropped, its slot is free again.
+        m_ready = m_write;
+        m_changed.notify_all();
+
+        m_changed.wait(lock, [this](){ return m_closed || free_slot() != NONE; });
+        if(m_closed)
+            return false;
+        m_write = free_slot();
+        return true;
+    }
+
+    template <typename T>
+    T *Mailbox<T>::acquire()
+    {
+        std::unique_lock lock(m_mutex);
+        m_read = NONE;
+        m_changed.notify_all();
+
+        m_changed.wait(lock, [this](){ return m_closed || m_ready != NONE; });
+        if(m_closed)
+            return nullptr;
+        m_read = m_ready;
+        m_ready = NONE;
+        return &m_slots[m_read];
+    }
+
+    template <typename T>
+    void Mailbox<T>::wait_idle()
+    {
+        std::unique_lock lock(m_mutex);
+        m_changed.wait(lock, [this](){
+            return m_closed || (m_ready == NONE && m_read == NONE);
+        });
+    }
+
+    template <typename T>
+    void Mailbox<T>::close()
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_closed = true;
+        }
+        m_changed.notify_all();
+    }
+
+    template <typename T>
+    uint32_t Mailbox<T>::free_slot() const
+    {
+        for(uint32_t i = 0; i < m_slots.size(); i++){
+            if(i != m_ready && i != m_read)
+                return i;
+        }
+        return NONE;
+    }
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <vector>
 #include <iostream>
@@ -51,6 +52,15 @@ namespace boitatah
         std::string name;
     };
 
+    ///Occupancy of a Pool, highWater is the most items it held at once.
+    struct PoolStats
+    {
+        std::string name;
+        uint32_t capacity = 0;
+        uint32_t live = 0;
+        uint32_t highWater = 0;
+    };
+
     template <typename T>
     class Pool
     {
@@ -67,6 +77,7 @@ namespace boitatah
         bool clear(Handle<T> handle, T& item);
         bool clear(Handle<T> handle);
         bool contains(Handle<T> handle);
+        PoolStats getStats() const;
         
     private:
         PoolOptions options;
@@ -76,6 +87,7 @@ namespace boitatah
         std::vector<uint32_t> freeStack; // stack of free ids?
         uint32_t stackTop = 0;
         uint32_t quantity = 0;
+        uint32_t highWater = 0;
         uint32_t popStack();
         void pushStack(uint32_t id);
         int created = 0;
@@ -167,6 +179,7 @@ inline boitatah::Handle<T> boitatah::Pool<T>::getHandle()
             options.size = options.size * static_cast<uint32_t>(2);
 
             pool.resize(options.size);
+            generations.resize(options.size, 1);
             freeStack.resize(options.size);
             for (uint32_t i = old_size; i < freeStack.size(); i++)
             {
@@ -179,6 +192,7 @@ inline boitatah::Handle<T> boitatah::Pool<T>::getHandle()
     Handle<T> handle{.i = i, .gen = generations[i]};
     created+=1;
     quantity += 1;
+    highWater = std::max(highWater, quantity);
     return handle;
 }
 
@@ -218,6 +232,15 @@ inline bool boitatah::Pool<T>::contains(Handle<T> handle)
     return true;
 }
 
+template <typename T>
+inline boitatah::PoolStats boitatah::Pool<T>::getStats() const
+{
+    return {.name = options.name,
+            .capacity = static_cast<uint32_t>(pool.size()),
+            .live = quantity,
+            .highWater = highWater};
+}
+
 template <typename T>
 uint32_t boitatah::Pool<T>::popStack()
 {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <span>
 #include <vector>
 
 #include "CommandBufferWriterStructs.hpp"
@@ -40,8 +41,13 @@ namespace boitatah::command_buffers{
             using CopyBufferCommand =           typename CommandWriterTraits<T>::CopyBufferCommand;
             using TransitionLayoutCommand =     typename CommandWriterTraits<T>::TransitionLayoutCommand;
             using CopyBufferToImageCommand =    typename CommandWriterTraits<T>::CopyBufferToImageCommand;
+            using BufferBarrierCommand =        typename CommandWriterTraits<T>::BufferBarrierCommand;
+            using ExecuteCommandsCommand =      typename CommandWriterTraits<T>::ExecuteCommandsCommand;
 
             using PushConstantsCommand =        typename CommandWriterTraits<T>::PushConstantsCommand;
+            using WriteTimestampCommand =       typename CommandWriterTraits<T>::WriteTimestampCommand;
+
+            using Stats =                       typename CommandWriterTraits<T>::Stats;
 
             T& self(){return *static_cast<T*>(this);};
 
@@ -61,8 +67,9 @@ namespace boitatah::command_buffers{
             CommandWriterTraits<T>::SemaphoreType* get_signal(){return &(self().m_signal);}
 
 
-            void setWait(std::vector<SemaphoreType> semaphores) {
-                m_wait = semaphores;
+            //keeps the capacity of the last waits, a reused writer doesn't allocate.
+            void setWait(std::span<const SemaphoreType> semaphores) {
+                m_wait.assign(semaphores.begin(), semaphores.end());
             };
 
             void begin(const BeginCommand &command) {
@@ -133,10 +140,31 @@ namespace boitatah::command_buffers{
                 self().__imp_copy_buffer_to_image(command, m_buffer);
             }
 
+            void buffer_barrier(const BufferBarrierCommand& command) {
+                self().__imp_buffer_barrier(command, m_buffer);
+            }
+
+            void execute_commands(const ExecuteCommandsCommand& command) {
+                self().__imp_execute_commands(command, m_buffer);
+            }
+
             void push_constants(const PushConstantsCommand& command){
                 self().__imp_push_constants(command, m_buffer);
             }
 
+            void write_timestamp(const WriteTimestampCommand& command){
+                self().__imp_write_timestamp(command, m_buffer);
+            }
+
+            //commands recorded and binds dropped since the last reset_stats.
+            const Stats& get_stats() {
+                return self().__imp_get_stats();
+            }
+
+            void reset_stats() {
+                self().__imp_reset_stats();
+            }
+
 
     };
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <span>
 #include <vector>
 
 #include <boitatah/collections.hpp>
@@ -63,6 +64,11 @@ namespace boitatah
             Light& operator[](int idx){return light_content[idx];};
             void update();
 
+            //the lights update() uploads.
+            std::span<const Light> active_lights() const;
+            //uploads a copy of the lights, leaves this array's content untouched.
+            void upload(std::span<const Light> lights);
+
             Handle<GPUBuffer> metadata();
             Handle<GPUBuffer> light_array();
 
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+///Heap allocations per profiler zone, compiled in with BOITATAH_ALLOC_AUDIT
+/// (cmake -DBOITATAH_PROFILER=ON -DBOITATAH_ALLOC_AUDIT=ON).
+/// Replaces the global operator new and delete, and on glibc malloc, calloc, realloc and free.
+/// Each allocation and free is charged to the innermost BOITATAH_ZONE open on its thread.
+///
+/// The renderer ends a frame after render_frame, see Renderer::getFrameAllocations.
+/// Counters are process wide, with a render thread the next frame's extraction
+/// may land on either side of the cut.
+namespace boitatah::alloc_audit{
+
+    //distinct zone names counted, the rest go to "(table full)".
+    constexpr uint32_t AUDIT_SCOPES = 512;
+    //nested zones tracked per thread, deeper ones are charged to their ancestor.
+    constexpr uint32_t AUDIT_DEPTH = 64;
+
+    ///Heap traffic of a zone, allocations made outside any zone are under "(no zone)".
+    struct ScopeAllocations{
+        const char* scope = nullptr;
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+        uint64_t frees = 0;
+    };
+
+#ifdef BOITATAH_ALLOC_AUDIT
+    //opened and closed by profiler::Zone.
+    void push_scope(const char* name);
+    void pop_scope();
+
+    //moves the counters into the frame report and clears them, allocation free.
+    void end_frame();
+
+    //zones that touched the heap in the last ended frame, most bytes first.
+    std::span<const ScopeAllocations> last_frame();
+#else
+    inline void end_frame() {}
+    inline std::span<const ScopeAllocations> last_frame() { return {}; }
+#endif
+}
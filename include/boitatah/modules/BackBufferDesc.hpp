@@ -1,6 +1,7 @@
 #pragma once
 
 #include <glm/vec2.hpp>
+#include <string>
 #include <vector>
 
 #include <boitatah/BoitatahEnums.hpp>
@@ -73,6 +74,8 @@ namespace boitatah{
         bool clear = true;
         SAMPLES samples = SAMPLES::SAMPLES_1;
         BindingLinks links;
+        //names the stage in gpu timings, "stage <index>" when empty.
+        std::string name;
     };
 
     struct RenderStage{
@@ -32,6 +32,10 @@ namespace boitatah {
                 buff.copyData(&uniforms, sizeof(CameraUniforms));
                 return m_buffer;
             };
+            //the buffer without writing the current uniforms into it.
+            Handle<GPUBuffer> getBufferHandle() const{
+                return m_buffer;
+            };
         private :
             Handle<GPUBuffer> m_buffer;
             std::weak_ptr<GPUResourceManager> m_manager;
@@ -4,12 +4,13 @@
 #include <span>
 #include <memory>
 #include <algorithm>
+#include <memory_resource>
 #include <string>
 
 #include <boitatah/backend/vulkan/Vulkan.hpp>
 #include <boitatah/collections.hpp>
 #include <boitatah/types/Descriptors.hpp>
-namespace boitatah::vk::descriptor_sets{ class DescriptorSetTree; }
+namespace boitatah::vk::descriptor_sets{ class DescriptorSetLayoutCache; }
 
 namespace boitatah::vk
 {
@@ -23,11 +24,22 @@ namespace boitatah::vk
         private:
             mat<uint32_t, 10, FRAMES> used_descriptors; // TODO number of descriptor types
             std::array<uint32_t, 10> set_capacity;
+            std::array<uint32_t, FRAMES> used_sets;
             std::array<VkDescriptorPool, FRAMES> pools;
+            std::vector<DescriptorSetRatio> m_ratios;
+            uint32_t m_maxSets;
+            uint32_t m_peakSets = 0;
 
         public:
 
-            DescriptorSetPool(const uint32_t maxSets, const std::vector<DescriptorSetRatio> ratios, std::shared_ptr<VulkanInstance> vk){
+            // Sized for maxSets sets of the layout the ratios came from.
+            DescriptorSetPool(const uint32_t maxSets, const std::vector<DescriptorSetRatio> ratios, std::shared_ptr<VulkanInstance> vk)
+                : m_ratios(ratios), m_maxSets(maxSets){
+                set_capacity.fill(0);
+                used_sets.fill(0);
+                for(auto& used : used_descriptors)
+                    used.fill(0);
+
                 // TODO move to vulkan class
                 std::vector<VkDescriptorPoolSize> sizes;
                 sizes.resize(ratios.size());
@@ -36,11 +48,7 @@ namespace boitatah::vk
                     sizes[i].type = castEnum<VkDescriptorType>(ratios[i].type);
                     sizes[i].descriptorCount = ratios[i].quantity * maxSets;
                     auto capacity_idx = static_cast<uint32_t>(ratios[i].type);
-                    std::cout << capacity_idx << std::endl;
                     set_capacity[capacity_idx] = ratios[i].quantity * maxSets;
-                    
-                    for(uint32_t i = 0; i < FRAMES; i++)
-                        used_descriptors[i][capacity_idx] = 0;
                 } 
                 //std::cout << "created sizes vector" << std::endl;
                 VkDescriptorPoolCreateInfo poolInfo{
@@ -66,17 +74,34 @@ namespace boitatah::vk
 
             bool fits(const DescriptorSetLayout &request, uint32_t pool_index)
             {
-                bool fit = true;
+                bool fit = used_sets[pool_index % FRAMES] < m_maxSets;
                 for (auto ratio : request.ratios)
                 {
                     int type_idx = static_cast<uint32_t>(ratio.type);
                     fit &= (set_capacity[type_idx] % ratio.quantity) == 0;
                     int remaining = set_capacity[type_idx] - used_descriptors[pool_index % FRAMES][type_idx];
-                    fit &= remaining > ratio.quantity;
+                    fit &= remaining >= ratio.quantity;
                 }
                 return fit;
             };
 
+            // if this pool was made for a layout with the same descriptor counts.
+            bool matches(const DescriptorSetLayout &request) const
+            {
+                if(request.ratios.size() != m_ratios.size())
+                    return false;
+                for(size_t i = 0; i < m_ratios.size(); i++)
+                    if(request.ratios[i].type != m_ratios[i].type ||
+                       request.ratios[i].quantity != m_ratios[i].quantity)
+                        return false;
+                return true;
+            }
+
+            uint32_t getMaxSets() const { return m_maxSets; }
+            // most sets allocated from one frame's pool at once.
+            uint32_t getPeakSets() const { return m_peakSets; }
+            uint32_t getUsedSets(uint32_t poolIndex) const { return used_sets[poolIndex % FRAMES]; }
+
             VkDescriptorSet allocate(const DescriptorSetLayout &request, const uint32_t poolIndex,std::shared_ptr<VulkanInstance> vk)
             {
                 VkDescriptorSet set;
@@ -93,6 +118,8 @@ namespace boitatah::vk
                 {
                     used_descriptors[poolIndex % FRAMES][static_cast<uint32_t>(ratio.type)] +=  ratio.quantity;
                 }
+                used_sets[poolIndex % FRAMES]++;
+                m_peakSets = std::max(m_peakSets, used_sets[poolIndex % FRAMES]);
                 auto result = vkAllocateDescriptorSets(vk->get_device(), &info, &set);
                 if( result != VK_SUCCESS)
                     throw std::runtime_error("failed to allocate descriptor set for Pool " + std::to_string(static_cast<int>(result)));
@@ -104,21 +131,38 @@ namespace boitatah::vk
             {
                 vkResetDescriptorPool(vk->get_device(), pools[poolIndex % FRAMES], 0);
                 used_descriptors[poolIndex % FRAMES].fill(0);
+                used_sets[poolIndex % FRAMES] = 0;
             };
 
             void release(std::shared_ptr<VulkanInstance> vk)
             {                
-                for(uint32_t i; i < FRAMES; i++)
+                for(uint32_t i = 0; i < FRAMES; i++)
                     vk->destroy_descriptorpool(pools[i]);
             };
 
     };
 
+    // running counts of sets allocated and descriptors written since creation.
+    struct DescriptorStats{
+        uint64_t allocations = 0;
+        uint64_t writes = 0;
+    };
+
+    // sets of one pool, usedSets is the fullest frame slot right now.
+    struct DescriptorPoolUsage{
+        uint32_t maxSets = 0;
+        uint32_t usedSets = 0;
+        uint32_t peakSets = 0;
+    };
+
     class DescriptorSetManager
     {
 
     public:
-        DescriptorSetManager(std::shared_ptr<VulkanInstance> vulkan, uint32_t maximumSets);
+        // maximumSets caps the sets of a single pool,
+        // pools start at initialSets and double for each new pool of the same layout counts.
+        DescriptorSetManager(std::shared_ptr<VulkanInstance> vulkan, uint32_t maximumSets,
+                             uint32_t initialSets = 32);
         ~DescriptorSetManager();
         Handle<DescriptorSetLayout> getLayout(const DescriptorSetLayoutDesc& description);
         DescriptorSetLayout& getLayoutContent(const Handle<DescriptorSetLayout>& handle);
@@ -132,12 +176,22 @@ namespace boitatah::vk
                      uint32_t set_index);
         void resetPools(uint32_t frame_index);
 
+        // memory for the scratch of set writes, released by its owner every frame.
+        void setFrameResource(std::pmr::memory_resource* resource);
+        std::pmr::memory_resource* getFrameResource() const;
+
+        const DescriptorStats& getStats() const;
+        void getPoolUsage(std::vector<DescriptorPoolUsage>& usage) const;
+
     private:
         // Members
         std::shared_ptr<VulkanInstance> m_vk;
         uint32_t maxSets = 4096;
+        uint32_t m_initialSets = 32;
         std::vector<DescriptorSetPool<3>> m_pools;
-        std::unique_ptr<descriptor_sets::DescriptorSetTree> m_descriptorTree;
+        std::unique_ptr<descriptor_sets::DescriptorSetLayoutCache> m_layoutCache;
+        std::pmr::memory_resource* m_frameResource = std::pmr::get_default_resource();
+        DescriptorStats m_stats;
 
         // Handle<DescriptorSetLayout> createLayout(const DescriptorSetLayoutDesc& description);
         // DescriptorSetLayout findCreateLayout(const DescriptorSetLayoutDesc& description);
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <type_traits>
+#include <vector>
 
 #include <boitatah/backend/vulkan/Vulkan.hpp>
 #include <boitatah/commands/CommandBufferWriter.hpp>
@@ -22,6 +24,9 @@ namespace boitatah
     template<typename Resource, int Copies>
     class GPUResource;
 
+    //buffers created and textures written at least this large upload on the transfer queue.
+    constexpr VkDeviceSize ASYNC_UPLOAD_THRESHOLD = 256u * 1024u;
+
     class GPUResourceManager : public std::enable_shared_from_this<GPUResourceManager>
     {
         
@@ -31,6 +36,7 @@ namespace boitatah
             GPUResourceManager(std::shared_ptr<vk::VulkanInstance> vk_instance,
                                std::shared_ptr<buffer::BufferManager> bufferManager,
                                std::shared_ptr<ImageManager> imageManager,
+                               std::shared_ptr<vk::VkSubmissionList> submissions,
                                uint32_t buffer_writer_count); //contructor
 
             ~GPUResourceManager();
@@ -38,11 +44,44 @@ namespace boitatah
             vk::VkCommandBufferWriter& getCurrentBufferWriter(){
                 return *m_buffer_writers[m_current_writer];
             }
+
+            //transfer batch being recorded, one per beginCommitCommands.
+            uint64_t getCommitBatch() const;
+            //the batch's timeline value was reached.
+            bool isBatchComplete(uint64_t batch);
+            //a batch still recording has nothing in flight and returns.
+            void waitForBatch(uint64_t batch);
+
+            //records the upload of every copy on the transfer queue,
+            //the buffer stays hidden from draws until acquireUploads shows it.
+            void uploadAsync(Handle<GPUBuffer> handle);
+            //same for a texture written by copyImageFromBuffer,
+            //materials sampling it are not drawn until acquireUploads shows it.
+            void uploadAsync(Handle<RenderTexture> handle);
+            //copyImageFromBuffer, then uploadAsync from ASYNC_UPLOAD_THRESHOLD up.
+            void uploadTexture(Handle<RenderTexture> handle, void* data);
+            //some texture is waiting for its acquire.
+            bool hasHiddenTextures() const;
+            //queues the uploads recorded since the last call.
+            void submitUploads();
+            //acquires finished uploads on the writer's queue and shows them.
+            void acquireUploads(vk::VkCommandBufferWriter& writer);
+
+            template<typename ResourceType>
+            bool isVisible(Handle<ResourceType> handle);
+            //visible once all of its buffers are.
+            bool isVisible(Handle<Geometry> handle);
+
+            //runs releases of destroyed resources the GPU is done with.
+            //call once per frame, after the previous frame was flushed.
+            void collectReleases();
             
             std::shared_ptr<buffer::BufferManager> getBufferManager();
 
             ImageManager& getImageManager();
 
+            void getPoolStats(std::vector<PoolStats>& stats) const;
+
 
             template<typename ResourceType>
             bool checkReady( Handle<ResourceType>    handle, 
@@ -74,6 +113,9 @@ namespace boitatah
 
             void submitCommitCommands();
 
+            //commands of every commit and upload batch submitted since creation.
+            const vk::VulkanWriterStats& getCommandStats() const;
+
             void beginNewCommitCommands();
 
             template<typename ResourceType>
@@ -137,8 +179,41 @@ namespace boitatah
             std::shared_ptr<ImageManager>           m_imageManager;
             
             std::unique_ptr<GPUResourcePool>            m_resourcePool;
+            std::shared_ptr<vk::VkSubmissionList>       m_submissions;
             std::vector<std::shared_ptr<vk::VkCommandBufferWriter>> m_buffer_writers;
-            uint32_t m_current_writer;
+            uint32_t m_current_writer = 0;
+            uint64_t m_commitBatch = 0;
+            vk::VulkanWriterStats m_commandStats;
+
+            //destroyed resources, released once the frontier
+            //stamped at the next collectReleases is complete.
+            struct DeferredRelease{
+                vk::TimelineFrontier    frontier;
+                bool                    stamped = false;
+                std::function<void()>   release;
+            };
+            std::vector<DeferredRelease> m_deferredReleases;
+
+            //transfer queue uploads, their batch ids carry UPLOAD_BATCH_BIT.
+            static constexpr uint64_t UPLOAD_BATCH_BIT = 1ull << 63;
+            struct PendingAcquire{
+                vk::TimelinePoint                          point;
+                std::vector<Handle<GPUBuffer>>             buffers;
+                //two acquires per buffer, empty with a single family.
+                std::vector<vk::VulkanWriterBufferBarrier> barriers;
+                std::vector<Handle<RenderTexture>>         textures;
+                //one acquire per texture copy, empty with a single family.
+                std::vector<vk::VulkanWriterTransitionLayout> imageBarriers;
+                //re-uploads wait on everything queued before them.
+                bool                                       waitFrontier = false;
+            };
+            std::vector<std::shared_ptr<vk::VkCommandBufferWriter>> m_upload_writers;
+            uint64_t m_uploadBatch = 0;
+            bool uploadRecording = false;
+            PendingAcquire m_recordingUpload;
+            std::vector<PendingAcquire> m_pendingAcquires;
+            uint32_t m_hiddenTextures = 0;
+            void beginUploadCommands();
             void commitGeometryData( Geometry& geo );
 
             bool recording = false;
@@ -150,7 +225,15 @@ namespace boitatah
         inline bool GPUResourceManager::checkReady(Handle<ResourceType> handle, uint32_t frame_index)
         {
             auto& resource = getResource(handle);
-            return resource.self().ready_for_use(frame_index);
+            return resource.self().ready_for_use(frame_index) &&
+                   resource.is_visible() &&
+                   isBatchComplete(resource.get_upload_batch(frame_index));
+        }
+
+        template <typename ResourceType>
+        inline bool GPUResourceManager::isVisible(Handle<ResourceType> handle)
+        {
+            return getResource(handle).is_visible();
         }
 
         template <typename ResourceType>
@@ -180,8 +263,12 @@ namespace boitatah
         template <typename ResourceType>
         inline void GPUResourceManager::destroy(const Handle<ResourceType> &handle)
         {
-            auto& resource = getResource(handle);
-            resource.release();
+            //the GPU may still read it, release a copy later.
+            m_deferredReleases.push_back({
+                .release = [resource = getResource(handle)]() mutable {
+                    resource.release();
+                }
+            });
             m_resourcePool->clear(handle);
         }
 
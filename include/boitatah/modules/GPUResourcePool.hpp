@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include <boitatah/collections.hpp>
 #include <boitatah/resources/GPUBuffer.hpp>
@@ -27,12 +28,16 @@ namespace boitatah{
             bool update(Handle<GPUBuffer> handle, GPUBuffer& item); 
             bool clear(Handle<GPUBuffer> handle, GPUBuffer& item);
             bool clear(Handle<GPUBuffer> handle);
+            bool contains(Handle<GPUBuffer> handle);
 
             RenderTexture& get(Handle<RenderTexture> handle);
             Handle<RenderTexture>  set(RenderTexture& item);
             bool update(Handle<RenderTexture> handle, RenderTexture& item); 
             bool clear(Handle<RenderTexture> handle, RenderTexture& item);
             bool clear(Handle<RenderTexture> handle);
+            bool contains(Handle<RenderTexture> handle);
+
+            void getPoolStats(std::vector<PoolStats>& stats) const;
 
             // FixedTexture& get(Handle<FixedTexture> handle);
             // Handle<FixedTexture>  set(FixedTexture& item);
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include <boitatah/backend/vulkan/Vulkan.hpp>
+#include <boitatah/backend/vulkan/VkCommandBufferWriter.hpp>
+#include <boitatah/modules/Profiler.hpp>
+
+namespace boitatah
+{
+    ///GPU time of a scope of the last frame read back.
+    struct GpuTiming{
+        const char* name;
+        double      ms;
+    };
+
+    ///Timestamp queries around ranges of recorded commands, one slice of queries per frame slot.
+    /// A slot is read back without waiting when it comes around again, once the renderer
+    /// waited for the submissions of its last frame, and the scopes go to a "gpu" trace track.
+    /// Disabled when the device can't time the graphics queue, scopes then record nothing.
+    /// Not thread safe, scopes are written from the rendering thread.
+    class GpuProfiler{
+        public:
+            GpuProfiler(std::shared_ptr<vk::VulkanInstance> vk_instance,
+                        uint32_t slots,
+                        bool enable,
+                        uint32_t maxScopes = 64);
+            ~GpuProfiler();
+
+            GpuProfiler(const GpuProfiler&) = delete;
+            GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+            bool isEnabled() const;
+
+            //reads back the last frame of slot and resets its queries,
+            //the submissions of that frame must be complete.
+            void beginFrame(uint32_t slot);
+            //call right before the frame goes to the queues,
+            //its scopes are placed from this time on the trace.
+            void endFrame();
+
+            //names must outlive the profiler, see profiler::intern.
+            //returns UINT32_MAX outside a frame or when the slice is full, endScope ignores it.
+            uint32_t beginScope(vk::VkCommandBufferWriter& writer, const char* name);
+            void endScope(vk::VkCommandBufferWriter& writer, uint32_t scope);
+
+            //scopes of the last frame read back, in recording order.
+            std::span<const GpuTiming> getTimings() const;
+
+        private:
+            struct FrameSlice{
+                std::vector<const char*>    names;
+                uint64_t                    submitted = 0;
+            };
+
+            std::shared_ptr<vk::VulkanInstance> m_vk;
+            VkQueryPool                         m_pool = VK_NULL_HANDLE;
+            bool                                m_enabled = false;
+
+            uint32_t                            m_maxScopes;
+            double                              m_period;
+            uint64_t                            m_mask;
+
+            std::vector<FrameSlice>             m_slices;
+            uint32_t                            m_slot = 0;
+            bool                                m_open = false;
+
+            std::vector<uint64_t>               m_results;
+            std::vector<GpuTiming>              m_timings;
+            profiler::ThreadRing*               m_track = nullptr;
+
+            void readBack(FrameSlice& slice, uint32_t first);
+    };
+}
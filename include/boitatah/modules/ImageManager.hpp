@@ -4,16 +4,28 @@
 #include <boitatah/types/Image.hpp>
 #include <boitatah/backend/vulkan/Vulkan.hpp>
 #include <memory>
+#include <span>
+#include <vector>
 
 
 namespace boitatah{
 
+    //live images of one format and usage.
+    struct ImageMemoryStats{
+        IMAGE_FORMAT format;
+        IMAGE_USAGE usage;
+        uint32_t count = 0;
+        VkDeviceSize bytes = 0;
+    };
+
     class ImageManager{
         private:
             std::shared_ptr<vk::VulkanInstance> m_vk;
             std::unique_ptr<Pool<Image>> m_imagePool;
             std::unique_ptr<Pool<Sampler>> m_sampler_pool;
+            std::vector<ImageMemoryStats> m_memoryStats;
             void destroySampler(VkSampler sampler);
+            ImageMemoryStats& memoryStats(const Image& image);
 
         public:
             ImageManager(std::shared_ptr<vk::VulkanInstance> vulkan);
@@ -27,6 +39,10 @@ namespace boitatah{
             bool contains (Handle<Image>& handle);
             void destroyImage(const Handle<Image>& handle);
             Image& getImage(Handle<Image> &handle);
+
+            //one entry per format and usage ever created, swapchain images excluded.
+            std::span<const ImageMemoryStats> getMemoryStats() const;
+            void getPoolStats(std::vector<PoolStats>& stats) const;
     };
 
 
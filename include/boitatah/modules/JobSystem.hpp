@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace boitatah{
+
+    class JobSystem;
+
+    ///Counts the pending jobs of a group.
+    /// Jobs queued with run_after start once the counter reaches zero.
+    class JobCounter{
+        friend class JobSystem;
+        public:
+            JobCounter() = default;
+            //the last finishing job may still hold the lock after done().
+            ~JobCounter(){ std::lock_guard lock(m_mutex); };
+            JobCounter(const JobCounter&) = delete;
+            JobCounter& operator=(const JobCounter&) = delete;
+
+            bool done() const { return m_pending.load(std::memory_order_acquire) == 0; };
+
+        private:
+            struct Continuation{
+                JobCounter*             counter;
+                std::function<void()>   work;
+            };
+
+            std::atomic<uint32_t>       m_pending{0};
+            std::mutex                  m_mutex;
+            std::vector<Continuation>   m_continuations;
+    };
+
+    ///Work stealing scheduler.
+    /// Every worker owns a deque, it pops its newest job and
+    /// steals the oldest job of another worker when its own is empty.
+    /// Threads outside the system push to a shared deque and
+    /// run jobs while they wait on a counter.
+    class JobSystem{
+        public:
+            //threads counts the calling thread, 0 uses one per core.
+            JobSystem(uint32_t threads = 0);
+            ~JobSystem();
+
+            JobSystem(const JobSystem&) = delete;
+            JobSystem& operator=(const JobSystem&) = delete;
+
+            //queues a job, counter is decremented when it finishes.
+            void run(JobCounter& counter, std::function<void()> job);
+
+            //queues a job once dependency reaches zero.
+            void run_after(JobCounter& dependency, JobCounter& counter, std::function<void()> job);
+
+            //runs queued jobs until the counter reaches zero.
+            void wait(JobCounter& counter);
+
+            //calls body(begin, end) over [0, count) in ranges of at least grain,
+            //returns when every range is done.
+            //jobs capturing up to 16 trivially copyable bytes don't allocate, the ranges fit.
+            void parallel_for(uint32_t count,
+                              uint32_t grain,
+                              const std::function<void(uint32_t, uint32_t)>& body);
+
+            //worker threads plus the calling thread.
+            uint32_t thread_count() const;
+
+        private:
+            struct Job{
+                JobCounter*             counter;
+                std::function<void()>   work;
+            };
+
+            //ring of jobs, it grows by doubling and keeps its storage,
+            //so a steady frame queues jobs without allocating.
+            struct WorkerQueue{
+                std::mutex          mutex;
+                std::vector<Job>    jobs;
+                uint32_t            head = 0;
+                uint32_t            count = 0;
+            };
+
+            //queue 0 is shared by threads outside the system.
+            std::vector<std::unique_ptr<WorkerQueue>>   m_queues;
+            std::vector<std::thread>                    m_threads;
+
+            std::atomic<bool>                           m_running{true};
+            std::atomic<uint32_t>                       m_queued{0};
+            std::mutex                                  m_sleepMutex;
+            std::condition_variable                     m_wake;
+
+            void push(Job job);
+            bool pop(uint32_t queue, Job& job);
+            bool steal(uint32_t thief, Job& job);
+            bool run_one(uint32_t queue);
+            void finish(JobCounter& counter);
+            void worker_loop(uint32_t queue);
+            uint32_t current_queue() const;
+    };
+}
@@ -7,10 +7,16 @@
 
 #include <boitatah/modules/RenderTargetManager.hpp>
 #include <boitatah/modules/GPUResourceManager.hpp>
+#include <boitatah/modules/JobSystem.hpp>
+#include <boitatah/modules/Profiler.hpp>
 #include <boitatah/BoitatahEnums.hpp>
+#include <array>
 #include <unordered_map>
 #include <unordered_set>
 #include <memory>
+#include <future>
+#include <mutex>
+#include <string_view>
 
 namespace boitatah{
 
@@ -35,6 +41,92 @@ namespace boitatah{
     };
 
 
+    // a shader plus the specialization constants that made a variant of it.
+    struct ShaderVariantKey{
+        Handle<Shader> shader;
+        std::vector<SpecializationConstant> constants;
+
+        bool operator==(const ShaderVariantKey &other) const = default;
+    };
+
+    struct ShaderVariantKeyHasher{
+        std::size_t operator()(const ShaderVariantKey& key) const{
+            std::size_t res = HandleHasher()(key.shader);
+            for(auto& constant : key.constants){
+                res = res * 31 + std::hash<uint32_t>()(constant.id);
+                res = res * 31 + std::hash<uint32_t>()(constant.value);
+            }
+            return res;
+        }
+    };
+
+    // pipeline layout content, set layout handles are already deduped by content.
+    struct PipelineLayoutKey{
+        std::vector<Handle<DescriptorSetLayout>> setLayouts;
+        std::vector<uint32_t> pushConstants; //offset, size, stages
+
+        bool operator==(const PipelineLayoutKey &other) const = default;
+    };
+
+    struct PipelineLayoutKeyHasher{
+        std::size_t operator()(const PipelineLayoutKey& key) const{
+            std::size_t res = 17;
+            for(auto& layout : key.setLayouts)
+                res = res * 31 + HandleHasher()(layout);
+            for(auto& value : key.pushConstants)
+                res = res * 31 + std::hash<uint32_t>()(value);
+            return res;
+        }
+    };
+
+    // a shader stage's bytecode, interned by the ShaderManager and hashed once.
+    // the hash only buckets, equal keys share the interned copy or the same bytes.
+    struct ShaderCodeKey{
+        std::size_t hash;
+        std::shared_ptr<const std::vector<char>> code;
+
+        bool operator==(const ShaderCodeKey &other) const{
+            return hash == other.hash && (code == other.code || *code == *other.code);
+        }
+    };
+
+    // everything that ends up in the VkGraphicsPipelineCreateInfo.
+    struct PipelineKey{
+        ShaderCodeKey vert;
+        std::string vertEntry;
+        ShaderCodeKey frag;
+        std::string fragEntry;
+        VkRenderPass renderpass;
+        VkPipelineLayout layout;
+        bool use_depth;
+        std::size_t colorBlends;
+        std::vector<uint32_t> vertexInput; //binding, stride, then location, format, offset per attribute
+        std::vector<SpecializationConstant> specialization;
+
+        bool operator==(const PipelineKey &other) const = default;
+    };
+
+    struct PipelineKeyHasher{
+        std::size_t operator()(const PipelineKey& key) const{
+            std::size_t res = 17;
+            res = res * 31 + key.vert.hash;
+            res = res * 31 + key.frag.hash;
+            res = res * 31 + std::hash<std::string>()(key.vertEntry);
+            res = res * 31 + std::hash<std::string>()(key.fragEntry);
+            res = res * 31 + std::hash<VkRenderPass>()(key.renderpass);
+            res = res * 31 + std::hash<VkPipelineLayout>()(key.layout);
+            res = res * 31 + std::hash<bool>()(key.use_depth);
+            res = res * 31 + std::hash<std::size_t>()(key.colorBlends);
+            for(auto& value : key.vertexInput)
+                res = res * 31 + std::hash<uint32_t>()(value);
+            for(auto& constant : key.specialization){
+                res = res * 31 + std::hash<uint32_t>()(constant.id);
+                res = res * 31 + std::hash<uint32_t>()(constant.value);
+            }
+            return res;
+        }
+    };
+
     class ShaderManager{
         private:
             std::shared_ptr<VulkanInstance> m_vk;
@@ -47,35 +139,115 @@ namespace boitatah{
             std::shared_ptr<RenderTargetManager> m_targetManager;
             std::shared_ptr<DescriptorSetManager> m_descriptorManager;
 
+            //pipeline create data resolved on the calling thread,
+            // everything here is safe to hand to a compile worker.
+            struct ShaderBuild{
+                Shader shader;
+                ShaderDescVk description;
+                ShaderCodeKey vertCode;
+                ShaderCodeKey fragCode;
+            };
+
+            // identical create infos share one object, destroyed with the last user.
+            struct CachedLayout{
+                Handle<ShaderLayout> layout;
+                uint32_t users;
+            };
+            struct CachedPipeline{
+                std::shared_future<Handle<Shader>> shader;
+                uint32_t users;
+            };
+            std::unordered_map<PipelineLayoutKey, CachedLayout, PipelineLayoutKeyHasher> m_layoutCache;
+            std::unordered_map<PipelineKey, CachedPipeline, PipelineKeyHasher> m_pipelineCache;
+            //one copy of each distinct bytecode, shared by the pipeline keys.
+            std::unordered_multimap<std::size_t, std::shared_ptr<const std::vector<char>>> m_byteCode;
+            ShaderCodeKey internCode(const std::vector<char> &byteCode);
+            PipelineKey pipelineKey(const ShaderBuild &build);
+
+            std::unordered_map<ShaderVariantKey, Handle<Shader>, ShaderVariantKeyHasher> m_variants;
+
+            //a makeShaders call, one compile job per build.
+            //handles are taken on the calling thread, so the workers never grow the pool.
+            struct ShaderBatch{
+                std::vector<ShaderBuild> builds;
+                std::vector<Handle<Shader>> handles;
+                std::vector<std::promise<Handle<Shader>>> promises;
+                JobCounter counter;
+            };
+            JobSystem* m_jobs;
+            std::vector<std::shared_ptr<ShaderBatch>> m_compileBatches;
+            //guards the pool's free list and storage against the compile workers.
+            std::mutex m_shaderPoolMutex;
+            //reserved by a batch and not built yet, isValid reports them invalid.
+            std::unordered_set<Handle<Shader>, HandleHasher> m_pendingShaders;
+
             ShaderModule compileShaderModule(const std::vector<char>& bytecode, 
                                              std::string entryPoint);
+            ShaderBuild prepareShader(const MakeShaderDesc &data);
+            void buildShader(ShaderBuild &build);
+            Handle<Shader> storeShader(Shader &shader);
+            Handle<Shader> reserveShader();
+            //runs on the compile workers, the handle comes from reserveShader.
+            void fillShader(Handle<Shader> handle, Shader &shader);
+            void releaseShader(Handle<Shader> handle);
             void updateShadersForRenderPass(Handle<Renderpass> renderPass);
             void updateShadersForRenderTarget(Handle<Renderpass> renderPass);
             void updateShadersForRenderTarget(std::vector<Handle<Shader>>& shaders,
                                               Handle<Renderpass> renderPass);
-            void reflectShader();
 
         public:
             ShaderManager(std::shared_ptr<VulkanInstance> vulkan, 
                          std::shared_ptr<RenderTargetManager> targetManager,
-                         std::shared_ptr<DescriptorSetManager> descriptorManager);
+                         std::shared_ptr<DescriptorSetManager> descriptorManager,
+                         JobSystem* jobs);
+            ~ShaderManager();
 
             ShaderLayout& get(const Handle<ShaderLayout>& handle);
             Shader& get(const Handle<Shader>& handle);
             bool isValid(Handle<Shader>& handle);
             bool isValid(Handle<ShaderLayout>& handle);
             Handle<ShaderLayout> makeShaderLayout(const ShaderLayoutDesc& description);
+            // Makes a layout from reflected data.
+            // the first overrides.size() sets use the overrides instead of the reflected sets,
+            // so materials can keep sharing their base material bindings.
+            Handle<ShaderLayout> makeShaderLayout(const ShaderReflection& reflection,
+                                                  const std::vector<Handle<DescriptorSetLayout>>& overrides = {});
+            // Reads vertex inputs, descriptor sets and push constants from the stages bytecode.
+            ShaderReflection reflectShader(const ShaderStage& vert, const ShaderStage& frag);
             Handle<Shader> makeShader(const MakeShaderDesc &data); //a shader is a pipeline
+            
+            // Compiles a batch of shaders concurrently on the job system.
+            // futures are in the same order as descriptions, get() them before using the handles.
+            // with a single job thread nothing runs the jobs until waitShaderCompilation.
+            std::vector<std::shared_future<Handle<Shader>>> makeShaders(
+                                                const std::vector<MakeShaderDesc> &descriptions);
+            // Blocks until every batch sent to makeShaders is done.
+            void waitShaderCompilation();
+
+            // Gets the pipeline of shader specialized with constants, building it on first use.
+            // constants override the ones already in the shader description.
+            // variants are destroyed with their base shader.
+            Handle<Shader> getVariant(const Handle<Shader>& shader,
+                                      std::vector<SpecializationConstant> constants);
             void destroy(Handle<Shader>& handle);
             void destroy(Handle<ShaderLayout>& handle);
     };
 
+    // what recording a material's binds needs.
+    struct MaterialDrawData{
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        VkPipelineLayout layout = VK_NULL_HANDLE;
+        std::array<VkDescriptorSet, vk::VkCommandBufferWriter::MAX_BOUND_SETS> sets{};
+        uint32_t setCount = 0;
+    };
+
     class MaterialManager{
         public:
             MaterialManager(std::shared_ptr<VulkanInstance> vulkan, 
                             std::shared_ptr<RenderTargetManager> targetManager,
                             std::shared_ptr<DescriptorSetManager> setManager,
-                            std::shared_ptr<GPUResourceManager> resourceManager);
+                            std::shared_ptr<GPUResourceManager> resourceManager,
+                            JobSystem* jobs);
             ShaderManager& getShaderManager();
             
             const std::vector<Handle<Material>> orderMaterials();
@@ -116,6 +288,11 @@ namespace boitatah{
                                              const Handle<GPUBuffer>                    &gpu_buffer,
                                              const uint32_t                             set, 
                                              const uint32_t                             binding);
+            //valid until the transient region is recycled, rebind every frame.
+            bool setTransientBindingAttribute(const Handle<Material> material,
+                                             const BufferAccessData                     &access,
+                                             const uint32_t                             set, 
+                                             const uint32_t                             binding);
             bool setImageBindingAttribute   (const Handle<Material> material,
                                              const Handle<Image>                        &image,
                                              const uint32_t                             set, 
@@ -134,132 +311,46 @@ namespace boitatah{
 
             //std::vector<Handle<MaterialBinding>> createUnlitMaterialBindings();
             
+            // Pipeline and descriptor sets of a material for this frame.
+            // sets are allocated and written here, so recording the result
+            // needs no manager state and can run on any thread.
+            bool ResolveMaterial(Handle<Material>    &handle,
+                                 uint32_t            frame_index,
+                                 MaterialDrawData    &data);
+
             template <typename BufferWriterType>
             bool BindMaterial(CommandBufferWriter<BufferWriterType> &writer,
                                             Handle<Material>  &handle, 
                                             uint32_t         frame_index)
             {
-                auto& material = m_materialPool->get(handle);
-                auto& shader = m_shaderManager->get(material.shader);
-
-                m_currentBindings.resize(material.bindings.size());
-
-                bool success = true;
-                if(material.shader && m_currentPipeline != material.shader){
-                    success &= BindPipeline(writer, material.shader);
-                }else{
-                    std::runtime_error("failed to bind pipeline");
-                }
-        
-                for(uint32_t i = 0; i < material.bindings.size(); i++){
-                    success &= BindBinding( writer,
-                                            material.bindings[i],
-                                            shader.layout,
-                                            shader.layout.descriptorSets[i],
-                                            i,
-                                            frame_index);
-                }
+                MaterialDrawData data;
+                bool success = ResolveMaterial(handle, frame_index, data);
+                BindMaterialData(writer, data);
                 return success;
             }
 
             template <typename BufferWriterType>
-            bool BindPipeline(CommandBufferWriter<BufferWriterType> &writer,
-                                       Handle<Shader> &handle)
-            {
-                if(!handle)
-                    return false;
-
-                if(!m_shaderManager->isValid(handle))
-                    return false;
-
-                if(m_currentPipeline == handle)
-                    return true;
-
-                m_currentPipeline = handle;
-
-                auto pipeline = m_shaderManager->get(m_currentPipeline).pipeline;
-                writer.bind_pipeline({.pipeline = pipeline,});
-                return true;
-            }
-
-            template <typename BufferWriterType>
-            bool BindBinding(CommandBufferWriter<BufferWriterType> &writer,
-                                    Handle<MaterialBinding>         &handle,
-                                    ShaderLayout                    &shaderLayout,
-                                    Handle<DescriptorSetLayout>     setLayout,
-                                    uint32_t                        set_index,
-                                    uint32_t                        frame_index)
+            static void BindMaterialData(CommandBufferWriter<BufferWriterType> &writer,
+                                         const MaterialDrawData                &data)
             {
-                //invalid binding
-                if(!m_bindingsPool->contains(handle)){
-                    //std::cout << " skipped binding " << set_index << " invalid handle." << std::endl;
-                    return false;
-                }
-                
-                //already bound
-                if(m_currentBindings[set_index] == handle){
-                    //std::cout << " skipped binding " << set_index << " already bound." << std::endl;
-                    return true;
+                BOITATAH_ZONE("MaterialManager::BindMaterialData");
+                if(data.pipeline != VK_NULL_HANDLE)
+                    writer.bind_pipeline({.pipeline = data.pipeline,});
+
+                for(uint32_t i = 0; i < data.setCount; i++){
+                    //invalid bindings are left unbound.
+                    if(data.sets[i] == VK_NULL_HANDLE)
+                        continue;
+                    writer.bind_set({   data.layout,
+                                        data.sets[i],
+                                        i});
                 }
-
-                m_currentBindings[set_index] = handle;
-                auto& binding = getBinding(handle);
-
-
-                auto& layoutContent = m_descriptorManager->getLayoutContent(setLayout);
-                auto set = m_descriptorManager->getSet(layoutContent, frame_index);
-                
-                std::vector<BindBindingDesc> bindings;
-                for(int i = 0; i < binding.bindings.size(); i++){
-                    BindBindingDesc desc;
-                    desc.binding = i;
-                    desc.type = binding.bindings[i].type;
-                    switch(desc.type){
-                        case DESCRIPTOR_TYPE::UNIFORM_BUFFER:
-                            desc.access.bufferData = m_resourceManager->
-                                                            getCommitResourceAccessData(
-                                                                binding.bindings[i].binding_handle.buffer,
-                                                                frame_index);
-                            break;
-                            
-                        case DESCRIPTOR_TYPE::COMBINED_IMAGE_SAMPLER:
-                            desc.access.textureData = m_resourceManager->
-                                                            getCommitResourceAccessData(
-                                                                binding.bindings[i].binding_handle.renderTex,
-                                                            frame_index);
-                            break;
-
-                        case DESCRIPTOR_TYPE::IMAGE:{
-                            auto& image = m_resourceManager->getImageManager().
-                                                            getImage(
-                                                                binding.bindings[i].binding_handle.image);
-                            desc.access.imageData = {.view = image.view};
-                            break;} 
-
-                        case DESCRIPTOR_TYPE::SAMPLER:{
-                            auto& sampler = m_resourceManager->getImageManager().
-                                                getSampler(binding.bindings[i].binding_handle.sampler);
-                            desc.access.samplerData = {.sampler = sampler.sampler};
-                            break; }
-
-                    }
-
-                    bindings.push_back(desc);
-                }
-                m_descriptorManager->writeSet(bindings,    
-                                            set, 
-                                            frame_index);
-
-                writer.bind_set({   shaderLayout.pipeline,
-                                    set.descriptorSet,
-                                    set_index});
-
-
-                return true;
             }
             
             void resetBindings();
 
+            void getPoolStats(std::vector<PoolStats>& stats) const;
+
             void clearBaseMaterials();
 
         private:
@@ -276,8 +367,16 @@ namespace boitatah{
 
              std::vector<Handle<Material>> current_Materials;
 
+            //sets written since resetBindings, reused while the binding stays the same.
             std::vector<Handle<MaterialBinding>> m_currentBindings;
-            Handle<Shader> m_currentPipeline;
+            std::vector<VkDescriptorSet> m_currentSets;
+
+            VkDescriptorSet resolveBinding(Handle<MaterialBinding>      &handle,
+                                           Handle<DescriptorSetLayout>  setLayout,
+                                           uint32_t                     set_index,
+                                           uint32_t                     frame_index);
+            //no sampled texture is waiting for its transfer queue acquire.
+            bool texturesVisible(Material& material);
 
     };
 };
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <boitatah/backend/vulkan/Vulkan.hpp>
+#include <boitatah/buffers/BufferManager.hpp>
+#include <boitatah/collections/Pool.hpp>
+#include <boitatah/modules/DescriptorSetManager.hpp>
+#include <boitatah/modules/ImageManager.hpp>
+
+namespace boitatah
+{
+    ///Memory limits, checked once per frame. 0 disables a limit.
+    ///     deviceLocal:    bytes allocated from device local heaps.
+    ///     hostVisible:    bytes allocated from the other heaps.
+    ///     staging:        bytes reserved in transfer source buffers.
+    ///     heapUsage:      fraction of a heap's driver budget the process may use,
+    ///                     only checked with VK_EXT_memory_budget.
+    struct MemoryBudget{
+        uint64_t deviceLocal = 0;
+        uint64_t hostVisible = 0;
+        uint64_t staging = 0;
+        float heapUsage = 0.9f;
+    };
+
+    ///Upload memory: transfer source buffers and the transient ring,
+    /// transientUsed is the region of the frame being recorded.
+    struct StagingMemoryStats{
+        uint64_t reserved = 0;
+        uint64_t capacity = 0;
+        uint64_t transientUsed = 0;
+        uint64_t transientCapacity = 0;
+    };
+
+    ///GPU memory of the renderer when it was made, see Renderer::getMemoryReport.
+    ///     heaps:              device memory heaps, allocated by the renderer and in use by the process.
+    ///     buffers:            every live buffer of the buffer manager.
+    ///     images:             live images per format and usage.
+    ///     descriptorPools:    sets of every descriptor pool.
+    ///     pools:              handle pools of the managers, with their high water marks.
+    ///     warnings:           the MemoryBudget limits exceeded.
+    struct MemoryReport{
+        std::vector<vk::MemoryHeapUsage> heaps;
+        std::vector<buffer::BufferMemoryStats> buffers;
+        StagingMemoryStats staging;
+        std::vector<ImageMemoryStats> images;
+        std::vector<vk::DescriptorPoolUsage> descriptorPools;
+        std::vector<PoolStats> pools;
+        std::vector<std::string> warnings;
+
+        std::string toJson() const;
+    };
+
+    namespace memory_budget{
+        //one bit per limit, in MemoryBudget order.
+        //allocation free, the renderer checks it every frame.
+        uint32_t exceeded(const MemoryBudget& budget,
+                          std::span<const vk::MemoryHeapUsage> heaps,
+                          uint64_t staging);
+
+        //a line for each limit set in exceeded.
+        void describe(uint32_t exceeded,
+                      const MemoryBudget& budget,
+                      std::span<const vk::MemoryHeapUsage> heaps,
+                      uint64_t staging,
+                      std::vector<std::string>& lines);
+    }
+}
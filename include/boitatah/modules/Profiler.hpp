@@ -0,0 +1,97 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include <boitatah/modules/AllocAudit.hpp>
+
+///Scoped CPU zones, compiled in with BOITATAH_PROFILER (cmake -DBOITATAH_PROFILER=ON).
+/// Without it the macros expand to nothing.
+///
+///     void Renderer::render_tree(...){
+///         BOITATAH_ZONE("render_tree");
+///         ...
+///     }
+///
+/// Zone names must outlive the program, string literals or __func__.
+#ifdef BOITATAH_PROFILER
+    #define BOITATAH_ZONE_CONCAT_INNER(a, b) a##b
+    #define BOITATAH_ZONE_CONCAT(a, b) BOITATAH_ZONE_CONCAT_INNER(a, b)
+    #define BOITATAH_ZONE(name) ::boitatah::profiler::Zone BOITATAH_ZONE_CONCAT(boitatah_zone_, __LINE__)(name)
+    #define BOITATAH_ZONE_FUNCTION() BOITATAH_ZONE(__func__)
+    #define BOITATAH_PROFILER_THREAD(name) ::boitatah::profiler::set_thread_name(name)
+#else
+    #define BOITATAH_ZONE(name) ((void)0)
+    #define BOITATAH_ZONE_FUNCTION() ((void)0)
+    #define BOITATAH_PROFILER_THREAD(name) ((void)0)
+#endif
+
+namespace boitatah::profiler{
+
+    //zones kept per thread, older ones are overwritten.
+    constexpr uint32_t PROFILER_RING_ZONES = 1 << 16;
+
+    ///A finished zone, fields are atomics so a dump may read a ring while its thread writes.
+    struct ZoneRecord{
+        std::atomic<const char*>    name{nullptr};
+        std::atomic<uint64_t>       begin{0};
+        std::atomic<uint64_t>       end{0};
+    };
+
+    ///Zones of one thread, written only by that thread.
+    /// head counts every zone written, the last PROFILER_RING_ZONES are kept.
+    struct ThreadRing{
+        std::array<ZoneRecord, PROFILER_RING_ZONES> zones;
+        std::atomic<uint64_t>   head{0};
+        uint32_t                id = 0;
+        std::atomic<const char*> name{nullptr};
+    };
+
+    //nanoseconds on the steady clock.
+    uint64_t now_ns();
+
+    //names the calling thread in traces.
+    void set_thread_name(const char* name);
+
+    //appends a zone to the calling thread's ring, registering it on first use.
+    void record_zone(const char* name, uint64_t begin, uint64_t end);
+
+    ///A ring that isn't bound to a thread, for timelines measured elsewhere like a gpu queue.
+    /// Shown as its own row in traces, written by one thread at a time.
+    ThreadRing& create_track(const char* name);
+
+    //appends a zone to a ring made by create_track.
+    void record_track_zone(ThreadRing& track, const char* name, uint64_t begin, uint64_t end);
+
+    //a copy of text kept for the whole program, for zone names built at runtime.
+    const char* intern(const std::string& text);
+
+    ///Writes every ring as Chrome trace event JSON, loadable in chrome://tracing and Perfetto.
+    ///Zones are complete events, nesting follows from their times on each thread.
+    void write_chrome_trace(const std::string& path);
+
+    ///Times its scope, placed by BOITATAH_ZONE.
+    class Zone{
+        public:
+            Zone(const char* name) : m_name(name), m_begin(now_ns()) {
+#ifdef BOITATAH_ALLOC_AUDIT
+                alloc_audit::push_scope(name);
+#endif
+            }
+            ~Zone(){
+#ifdef BOITATAH_ALLOC_AUDIT
+                alloc_audit::pop_scope();
+#endif
+                record_zone(m_name, m_begin, now_ns());
+            }
+
+            Zone(const Zone&) = delete;
+            Zone& operator=(const Zone&) = delete;
+
+        private:
+            const char* m_name;
+            uint64_t    m_begin;
+    };
+}
@@ -17,6 +17,14 @@ namespace boitatah{
         ComposePBR = 2,
     };
 
+    //constant_id of the specialization constants declared by the base shaders.
+    enum class BaseShaderConstant : uint32_t{
+        //material fragment shaders, multiplies the texture by the vertex color.
+        UseVertexColor = 0,
+        //lambert compose, upper bound of the light loop.
+        MaxLights      = 1,
+    };
+
     //This class frees BackBuffer from having to know aobut
     //the base Materials from each stage
     // it also removes the dependency between backbuffermanager an dmaterial managerb c
@@ -41,17 +49,26 @@ namespace boitatah{
             void ClearStageBaseMaterials();
 
 
+            // specialization picks a compile time variant of the material shader,
+            // built with vertexColor and maxLights.
+            static SpecializationConstant vertexColor(bool enabled);
+            static SpecializationConstant maxLights(uint32_t count);
+
             Handle<Material> createUnlitMaterial(uint32_t                stage_mask,
                                                  uint32_t                priority,
-                                                 Handle<RenderTexture>   texture);
+                                                 Handle<RenderTexture>   texture,
+                                                 const std::vector<SpecializationConstant>& specialization = {});
             Handle<Material> createLambertMaterial(uint32_t                stage_mask,
                                                  uint32_t                priority,
-                                                 Handle<RenderTexture>   texture);
+                                                 Handle<RenderTexture>   texture,
+                                                 const std::vector<SpecializationConstant>& specialization = {});
 
             Handle<Material> createUnlitDeferredComposeMaterial(uint32_t     stage_mask,
-                                                                uint32_t     priority);
+                                                                uint32_t     priority,
+                                                                const std::vector<SpecializationConstant>& specialization = {});
             Handle<Material> createLambertDeferredComposeMaterial(uint32_t   stage_mask,
-                                                                uint32_t     priority);
+                                                                uint32_t     priority,
+                                                                const std::vector<SpecializationConstant>& specialization = {});
             Handle<Material> createPBRComposerMaterial(uint32_t priority, uint32_t stage_mask);
 
             Handle<MaterialBinding> getCameraStageBinding();
@@ -65,12 +82,17 @@ namespace boitatah{
                                     4>, 
                                 10>;
 
+            //builds all stage shaders as a single parallel compile batch.
             void BuildShaderMap();
-            void BuildUnlitShader(uint32_t stage_index);
-            void BuildLambertShader(uint32_t stage_index);
-
-            Handle<Material> GenerateBaseCameraMaterial(Handle<RenderStage> stage_handle);
-            Handle<Material> GenerateBaseScreenQuadMaterial(Handle<RenderStage> stage_handle);
+            MakeShaderDesc BuildUnlitShader(uint32_t stage_index);
+            MakeShaderDesc BuildLambertShader(uint32_t stage_index);
+
+            MakeShaderDesc BaseCameraShaderDesc(Handle<RenderStage> stage_handle);
+            MakeShaderDesc BaseScreenQuadShaderDesc(Handle<RenderStage> stage_handle);
+            Handle<Material> GenerateBaseCameraMaterial(Handle<RenderStage> stage_handle,
+                                                        Handle<Shader> shader);
+            Handle<Material> GenerateBaseScreenQuadMaterial(Handle<RenderStage> stage_handle,
+                                                            Handle<Shader> shader);
 
             std::vector<Handle<Material>> base_materials;
 
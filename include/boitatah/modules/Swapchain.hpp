@@ -40,7 +40,9 @@ namespace boitatah
         SwapchainImage getNext(VkSemaphore &semaphore);
         SwapchainImage getCurrent();
         void attach(std::shared_ptr<VulkanInstance> vulkan, std::shared_ptr<WindowManager> window);
-        void createSwapchain();//Vector2<uint32_t> dimensions, bool vsync, bool fullscreen);
+        //framebufferSize is used when the surface leaves the extent to the application,
+        //the caller reads it on the main thread.
+        void createSwapchain(VkExtent2D framebufferSize);
         // void populateBuffers();
 
     private:
@@ -60,7 +62,7 @@ namespace boitatah
 
         std::vector<Image> getSwapchainImages();
 
-        void createVkSwapchain();
+        void createVkSwapchain(VkExtent2D framebufferSize);
         void createViews();
 
         void clearSwapchainViews();
@@ -71,7 +73,7 @@ namespace boitatah
             const std::vector<VkSurfaceFormatKHR> &availableFormats,
             IMAGE_FORMAT scFormat,
             COLOR_SPACE scColorSpace);
-        VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities);
+        VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities, VkExtent2D framebufferSize);
         VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR> &availableModes);
         
     };
@@ -25,7 +25,7 @@ namespace boitatah
     struct BufferGPUData //: public ResourceGPUContent<GPUBuffer>
     {
         Handle<BufferAddress> buffer;
-        uint32_t buffer_capacity;
+        VkDeviceSize buffer_capacity;
     };
 
     template<>
@@ -45,7 +45,7 @@ namespace boitatah
     //TODO solve this issue in a more elegant manner
     class GPUBufferHelper{
         public:
-            uint32_t size;
+            VkDeviceSize size;
             BUFFER_USAGE usage;
             GPUBufferHelper() = default;
             GPUBufferHelper(const GPUBufferCreateDescription &createDescription)  :
@@ -73,7 +73,7 @@ namespace boitatah
                                                   }, manager) 
                                                   { };
 
-            void copyData(const void * data, uint32_t length);
+            void copyData(const void * data, VkDeviceSize length);
             buffer::BufferAccessData GetRenderData(uint32_t frame_index);
 
             //TODO: Implement
@@ -92,6 +92,8 @@ namespace boitatah
         private:
 
             Handle<BufferAddress> stagingBuffer;
+            //transfer batch that last copied out of the staging buffer.
+            uint64_t stagingBatch = 0;
             BufferMetaData meta_data;
 
             /// @brief ready for use for buffers is trivially handled by MutableGPUResource<T>
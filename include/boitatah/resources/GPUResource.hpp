@@ -17,6 +17,8 @@ namespace boitatah{
     {
         friend GPUResourceManager;
         protected:
+            static constexpr uint32_t COPIES = Copies;
+
             Handle<Resource> m_resourceHandle;
 
             ResourceDescriptor m_descriptor;
@@ -27,6 +29,10 @@ namespace boitatah{
             uint32_t last_updated_frame = 0U;
 
             std::array<typename ResourceTraits<Resource>::ContentType, Copies> replicated_content;
+            //transfer batch that last uploaded each copy.
+            std::array<uint64_t, Copies> upload_batches{};
+            //false while an async upload is waiting for its acquire.
+            bool visible = true;
 
 
             Resource& self(){return *static_cast<Resource*>(this);};
@@ -45,7 +51,7 @@ namespace boitatah{
             }
 
             void clean_dirt(int frame_index = 0) 
-            { dirty = dirty & ~(static_cast<uint8_t>(1u) << (frame_index%2)); };
+            { dirty = dirty & ~(static_cast<uint8_t>(1u) << (frame_index % Copies)); };
 
             void clean_commit(int frame_index = 0) 
             { commited = 255u;};
@@ -64,8 +70,19 @@ namespace boitatah{
                 last_updated_frame = frame_index;
                 set_commited(frame_index);
                 clean_dirt(frame_index);
+                upload_batches[frame_index % Copies] = writer.get_batch_id();
                 self().WriteTransfer(replicated_content[frame_index % Copies], writer.self());
             };
+            /// @brief writes every copy at once, for uploads recorded outside a frame.
+            void commit_all(ResourceTraits<Resource>::CommandBufferWriter& writer)
+            {
+                for(uint32_t i = 0; i < Copies; i++){
+                    set_commited(i);
+                    clean_dirt(i);
+                    upload_batches[i] = writer.get_batch_id();
+                    self().WriteTransfer(replicated_content[i], writer.self());
+                }
+            };
             void ready_content( uint32_t                                      frame_index, 
                                ResourceTraits<Resource>::CommandBufferWriter   &writer){
                 if((!ready_for_use(frame_index)||
@@ -104,6 +121,8 @@ namespace boitatah{
 
                 bool ready_for_use(uint32_t frame_index) { return self().ReadyForUse(replicated_content[frame_index % Copies]);};
                 bool check_commited(uint32_t frame_index) { return 0u == ((commited << (frame_index % Copies))); };
+                uint64_t get_upload_batch(uint32_t frame_index) const { return upload_batches[frame_index % Copies]; };
+                bool is_visible() const { return visible; };
             
                 ResourceTraits<Resource>::RenderData get_render_data(uint32_t frame_index)
                 {
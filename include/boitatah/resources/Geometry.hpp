@@ -24,6 +24,7 @@ namespace boitatah
         MISC1 = 6U,
         MISC2 = 7U
     };
+    constexpr uint32_t VERTEX_BUFFER_TYPE_COUNT = 8;
 
 
     struct GeometryRenderData{
@@ -79,7 +80,7 @@ namespace boitatah
         private:
             std::vector<Handle<GPUBuffer>> m_ownedBuffers;
             std::vector<Handle<GPUBuffer>> m_buffers;
-            std::array<uint8_t, 8> m_bufferIndexes = {255,255,255,255,
+            std::array<uint8_t, VERTEX_BUFFER_TYPE_COUNT> m_bufferIndexes = {255,255,255,255,
                                                       255,255,255,255};
 
             //Count, begin
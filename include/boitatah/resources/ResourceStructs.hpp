@@ -1,5 +1,6 @@
 #pragma once
 
+#include <vulkan/vulkan.h>
 #include <boitatah/BoitatahEnums.hpp>
 
 namespace boitatah{
@@ -7,7 +8,7 @@ namespace boitatah{
     struct GeometryCreateDescription;
 
     struct GPUBufferCreateDescription{
-        uint32_t size;
+        VkDeviceSize size;
         BUFFER_USAGE usage;
         SHARING_MODE sharing_mode;
     };
@@ -68,7 +68,7 @@ namespace boitatah{
         uint32_t channels;
         IMAGE_FORMAT format = IMAGE_FORMAT::RGBA_8_SRGB;
         IMAGE_USAGE usage = IMAGE_USAGE::COLOR_ATT_TRANSFER_DST;
-        uint32_t byteSize;
+        VkDeviceSize byteSize;
         Handle<Sampler> sampler;
         
     };
@@ -92,6 +92,9 @@ namespace boitatah{
             TextureProperties texProps;
             uint32_t image_generation = 0u;
             TextureUpdateFrom update_from = TextureUpdateFrom::NONE;
+            //ownership release written after a copy from the staging buffer.
+            uint32_t m_srcQueueFamily = VK_QUEUE_FAMILY_IGNORED;
+            uint32_t m_dstQueueFamily = VK_QUEUE_FAMILY_IGNORED;
             TextureAccessData GetRenderData(TextureGPUData& gpu_data);
             TextureGPUData CreateGPUData();
             bool ReadyForUse(TextureGPUData& content);
@@ -108,6 +111,11 @@ namespace boitatah{
             void CmdCopyImageFromImage(Handle<Image> src_image,
                                     IMAGE_LAYOUT src_layout);
             void transition(TextureMode mode);
+            //copies recorded from now on release the image to dstFamily,
+            //VK_QUEUE_FAMILY_IGNORED for both keeps it on the recording queue.
+            void setQueueTransfer(uint32_t srcFamily, uint32_t dstFamily);
+            bool uploadsFromBuffer() const;
+            VkDeviceSize byteSize() const;
     };
 
 
@@ -128,6 +128,7 @@ namespace boitatah
                 if (m_dirtyMatrix)
                 {
                     updateGlobalMatrix();
+                    m_dirtyMatrix = false;
                 }
                 return m_globalTransform;
             }
@@ -28,6 +28,9 @@ layout(set = 1, binding = 1) uniform LightData2{
     LightData[9999] light_points;
 }light_array;
 
+//upper bound of the light loop, see BaseShaderConstant::MaxLights.
+layout(constant_id = 1) const uint MAX_LIGHTS = 9999;
+
 void main() {
 
     vec4 albedo = texture(color_tex , UV);
@@ -37,7 +40,8 @@ void main() {
     vec3 light_color = vec3(0.0).xyz;
     float intensity = 0.0f;
 
-    for(uint i = 0; i < light_metadata.active_lights; i++){
+    uint light_count = min(light_metadata.active_lights, MAX_LIGHTS);
+    for(uint i = 0; i < light_count; i++){
         LightData light = light_array.light_points[i];
         vec3 p =  light.position.xyz - position.xyz;
         float r2 = dot(p,p);
@@ -20,6 +20,12 @@ layout(set = 0, binding = 0) uniform  Camera{
 
 layout(set = 1, binding = 0) uniform sampler2D color_tex;
 
+//Materials picks it, see BaseShaderConstant::UseVertexColor.
+//forward materials never used the vertex color, so it defaults to off.
+layout(constant_id = 0) const bool USE_VERTEX_COLOR = false;
+
 void main() {
-    color = texture(color_tex, UV); //* vec4(vertexColor, 1.0);
+    color = texture(color_tex, UV);
+    if(USE_VERTEX_COLOR)
+        color *= vec4(vertexColor, 1.0);
 }
@@ -22,8 +22,13 @@ layout(set = 0, binding = 0) uniform  Camera{
 
 layout(set = 1, binding = 0) uniform sampler2D color_tex;
 
+//Materials picks it, see BaseShaderConstant::UseVertexColor.
+layout(constant_id = 0) const bool USE_VERTEX_COLOR = true;
+
 void main() {
-    color = texture(color_tex, UV) * vec4(vertexColor, 1.0);
+    color = texture(color_tex, UV);
+    if(USE_VERTEX_COLOR)
+        color *= vec4(vertexColor, 1.0);
     normal = vec4(1.0, 1.0, 1.0, 1.0);
     position = vec4(sin(vertexPosition).xyz * vec3(0.5) + vec3(0.5), 1.0 );
 }
\ No newline at end of file
@@ -17,10 +17,14 @@ namespace boitatah
         DESCRIPTOR_TYPE type;
         SHADER_STAGE stages;
         uint32_t descriptorCount = 1;
+
+        bool operator==(const BindingDesc &other) const = default;
     };
     
     struct DescriptorSetLayoutDesc{
         std::vector<BindingDesc> bindingDescriptors;
+
+        bool operator==(const DescriptorSetLayoutDesc &other) const = default;
     };
 
     struct DescriptorSetRatio{
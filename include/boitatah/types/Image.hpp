@@ -47,6 +47,10 @@ namespace boitatah
         glm::u32vec2 dimensions;
         bool swapchain = false;
         VkDeviceMemory memory;
+        //of images made by create_image.
+        IMAGE_FORMAT format;
+        IMAGE_USAGE usage;
+        VkDeviceSize memorySize = 0;
     };
 
     struct ImageAccessData{
@@ -3,6 +3,7 @@
 #include<vector>
 #include <boitatah/collections.hpp>
 #include <boitatah/resources/Geometry.hpp>
+#include <boitatah/buffers/BufferStructs.hpp>
 #include <string>
 
 namespace boitatah{
@@ -13,11 +14,14 @@ namespace boitatah{
 
     struct MaterialBindingAtt{
         DESCRIPTOR_TYPE type;
+        //uniform buffer bound straight from a transient allocation.
+        bool transient = false;
         union {
             Handle<GPUBuffer> buffer;
             Handle<RenderTexture> renderTex;
             Handle<Image> image;
             Handle<Sampler> sampler;
+            buffer::BufferAccessData transient;
         }binding_handle;
     };
     struct MaterialBinding{
@@ -38,11 +42,13 @@ namespace boitatah{
         std::string name;
 
 
+        //same priority materials are grouped by pipeline to avoid switches.
         std::weak_ordering operator<=>(const Material& o) const{
-            if(stage_mask == o.stage_mask)
-                return priority <=> o.priority;
-            else
+            if(stage_mask != o.stage_mask)
                 return stage_mask <=> o.stage_mask;
+            if(priority != o.priority)
+                return priority <=> o.priority;
+            return shader.i <=> o.shader.i;
         };
 
         private:
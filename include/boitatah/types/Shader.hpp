@@ -30,7 +30,8 @@ namespace boitatah
     struct ShaderLayoutDesc
     {
         std::vector<Handle<DescriptorSetLayout>> setLayouts;
-        //std::vector<PushConstantDesc> pushConstants;
+        // empty defaults to the model matrix push constant.
+        std::vector<PushConstantDesc> pushConstants;
     };
 
     struct ShaderLayoutDescVk
@@ -82,6 +83,26 @@ namespace boitatah
 
     };
 
+    // Specialization constant value for layout(constant_id = id).
+    // values are 4 bytes, use std::bit_cast for floats and VkBool32 for bools.
+    // ids the shader doesn't declare are ignored.
+    struct SpecializationConstant
+    {
+        uint32_t id;
+        uint32_t value;
+
+        bool operator==(const SpecializationConstant &other) const = default;
+    };
+
+    // Layout data read back from the vert and frag bytecode.
+    // one VertexBindings per input location, one set layout per set index.
+    struct ShaderReflection
+    {
+        std::vector<VertexBindings> vertexBindings;
+        std::vector<DescriptorSetLayoutDesc> setLayouts;
+        std::vector<PushConstantDesc> pushConstants;
+    };
+
     struct MakeShaderDesc
     {
         // required arguments
@@ -95,6 +116,9 @@ namespace boitatah
 
         std::vector<ColorBlend> colorBlends;
         std::vector<VertexBindings> vertexBindings;
+
+        // applied to both stages.
+        std::vector<SpecializationConstant> specialization;
     };
 
 
@@ -108,6 +132,7 @@ namespace boitatah
         std::vector<ColorBlend> colorBlends;
         std::vector<VkVertexInputBindingDescription> bindings;
         std::vector<VkVertexInputAttributeDescription> attributes;
+        std::vector<SpecializationConstant> specialization;
     };
 
     struct Shader
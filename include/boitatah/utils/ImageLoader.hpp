@@ -37,8 +37,7 @@ namespace boitatah::utils{
                 textureCreate.textureMode = mode;
                 auto texture = manager.create(textureCreate);
 
-                auto& tex = manager.getResource(texture);
-                tex.copyImageFromBuffer(pixels);
+                manager.uploadTexture(texture, pixels);
 
                 stbi_image_free(pixels);
 
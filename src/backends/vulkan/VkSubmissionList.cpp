@@ -0,0 +1,272 @@
+#include <boitatah/backend/vulkan/VkSubmissionList.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace boitatah::vk{
+
+    VkSubmissionList::VkSubmissionList(std::shared_ptr<VulkanInstance> vk_instance)
+        : m_vk(vk_instance)
+    {
+    }
+
+    VkSubmissionList::~VkSubmissionList()
+    {
+        for(uint32_t i = 0; i < m_timelineCount; i++){
+            auto& timeline = m_timelines[i];
+            m_vk->wait_for_semaphore(timeline.semaphore, timeline.submitted);
+            m_vk->destroy_semaphore(timeline.semaphore);
+        }
+    }
+
+    TimelinePoint VkSubmissionList::enqueue(VkQueue                               queue,
+                                            VkCommandBuffer                       buffer,
+                                            std::span<const VkSemaphore>          binary_waits,
+                                            std::span<const VkPipelineStageFlags> binary_stages,
+                                            std::span<const TimelinePoint>        timeline_waits,
+                                            std::span<const VkPipelineStageFlags> timeline_stages,
+                                            std::span<const VkSemaphore>          binary_signals)
+    {
+        if(binary_waits.size() != binary_stages.size() ||
+           timeline_waits.size() != timeline_stages.size())
+            throw std::runtime_error("submission needs one stage per wait semaphore");
+
+        uint32_t index = timeline_index(queue);
+        auto& timeline = m_timelines[index];
+
+        Submission submission{
+            .timeline = index,
+            .buffer = buffer,
+            .wait_begin = static_cast<uint32_t>(m_semaphores.size()),
+        };
+
+        for(uint32_t i = 0; i < binary_waits.size(); i++){
+            m_semaphores.push_back(binary_waits[i]);
+            m_values.push_back(0);
+            m_stages.push_back(binary_stages[i]);
+        }
+        for(uint32_t i = 0; i < timeline_waits.size(); i++){
+            //batches on one queue may overlap, so waits on our own timeline stay.
+            auto& point = timeline_waits[i];
+            if(point.value == 0)
+                continue;
+            m_semaphores.push_back(m_timelines[point.queue].semaphore);
+            m_values.push_back(point.value);
+            m_stages.push_back(timeline_stages[i]);
+        }
+        submission.wait_count = static_cast<uint32_t>(m_semaphores.size()) - submission.wait_begin;
+
+        //signals share the arrays, their stages are unused.
+        submission.signal_begin = static_cast<uint32_t>(m_semaphores.size());
+        for(auto semaphore : binary_signals){
+            m_semaphores.push_back(semaphore);
+            m_values.push_back(0);
+        }
+        timeline.enqueued++;
+        m_semaphores.push_back(timeline.semaphore);
+        m_values.push_back(timeline.enqueued);
+        submission.signal_count = static_cast<uint32_t>(m_semaphores.size()) - submission.signal_begin;
+        m_stages.resize(m_semaphores.size(), 0);
+
+        m_submissions.push_back(submission);
+        m_totalBatches++;
+        return {.queue = index, .value = timeline.enqueued};
+    }
+
+    void VkSubmissionList::flush()
+    {
+        m_lastSubmitCount = 0;
+        if(m_submissions.empty())
+            return;
+
+        //group submissions into one call per queue.
+        m_calls.clear();
+        m_callOrder.clear();
+        for(uint32_t i = 0; i < m_submissions.size(); i++){
+            auto& submission = m_submissions[i];
+
+            //binary semaphores must have their signal submitted before the wait,
+            //so an open call on another queue that signals one of our waits goes first.
+            //timeline waits may be submitted before their signal.
+            for(uint32_t w = submission.wait_begin;
+                         w < submission.wait_begin + submission.wait_count; w++){
+                if(m_values[w] != 0)
+                    continue;
+                for(uint32_t j = i; j-- > 0;){
+                    auto& signaler = m_submissions[j];
+                    auto begin = m_semaphores.begin() + signaler.signal_begin;
+                    auto end = begin + signaler.signal_count;
+                    if(std::find(begin, end, m_semaphores[w]) == end)
+                        continue;
+
+                    auto& call = m_calls[signaler.call];
+                    if(call.open && call.timeline != submission.timeline)
+                        close_call(signaler.call);
+                    break;
+                }
+            }
+
+            uint32_t call = static_cast<uint32_t>(m_calls.size());
+            for(uint32_t c = 0; c < m_calls.size(); c++){
+                if(m_calls[c].open && m_calls[c].timeline == submission.timeline){
+                    call = c;
+                    break;
+                }
+            }
+            if(call == m_calls.size())
+                m_calls.push_back({.timeline = submission.timeline, .open = true});
+            submission.call = call;
+        }
+
+        for(uint32_t c = 0; c < m_calls.size(); c++){
+            if(m_calls[c].open)
+                close_call(c);
+        }
+
+        for(auto call : m_callOrder)
+            submit_call(call);
+
+        for(uint32_t i = 0; i < m_timelineCount; i++)
+            m_timelines[i].submitted = m_timelines[i].enqueued;
+
+        m_submissions.clear();
+        m_semaphores.clear();
+        m_values.clear();
+        m_stages.clear();
+    }
+
+    bool VkSubmissionList::is_complete(const TimelinePoint &point)
+    {
+        if(point.value == 0)
+            return true;
+
+        auto& timeline = m_timelines[point.queue];
+        if(timeline.completed >= point.value)
+            return true;
+        if(timeline.submitted < point.value)
+            return false;
+
+        timeline.completed = m_vk->get_semaphore_value(timeline.semaphore);
+        return timeline.completed >= point.value;
+    }
+
+    bool VkSubmissionList::is_complete(const TimelineFrontier &frontier)
+    {
+        for(uint32_t i = 0; i < m_timelineCount; i++){
+            if(!is_complete({.queue = i, .value = frontier.values[i]}))
+                return false;
+        }
+        return true;
+    }
+
+    void VkSubmissionList::wait(const TimelinePoint &point)
+    {
+        if(is_complete(point))
+            return;
+
+        auto& timeline = m_timelines[point.queue];
+        if(timeline.submitted < point.value)
+            flush();
+
+        m_vk->wait_for_semaphore(timeline.semaphore, point.value);
+        timeline.completed = std::max(timeline.completed, point.value);
+    }
+
+    void VkSubmissionList::wait(const TimelineFrontier &frontier)
+    {
+        for(uint32_t i = 0; i < m_timelineCount; i++)
+            wait({.queue = i, .value = frontier.values[i]});
+    }
+
+    TimelineFrontier VkSubmissionList::frontier() const
+    {
+        TimelineFrontier frontier;
+        for(uint32_t i = 0; i < m_timelineCount; i++)
+            frontier.values[i] = m_timelines[i].enqueued;
+        return frontier;
+    }
+
+    bool VkSubmissionList::empty() const
+    {
+        return m_submissions.empty();
+    }
+
+    uint32_t VkSubmissionList::get_last_submit_count() const
+    {
+        return m_lastSubmitCount;
+    }
+
+    uint64_t VkSubmissionList::get_submit_count() const
+    {
+        return m_totalSubmits;
+    }
+
+    uint64_t VkSubmissionList::get_batch_count() const
+    {
+        return m_totalBatches;
+    }
+
+    uint32_t VkSubmissionList::timeline_index(VkQueue queue)
+    {
+        for(uint32_t i = 0; i < m_timelineCount; i++){
+            if(m_timelines[i].queue == queue)
+                return i;
+        }
+        if(m_timelineCount == MAX_SUBMISSION_QUEUES)
+            throw std::runtime_error("too many queues in submission list");
+
+        auto& timeline = m_timelines[m_timelineCount];
+        timeline.queue = queue;
+        timeline.semaphore = m_vk->create_timeline_semaphore(0);
+        return m_timelineCount++;
+    }
+
+    void VkSubmissionList::close_call(uint32_t call)
+    {
+        m_calls[call].open = false;
+        m_callOrder.push_back(call);
+    }
+
+    void VkSubmissionList::submit_call(uint32_t call)
+    {
+        m_submitInfos.clear();
+        m_timelineInfos.clear();
+        for(auto& submission : m_submissions){
+            if(submission.call != call)
+                continue;
+            m_timelineInfos.push_back({
+                .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+                .waitSemaphoreValueCount = submission.wait_count,
+                .pWaitSemaphoreValues = m_values.data() + submission.wait_begin,
+                .signalSemaphoreValueCount = submission.signal_count,
+                .pSignalSemaphoreValues = m_values.data() + submission.signal_begin,
+            });
+        }
+
+        //timeline infos are all in place, safe to point at them.
+        uint32_t info = 0;
+        for(auto& submission : m_submissions){
+            if(submission.call != call)
+                continue;
+            m_submitInfos.push_back({
+                .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                .pNext = &m_timelineInfos[info++],
+                .waitSemaphoreCount = submission.wait_count,
+                .pWaitSemaphores = m_semaphores.data() + submission.wait_begin,
+                .pWaitDstStageMask = m_stages.data() + submission.wait_begin,
+                .commandBufferCount = 1,
+                .pCommandBuffers = &submission.buffer,
+                .signalSemaphoreCount = submission.signal_count,
+                .pSignalSemaphores = m_semaphores.data() + submission.signal_begin,
+            });
+        }
+
+        if(vkQueueSubmit(m_timelines[m_calls[call].timeline].queue,
+                         static_cast<uint32_t>(m_submitInfos.size()),
+                         m_submitInfos.data(),
+                         VK_NULL_HANDLE) != VK_SUCCESS)
+            throw std::runtime_error("failed to submit frame batches");
+        m_lastSubmitCount++;
+        m_totalSubmits++;
+    }
+}
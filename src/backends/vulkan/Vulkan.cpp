@@ -7,6 +7,7 @@
 #include <map>
 #include <optional>
 #include <set>
+#include <string_view>
 #include <cstdint>
 #include <limits>
 #include <memory>
@@ -131,6 +132,37 @@ VkDevice boitatah::vk::VulkanInstance::get_device() const
     return m_device;
 }
 
+const VkPhysicalDeviceLimits &boitatah::vk::VulkanInstance::get_device_limits() const
+{
+    return m_device_properties.limits;
+}
+
+VkDeviceSize boitatah::vk::VulkanInstance::get_max_buffer_size(MEMORY_PROPERTY type) const
+{
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(m_physical_device, &memProperties);
+
+    //the allocator's old fixed cap, kept whenever the heap can hold it.
+    constexpr VkDeviceSize LEGACY_MAX_SIZE = VkDeviceSize{1} << 27;
+
+    //a small bar heap may be listed first, the buffer goes to the largest one.
+    auto flags = castEnum<VkMemoryPropertyFlagBits>(type);
+    VkDeviceSize heapSize = 0;
+    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
+    {
+        if ((memProperties.memoryTypes[i].propertyFlags & flags) != flags)
+            continue;
+        auto heap = memProperties.memoryHeaps[memProperties.memoryTypes[i].heapIndex];
+        heapSize = std::max(heapSize, heap.size);
+    }
+    if (heapSize == 0)
+        throw std::runtime_error("Failed to find memory");
+
+    //leaves room for the other buffers and images on the heap.
+    VkDeviceSize size = std::max(heapSize / 4, std::min(LEGACY_MAX_SIZE, heapSize));
+    return std::min(m_max_allocation_size, size);
+}
+
 VkPhysicalDevice boitatah::vk::VulkanInstance::get_physical_device() const
 {
     return m_physical_device;
@@ -261,6 +293,45 @@ bool boitatah::vk::VulkanInstance::check_fence_status(VkFence fence)
     return result == VK_SUCCESS; //fence is signaled
 }
 
+uint64_t boitatah::vk::VulkanInstance::get_semaphore_value(VkSemaphore semaphore) const
+{
+    uint64_t value = 0;
+    if (vkGetSemaphoreCounterValue(m_device, semaphore, &value) != VK_SUCCESS)
+        std::cout << "get semaphore counter failed " << std::endl;
+    return value;
+}
+
+void boitatah::vk::VulkanInstance::wait_for_semaphore(VkSemaphore semaphore, uint64_t value) const
+{
+    VkSemaphoreWaitInfo waitInfo{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+        .semaphoreCount = 1,
+        .pSemaphores = &semaphore,
+        .pValues = &value,
+    };
+    VkResult result = vkWaitSemaphores(m_device, &waitInfo, UINT64_MAX);
+    if (result != VK_SUCCESS)
+        std::cout << "wait for semaphore failed " << result << std::endl;
+}
+
+void boitatah::vk::VulkanInstance::reset_querypool(VkQueryPool pool, uint32_t first, uint32_t count) const
+{
+    vkResetQueryPool(m_device, pool, first, count);
+}
+
+bool boitatah::vk::VulkanInstance::get_timestamp_results(VkQueryPool pool,
+                                                         uint32_t first,
+                                                         uint32_t count,
+                                                         uint64_t *results) const
+{
+    //no wait flag, unavailable queries report zero availability instead of blocking.
+    VkResult result = vkGetQueryPoolResults(m_device, pool, first, count,
+                                            sizeof(uint64_t) * 2 * count, results,
+                                            sizeof(uint64_t) * 2,
+                                            VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+    return result == VK_SUCCESS;
+}
+
 #pragma endregion Synchronization
 
 #pragma region PSO Building
@@ -371,6 +442,9 @@ Image boitatah::vk::VulkanInstance::create_image(const ImageDesc &desc) const
     });
 
     bind_image_memory(image.memory, image.image);
+    image.format = desc.format;
+    image.usage = desc.usage;
+    image.memorySize = reqs.size;
 
     return image;
 }
@@ -464,6 +538,51 @@ boitatah::CommandBuffer boitatah::vk::VulkanInstance::allocate_commandbuffer(con
     return CommandBuffer{.buffer = buffer, .type = desc.type};
 }
 
+boitatah::CommandBuffer boitatah::vk::VulkanInstance::allocate_commandbuffer(const CommandBufferDesc &desc, VkCommandPool pool)
+{
+    VkCommandBufferAllocateInfo allocateInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool = pool,
+        .level = castEnum<VkCommandBufferLevel>(desc.level),
+        .commandBufferCount = 1};
+
+    VkCommandBuffer buffer;
+    if (vkAllocateCommandBuffers(m_device, &allocateInfo, &buffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate Command Buffer");
+    }
+
+    return CommandBuffer{.buffer = buffer, .type = desc.type};
+}
+
+VkCommandPool boitatah::vk::VulkanInstance::create_commandpool(COMMAND_BUFFER_TYPE type)
+{
+    uint32_t family = m_queue_family_indices.graphicsFamily.value();
+    if (type == COMMAND_BUFFER_TYPE::TRANSFER)
+        family = m_queue_family_indices.transferFamily.value();
+    if (type == COMMAND_BUFFER_TYPE::PRESENT)
+        family = m_queue_family_indices.presentFamily.value();
+
+    //buffers are rerecorded every frame and reset with the pool.
+    VkCommandPoolCreateInfo info{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+        .queueFamilyIndex = family,
+    };
+
+    VkCommandPool pool;
+    if (vkCreateCommandPool(m_device, &info, nullptr, &pool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create Command Pool");
+    }
+    return pool;
+}
+
+void boitatah::vk::VulkanInstance::reset_commandpool(VkCommandPool pool)
+{
+    vkResetCommandPool(m_device, pool, 0);
+}
+
 
 
 bool boitatah::vk::VulkanInstance::present(Image &swapchainImage,
@@ -506,7 +625,7 @@ VkDeviceMemory boitatah::vk::VulkanInstance::allocate_memory(const MemoryDesc &d
 
     if (vkAllocateMemory(m_device, &allocateInfo, nullptr, &memory) != VK_SUCCESS)
         throw std::runtime_error("Failed to allocate Memory");
-    
+    track_allocation(memory, allocateInfo.memoryTypeIndex, desc.size);
 
     return memory;
 }
@@ -652,6 +771,27 @@ VkSemaphore boitatah::vk::VulkanInstance::create_semaphore() const
     return semaphore;
 }
 
+VkSemaphore boitatah::vk::VulkanInstance::create_timeline_semaphore(uint64_t initial_value) const
+{
+    VkSemaphoreTypeCreateInfo typeInfo{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue = initial_value,
+    };
+
+    VkSemaphoreCreateInfo semaphoreInfo{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = &typeInfo,
+    };
+
+    VkSemaphore semaphore;
+
+    if (vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &semaphore))
+        throw std::runtime_error("Failed to create Timeline Semaphore");
+
+    return semaphore;
+}
+
 boitatah::vk::BufferVkData boitatah::vk::VulkanInstance::create_buffer(const BufferDescVk &desc) const
 {
 
@@ -671,6 +811,14 @@ boitatah::vk::BufferVkData boitatah::vk::VulkanInstance::create_buffer(const Buf
         bufferInfo.pQueueFamilyIndices = indexes.data();
     }
 
+    //concurrent sharing needs distinct families.
+    if (desc.sharing == SHARING_MODE::CONCURRENT && !has_dedicated_transfer())
+    {
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        bufferInfo.queueFamilyIndexCount = 0;
+        bufferInfo.pQueueFamilyIndices = nullptr;
+    }
+
     VkBuffer buffer;
     if (vkCreateBuffer(m_device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
     {
@@ -695,12 +843,30 @@ boitatah::vk::BufferVkData boitatah::vk::VulkanInstance::create_buffer(const Buf
     {
         throw std::runtime_error("Failed to  allocate buffer memory");
     }
+    track_allocation(memory, memInfo.memoryTypeIndex, memReqs.size);
 
     vkBindBufferMemory(m_device, buffer, memory, 0);
 
     return {.buffer = buffer, .memory = memory, .alignment = memReqs.alignment, .actualSize =memReqs.size };
 }
 
+VkQueryPool boitatah::vk::VulkanInstance::create_timestamp_querypool(uint32_t count) const
+{
+    VkQueryPoolCreateInfo info{
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .queryType = VK_QUERY_TYPE_TIMESTAMP,
+        .queryCount = count,
+    };
+
+    VkQueryPool pool;
+    if (vkCreateQueryPool(m_device, &info, nullptr, &pool) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create Query Pool");
+
+    //queries start unavailable only after a reset.
+    vkResetQueryPool(m_device, pool, 0, count);
+    return pool;
+}
+
 VkSampler boitatah::vk::VulkanInstance::create_sampler(const SamplerData &data) const
 {
     VkSamplerCreateInfo info{};
@@ -749,11 +915,13 @@ boitatah::vk::BufferVkData boitatah::vk::VulkanInstance::get_buffer_alignment_me
         .sharingMode = castEnum<VkSharingMode>(desc.sharing),
     };
 
-    if (desc.sharing == SHARING_MODE::CONCURRENT)
+    if (desc.sharing == SHARING_MODE::CONCURRENT && has_dedicated_transfer())
     {
         dummyCreate.queueFamilyIndexCount = 2;
         dummyCreate.pQueueFamilyIndices = indexes.data();
     }
+    else
+        dummyCreate.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
     VkBuffer dummyBuffer;
     if (vkCreateBuffer(m_device, &dummyCreate, nullptr, &dummyBuffer) != VK_SUCCESS)
@@ -780,7 +948,7 @@ boitatah::RenderTargetSync boitatah::vk::VulkanInstance::allocate_render_sync_st
                                                  .type = COMMAND_BUFFER_TYPE::GRAPHICS}),
             .present_buffer = allocate_commandbuffer({.count = 1,
                                                      .level = COMMAND_BUFFER_LEVEL::PRIMARY,
-                                                     .type = COMMAND_BUFFER_TYPE::TRANSFER}),
+                                                     .type = COMMAND_BUFFER_TYPE::GRAPHICS}),
             .draw_semaphore = create_semaphore(),
             .sc_aquired_semaphore = create_semaphore(),
             .transfer_semaphore = create_semaphore(),
@@ -885,15 +1053,37 @@ void boitatah::vk::VulkanInstance::build_shader(const ShaderDescVk &desc, Shader
         .blendConstants = {0.0f, 0.0f, 0.0f, 0.0f},
     };
 
+    // same constants for both stages, unused ids are ignored by the driver.
+    std::vector<VkSpecializationMapEntry> specializationEntries;
+    std::vector<uint32_t> specializationData;
+    for(auto& constant : desc.specialization){
+        specializationEntries.push_back({
+            .constantID = constant.id,
+            .offset = static_cast<uint32_t>(specializationData.size() * sizeof(uint32_t)),
+            .size = sizeof(uint32_t),
+        });
+        specializationData.push_back(constant.value);
+    }
+
+    VkSpecializationInfo specializationInfo{
+        .mapEntryCount = static_cast<uint32_t>(specializationEntries.size()),
+        .pMapEntries = specializationEntries.data(),
+        .dataSize = specializationData.size() * sizeof(uint32_t),
+        .pData = specializationData.data(),
+    };
+    const VkSpecializationInfo* pSpecialization = desc.specialization.empty() ? nullptr : &specializationInfo;
+
     VkPipelineShaderStageCreateInfo stages[] = {
         {.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
          .stage = VK_SHADER_STAGE_VERTEX_BIT,
          .module = shader.vert.shaderModule,
-         .pName = shader.vert.entryFunction.c_str()},
+         .pName = shader.vert.entryFunction.c_str(),
+         .pSpecializationInfo = pSpecialization},
         {.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
          .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
          .module = shader.frag.shaderModule,
-         .pName = shader.frag.entryFunction.c_str()}};
+         .pName = shader.frag.entryFunction.c_str(),
+         .pSpecializationInfo = pSpecialization}};
 
     VkGraphicsPipelineCreateInfo pipelineInfo{
         .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
@@ -1010,6 +1200,7 @@ void boitatah::vk::VulkanInstance::destroy_image(Image image)
     if (!image.swapchain)
     {
         vkDestroyImage(m_device, image.image, nullptr);
+        track_free(image.memory);
         vkFreeMemory(m_device, image.memory, nullptr);
     }
 }
@@ -1022,7 +1213,7 @@ void boitatah::vk::VulkanInstance::destroy_pipelinelayout(ShaderLayout &layout)
 void boitatah::vk::VulkanInstance::destroy_rendertarget_sync(const RenderTargetSync &sync)
 {
     vkFreeCommandBuffers(m_device, m_command_pools.graphicsPool, 1, &(sync.draw_buffer.buffer));
-    vkFreeCommandBuffers(m_device, m_command_pools.transferPool, 1, &(sync.present_buffer.buffer));
+    vkFreeCommandBuffers(m_device, m_command_pools.graphicsPool, 1, &(sync.present_buffer.buffer));
 
     vkDestroyFence(m_device, sync.in_flight_fence, nullptr);
     vkDestroySemaphore(m_device, sync.sc_aquired_semaphore, nullptr);
@@ -1033,6 +1224,7 @@ void boitatah::vk::VulkanInstance::destroy_rendertarget_sync(const RenderTargetS
 void boitatah::vk::VulkanInstance::destroy_buffer(BufferVkData buffer) const
 {
     vkDestroyBuffer(m_device, buffer.buffer, nullptr);
+    track_free(buffer.memory);
     vkFreeMemory(m_device, buffer.memory, nullptr);
 }
 
@@ -1046,6 +1238,11 @@ void boitatah::vk::VulkanInstance::destroy_semaphore(VkSemaphore semaphore)
     vkDestroySemaphore(m_device, semaphore, nullptr);
 }
 
+void boitatah::vk::VulkanInstance::destroy_commandpool(VkCommandPool pool)
+{
+    vkDestroyCommandPool(m_device, pool, nullptr);
+}
+
 void boitatah::vk::VulkanInstance::destroy_descriptorpool(VkDescriptorPool pool)
 {
     vkDestroyDescriptorPool(m_device, pool, nullptr);
@@ -1061,6 +1258,11 @@ void boitatah::vk::VulkanInstance::destroy_sampler(VkSampler &sampler)
     vkDestroySampler(m_device, sampler, nullptr);
 }
 
+void boitatah::vk::VulkanInstance::destroy_querypool(VkQueryPool pool)
+{
+    vkDestroyQueryPool(m_device, pool, nullptr);
+}
+
 #pragma endregion Object Destructions
 
 #pragma region QUEUE_SETUP
@@ -1070,26 +1272,71 @@ void boitatah::vk::VulkanInstance::init_logical_device_queues()
     QueueFamilyIndices familyIndices = find_queuefamilies(m_physical_device);
 
     float queuePriority = 1.0;
-    VkDeviceQueueCreateInfo graphicsQueueCreateInfo{
-        .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
-        .queueFamilyIndex = familyIndices.graphicsFamily.value(),
-        .queueCount = 1,
-        .pQueuePriorities = &queuePriority};
-
-    VkDeviceQueueCreateInfo presentQueueCreateInfo{
-        .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
-        .queueFamilyIndex = familyIndices.presentFamily.value(),
-        .queueCount = 1,
-        .pQueuePriorities = &queuePriority};
+
+    //one queue per distinct family.
+    std::vector<VkDeviceQueueCreateInfo> queueCreation;
+    for(uint32_t family : {familyIndices.graphicsFamily.value(),
+                           familyIndices.presentFamily.value(),
+                           familyIndices.transferFamily.value()})
+    {
+        bool created = false;
+        for(auto& info : queueCreation)
+            created = created || info.queueFamilyIndex == family;
+        if(created)
+            continue;
+
+        queueCreation.push_back({
+            .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+            .queueFamilyIndex = family,
+            .queueCount = 1,
+            .pQueuePriorities = &queuePriority});
+    }
 
     VkPhysicalDeviceFeatures deviceFeatures{};
 
-    std::vector<VkDeviceQueueCreateInfo> queueCreation{
-        graphicsQueueCreateInfo, presentQueueCreateInfo};
+    //the gpu profiler resets its queries from the host, optional.
+    VkPhysicalDeviceVulkan12Features supported12{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+    };
+    VkPhysicalDeviceFeatures2 supported{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &supported12,
+    };
+    vkGetPhysicalDeviceFeatures2(m_physical_device, &supported);
+    m_host_query_reset = supported12.hostQueryReset == VK_TRUE;
+
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(m_physical_device, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(m_physical_device, &familyCount, families.data());
+    m_timestamp_valid_bits = families[familyIndices.graphicsFamily.value()].timestampValidBits;
+
+    vkGetPhysicalDeviceMemoryProperties(m_physical_device, &m_memory_properties);
+
+    //heap budgets for the memory report, optional.
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(m_physical_device, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(m_physical_device, nullptr, &extensionCount, extensions.data());
+    for (const auto &extension : extensions)
+        if (std::strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0)
+            m_memory_budget = true;
+    if (m_memory_budget &&
+        std::find(m_device_extensions.begin(), m_device_extensions.end(),
+                  std::string_view(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)) == m_device_extensions.end())
+        m_device_extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+    //queue submissions are tracked with timeline semaphores.
+    VkPhysicalDeviceVulkan12Features vulkan12Features{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+        .hostQueryReset = m_host_query_reset ? VK_TRUE : VK_FALSE,
+        .timelineSemaphore = VK_TRUE,
+    };
 
     VkDeviceCreateInfo createInfo{
         .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-        .queueCreateInfoCount = 2,
+        .pNext = &vulkan12Features,
+        .queueCreateInfoCount = static_cast<uint32_t>(queueCreation.size()),
         .pQueueCreateInfos = queueCreation.data(),
         .enabledExtensionCount = static_cast<uint32_t>(m_device_extensions.size()),
         .ppEnabledExtensionNames = m_device_extensions.data(),
@@ -1189,7 +1436,16 @@ void boitatah::vk::VulkanInstance::init_physical_device()
 
 
     //set the Vulkan member properties.
-    vkGetPhysicalDeviceProperties(m_physical_device, &m_device_properties);
+    VkPhysicalDeviceMaintenance3Properties maintenance3{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MAINTENANCE_3_PROPERTIES,
+    };
+    VkPhysicalDeviceProperties2 properties2{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+        .pNext = &maintenance3,
+    };
+    vkGetPhysicalDeviceProperties2(m_physical_device, &properties2);
+    m_device_properties = properties2.properties;
+    m_max_allocation_size = maintenance3.maxMemoryAllocationSize;
 
 }
 
@@ -1198,6 +1454,82 @@ const boitatah::vk::QueueFamilyIndices boitatah::vk::VulkanInstance::get_queuefa
     return m_queue_family_indices;
 }
 
+bool boitatah::vk::VulkanInstance::has_dedicated_transfer() const
+{
+    return m_queue_family_indices.transferFamily != m_queue_family_indices.graphicsFamily;
+}
+
+bool boitatah::vk::VulkanInstance::supports_gpu_timestamps() const
+{
+    return m_host_query_reset && m_timestamp_valid_bits != 0;
+}
+
+float boitatah::vk::VulkanInstance::get_timestamp_period() const
+{
+    return m_device_properties.limits.timestampPeriod;
+}
+
+uint32_t boitatah::vk::VulkanInstance::get_timestamp_valid_bits() const
+{
+    return m_timestamp_valid_bits;
+}
+
+bool boitatah::vk::VulkanInstance::supports_memory_budget() const
+{
+    return m_memory_budget;
+}
+
+uint32_t boitatah::vk::VulkanInstance::get_memory_heaps(MemoryHeaps &heaps) const
+{
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budget{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT,
+    };
+    if (m_memory_budget)
+    {
+        VkPhysicalDeviceMemoryProperties2 properties{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2,
+            .pNext = &budget,
+        };
+        vkGetPhysicalDeviceMemoryProperties2(m_physical_device, &properties);
+    }
+
+    std::lock_guard lock(m_memory_mutex);
+    uint32_t count = m_memory_properties.memoryHeapCount;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const auto &heap = m_memory_properties.memoryHeaps[i];
+        heaps[i] = {
+            .size = heap.size,
+            .deviceLocal = (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0,
+            .allocated = m_heap_allocated[i],
+            .allocations = m_heap_allocations[i],
+            .budget = budget.heapBudget[i],
+            .usage = budget.heapUsage[i],
+        };
+    }
+    return count;
+}
+
+void boitatah::vk::VulkanInstance::track_allocation(VkDeviceMemory memory, uint32_t type, VkDeviceSize size) const
+{
+    uint32_t heap = m_memory_properties.memoryTypes[type].heapIndex;
+    std::lock_guard lock(m_memory_mutex);
+    m_memory_allocations[memory] = {.heap = heap, .size = size};
+    m_heap_allocated[heap] += size;
+    m_heap_allocations[heap]++;
+}
+
+void boitatah::vk::VulkanInstance::track_free(VkDeviceMemory memory) const
+{
+    std::lock_guard lock(m_memory_mutex);
+    auto it = m_memory_allocations.find(memory);
+    if (it == m_memory_allocations.end())
+        return;
+    m_heap_allocated[it->second.heap] -= it->second.size;
+    m_heap_allocations[it->second.heap]--;
+    m_memory_allocations.erase(it);
+}
+
 boitatah::vk::QueueFamilyIndices boitatah::vk::VulkanInstance::find_queuefamilies(VkPhysicalDevice device) const
 {
     QueueFamilyIndices queueFamilies;
@@ -1213,11 +1545,6 @@ boitatah::vk::QueueFamilyIndices boitatah::vk::VulkanInstance::find_queuefamilie
         VkBool32 presentSupport = false;
         vkGetPhysicalDeviceSurfaceSupportKHR(device, i, window->getSurface(), &presentSupport);
 
-        if (family.queueFlags & VK_QUEUE_TRANSFER_BIT)
-        {
-            queueFamilies.transferFamily = i;
-        }
-
         if (presentSupport)
         {
             queueFamilies.presentFamily = i;
@@ -1229,6 +1556,29 @@ boitatah::vk::QueueFamilyIndices boitatah::vk::VulkanInstance::find_queuefamilie
         }
         i++;
     }
+
+    //prefer a dedicated transfer family for background uploads,
+    //a transfer only family first, then one without graphics.
+    //falls back to the graphics family.
+    std::optional<uint32_t> dedicated;
+    for (uint32_t index = 0; index < families.size(); index++)
+    {
+        auto flags = families[index].queueFlags;
+        if (!(flags & VK_QUEUE_TRANSFER_BIT) || (flags & VK_QUEUE_GRAPHICS_BIT))
+            continue;
+        if (!(flags & VK_QUEUE_COMPUTE_BIT))
+        {
+            dedicated = index;
+            break;
+        }
+        if (!dedicated.has_value())
+            dedicated = index;
+    }
+    if (dedicated.has_value())
+        queueFamilies.transferFamily = dedicated;
+    else if (queueFamilies.graphicsFamily.has_value())
+        queueFamilies.transferFamily = queueFamilies.graphicsFamily;
+
     return queueFamilies;
 }
 
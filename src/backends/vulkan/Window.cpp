@@ -9,6 +9,7 @@ namespace boitatah::vk
         glfwInit();
         glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
         glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+        glfwWindowHint(GLFW_VISIBLE, desc.visible ? GLFW_TRUE : GLFW_FALSE);
         window = glfwCreateWindow(desc.dimensions.x,
                                   desc.dimensions.y,
                                   desc.windowName,
@@ -17,6 +18,7 @@ namespace boitatah::vk
 
         glfwSetWindowUserPointer(window, this);
         glfwSetFramebufferSizeCallback(window, framebufferResizeCallback);
+        glfwGetFramebufferSize(window, &windowDimensions.x, &windowDimensions.y);
     }
     WindowManager::~WindowManager(void)
     {
@@ -0,0 +1,422 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boitatah/buffers/AllocationTrace.hpp>
+#include <boitatah/buffers/BufferAllocator.hpp>
+#include <boitatah/buffers/SlabAllocator.hpp>
+#include "../collections/PartitionList.hpp"
+
+using namespace boitatah;
+using namespace boitatah::buffer;
+
+/// Replays an allocation trace recorded with RendererOptions::allocationTrace
+/// against the buffer allocators, to tune partition sizes and tree heights offline.
+/// Reservations are grouped by usage and sharing like the buffer manager does,
+/// a group gets a new allocator when none of its allocators fits a request.
+///
+/// allocator_replay <trace> [partition bytes] [buddy height] [alignment]
+
+struct ReplayConfig{
+    VkDeviceSize partitionSize = 1024;
+    uint32_t height = 12;
+    uint32_t alignment = 256;
+};
+
+//where a live reservation of the trace was served.
+struct ReplaySlot{
+    uint32_t group = 0;
+    uint32_t instance = 0;
+    uint32_t i = 0;
+    uint32_t gen = 0;
+    VkDeviceSize occupied = 0;
+    bool live = false;
+};
+
+struct ReplayReport{
+    std::string name;
+    uint64_t events = 0;
+    double seconds = 0.0;
+    VkDeviceSize peakCapacity = 0;
+    VkDeviceSize peakRequested = 0;
+    //occupied bytes not requested, when the most bytes were live.
+    double internalFragmentation = 0.0;
+    //free bytes outside the largest free block of their allocator, sampled every frame.
+    double externalMean = 0.0;
+    double externalWorst = 0.0;
+    uint64_t failures = 0;
+    uint64_t instances = 0;
+};
+
+//groups allocators by usage and sharing, plus a size class for slabs.
+static uint64_t groupKey(const AllocationEvent &event, uint32_t sizeClass){
+    return static_cast<uint64_t>(event.usage) << 40 |
+           static_cast<uint64_t>(event.sharing) << 32 |
+           sizeClass;
+}
+
+//1 - largest / free summed over allocators.
+static double externalFragmentation(VkDeviceSize largest, VkDeviceSize free){
+    return free == 0 ? 0.0 : 1.0 - static_cast<double>(largest) / static_cast<double>(free);
+}
+
+class BuddyArena{
+    public:
+        BuddyArena(const ReplayConfig &config) : config(config) {}
+
+        std::string name() const { return "buddy"; }
+
+        bool reserve(const AllocationEvent &event, ReplaySlot &slot){
+            auto& group = groupOf(groupKey(event, 0), slot.group);
+            for(uint32_t i = 0; i <= group.size(); i++){
+                if(i == group.size()){
+                    if(event.size > instanceSize())
+                        return false;
+                    group.push_back(create());
+                }
+                auto handle = group[i]->allocate(event.size);
+                if(handle.isNull())
+                    continue;
+                VkDeviceSize offset;
+                group[i]->getBlockData(handle, offset, slot.occupied);
+                slot.instance = i;
+                slot.i = handle.i;
+                slot.gen = handle.gen;
+                return true;
+            }
+            return false;
+        }
+
+        void release(ReplaySlot &slot){
+            Handle<Block> handle{.i = slot.i, .gen = slot.gen};
+            groups[slot.group][slot.instance]->release(handle);
+        }
+
+        uint64_t instanceCount() const { return count; }
+        VkDeviceSize capacity() const { return count * instanceSize(); }
+
+        double external(){
+            VkDeviceSize largest = 0, free = 0;
+            for(auto& group : groups){
+                for(auto& allocator : group){
+                    largest += allocator->getLargestFreeBlockSize();
+                    free += allocator->freeSpace();
+                }
+            }
+            return externalFragmentation(largest, free);
+        }
+
+    private:
+        ReplayConfig config;
+        std::unordered_map<uint64_t, uint32_t> keys;
+        std::vector<std::vector<std::unique_ptr<BufferAllocator>>> groups;
+        uint64_t count = 0;
+
+        VkDeviceSize instanceSize() const { return config.partitionSize << config.height; }
+
+        std::vector<std::unique_ptr<BufferAllocator>>& groupOf(uint64_t key, uint32_t &index){
+            auto [position, created] = keys.try_emplace(key, static_cast<uint32_t>(groups.size()));
+            if(created)
+                groups.emplace_back();
+            index = position->second;
+            return groups[index];
+        }
+
+        std::unique_ptr<BufferAllocator> create(){
+            count++;
+            //the allocator reports its layout on creation.
+            auto buffer = std::cout.rdbuf(nullptr);
+            auto allocator = std::make_unique<BufferAllocator>(BufferAllocatorDesc{
+                .alignment = config.alignment,
+                .partitionSize = config.partitionSize,
+                .height = config.height,
+                .maxSize = 0,
+            });
+            std::cout.rdbuf(buffer);
+            return allocator;
+        }
+};
+
+class PartitionArena{
+    public:
+        PartitionArena(const ReplayConfig &config)
+            : size(static_cast<uint32_t>(std::min<VkDeviceSize>(config.partitionSize << config.height, UINT32_MAX))),
+              partitions(1u << 16) {}
+
+        std::string name() const { return "partition list"; }
+
+        bool reserve(const AllocationEvent &event, ReplaySlot &slot){
+            if(event.size > size)
+                return false;
+
+            auto& group = groupOf(groupKey(event, 0), slot.group);
+            for(uint32_t i = 0; i <= group.size(); i++){
+                if(i == group.size())
+                    group.push_back(create());
+                auto handle = group[i]->allocate(static_cast<uint32_t>(event.size));
+                if(handle.isNull())
+                    continue;
+                slot.occupied = event.size;
+                slot.instance = i;
+                slot.i = handle.i;
+                slot.gen = handle.gen;
+                return true;
+            }
+            return false;
+        }
+
+        void release(ReplaySlot &slot){
+            groups[slot.group][slot.instance]->release(Handle<Partition>{.i = slot.i, .gen = slot.gen});
+        }
+
+        uint64_t instanceCount() const { return count; }
+        VkDeviceSize capacity() const { return count * static_cast<VkDeviceSize>(size); }
+
+        double external(){
+            VkDeviceSize largest = 0, free = 0;
+            for(auto& group : groups){
+                for(auto& list : group){
+                    largest += list->getLargestFreeSpace();
+                    free += size - list->getOccupiedSpace();
+                }
+            }
+            return externalFragmentation(largest, free);
+        }
+
+    private:
+        uint32_t size;
+        uint32_t partitions;
+        std::unordered_map<uint64_t, uint32_t> keys;
+        std::vector<std::vector<std::unique_ptr<PartitionList>>> groups;
+        uint64_t count = 0;
+
+        std::vector<std::unique_ptr<PartitionList>>& groupOf(uint64_t key, uint32_t &index){
+            auto [position, created] = keys.try_emplace(key, static_cast<uint32_t>(groups.size()));
+            if(created)
+                groups.emplace_back();
+            index = position->second;
+            return groups[index];
+        }
+
+        std::unique_ptr<PartitionList> create(){
+            count++;
+            FreeListDesc desc{
+                .size = size,
+                .minPartitionSize = 0,
+                .maxPartitions = partitions,
+                .dynamic = true,
+            };
+            return std::make_unique<PartitionList>(desc);
+        }
+};
+
+//slabs for the small classes, buddy allocators for the rest, as the buffer manager serves them.
+class SlabArena{
+    public:
+        SlabArena(const ReplayConfig &config) : config(config), buddies(config) {}
+
+        std::string name() const { return "slab + buddy"; }
+
+        bool reserve(const AllocationEvent &event, ReplaySlot &slot){
+            uint32_t slotSize = slabSlotSize(event.size, config.alignment);
+            if(slotSize == 0){
+                if(!buddies.reserve(event, slot))
+                    return false;
+                //buddy groups are kept apart from slab groups.
+                slot.group |= BUDDY_GROUP;
+                return true;
+            }
+
+            auto& group = groupOf(groupKey(event, slotSize), slot.group);
+            for(uint32_t i = 0; i <= group.size(); i++){
+                if(i == group.size()){
+                    count++;
+                    group.push_back(std::make_unique<SlabAllocator>(SlabAllocatorDesc{
+                        .alignment = config.alignment,
+                        .slotSize = slotSize,
+                    }));
+                }
+                auto handle = group[i]->allocate(event.size);
+                if(handle.isNull())
+                    continue;
+                slot.occupied = group[i]->getSlotSize();
+                slot.instance = i;
+                slot.i = handle.i;
+                slot.gen = handle.gen;
+                return true;
+            }
+            return false;
+        }
+
+        void release(ReplaySlot &slot){
+            if(slot.group & BUDDY_GROUP){
+                ReplaySlot buddy = slot;
+                buddy.group &= ~BUDDY_GROUP;
+                buddies.release(buddy);
+                return;
+            }
+            Handle<Block> handle{.i = slot.i, .gen = slot.gen};
+            groups[slot.group][slot.instance]->release(handle);
+        }
+
+        uint64_t instanceCount() const { return count + buddies.instanceCount(); }
+
+        VkDeviceSize capacity() const {
+            VkDeviceSize bytes = buddies.capacity();
+            for(auto& group : groups){
+                for(auto& slab : group)
+                    bytes += slab->getSize();
+            }
+            return bytes;
+        }
+
+        //any free slot serves any request of its class, slabs don't fragment.
+        double external(){
+            return buddies.external();
+        }
+
+    private:
+        static constexpr uint32_t BUDDY_GROUP = 1u << 31;
+
+        ReplayConfig config;
+        BuddyArena buddies;
+        std::unordered_map<uint64_t, uint32_t> keys;
+        std::vector<std::vector<std::unique_ptr<SlabAllocator>>> groups;
+        uint64_t count = 0;
+
+        std::vector<std::unique_ptr<SlabAllocator>>& groupOf(uint64_t key, uint32_t &index){
+            auto [position, created] = keys.try_emplace(key, static_cast<uint32_t>(groups.size()));
+            if(created)
+                groups.emplace_back();
+            index = position->second;
+            return groups[index];
+        }
+};
+
+template<class Arena>
+static ReplayReport replay(const std::vector<AllocationEvent> &events, Arena &&arena){
+    ReplayReport report{.name = arena.name(), .events = events.size()};
+
+    std::vector<ReplaySlot> slots;
+    VkDeviceSize requested = 0;
+    VkDeviceSize occupied = 0;
+    uint32_t frame = events.empty() ? 0 : events.front().frame;
+    uint64_t frames = 0;
+    double externalSum = 0.0;
+
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::duration sampling{};
+
+    for(auto& event : events){
+        if(event.frame != frame){
+            //sampling walks every allocator, kept out of the timing.
+            auto sampleStart = std::chrono::steady_clock::now();
+            double external = arena.external();
+            sampling += std::chrono::steady_clock::now() - sampleStart;
+
+            externalSum += external;
+            report.externalWorst = std::max(report.externalWorst, external);
+            frames++;
+            frame = event.frame;
+        }
+
+        if(slots.size() <= event.id)
+            slots.resize(event.id + 1);
+        auto& slot = slots[event.id];
+
+        if(event.type == ALLOCATION_EVENT::RESERVE){
+            if(slot.live)
+                continue;
+            if(!arena.reserve(event, slot)){
+                report.failures++;
+                continue;
+            }
+            slot.live = true;
+            requested += event.size;
+            occupied += slot.occupied;
+            if(requested > report.peakRequested){
+                report.peakRequested = requested;
+                report.internalFragmentation = 1.0 - static_cast<double>(requested) /
+                                                     static_cast<double>(occupied);
+            }
+        }
+        else{
+            //frees of failed reservations.
+            if(!slot.live)
+                continue;
+            arena.release(slot);
+            slot.live = false;
+            requested -= event.size;
+            occupied -= slot.occupied;
+        }
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start - sampling;
+    report.seconds = elapsed.count();
+    report.externalMean = frames == 0 ? arena.external() : externalSum / frames;
+    //allocators are never released while replaying.
+    report.peakCapacity = arena.capacity();
+    report.instances = arena.instanceCount();
+    return report;
+}
+
+static std::string megabytes(VkDeviceSize bytes){
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2) << static_cast<double>(bytes) / (1024.0 * 1024.0) << "MiB";
+    return out.str();
+}
+
+int main(int argc, char **argv){
+    if(argc < 2){
+        std::cerr << "usage: allocator_replay <trace> [partition bytes] [buddy height] [alignment]" << std::endl;
+        return 1;
+    }
+
+    ReplayConfig config;
+    if(argc > 2)
+        config.partitionSize = std::stoull(argv[2]);
+    if(argc > 3)
+        config.height = static_cast<uint32_t>(std::stoul(argv[3]));
+    if(argc > 4)
+        config.alignment = static_cast<uint32_t>(std::stoul(argv[4]));
+
+    std::vector<AllocationEvent> events = readAllocationTrace(argv[1]);
+
+    uint64_t reserves = std::count_if(events.begin(), events.end(),
+                            [](const AllocationEvent &event){ return event.type == ALLOCATION_EVENT::RESERVE; });
+    std::cout << events.size() << " events, " << reserves << " reserves, "
+              << (events.empty() ? 0 : events.back().frame - events.front().frame + 1) << " frames" << std::endl;
+    std::cout << "allocator size " << megabytes(config.partitionSize << config.height)
+              << " partition " << config.partitionSize
+              << " height " << config.height
+              << " alignment " << config.alignment << std::endl << std::endl;
+
+    std::vector<ReplayReport> reports;
+    reports.push_back(replay(events, BuddyArena(config)));
+    reports.push_back(replay(events, PartitionArena(config)));
+    reports.push_back(replay(events, SlabArena(config)));
+
+    std::cout << "allocator\tMevents/s\tpeak memory\tpeak requested\tinternal\texternal mean\texternal worst\tallocators\tfailures" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    for(auto& report : reports){
+        double throughput = report.seconds > 0.0 ? report.events / report.seconds / 1e6 : 0.0;
+        std::cout << report.name << "\t"
+                  << throughput << "\t"
+                  << megabytes(report.peakCapacity) << "\t"
+                  << megabytes(report.peakRequested) << "\t"
+                  << report.internalFragmentation << "\t"
+                  << report.externalMean << "\t"
+                  << report.externalWorst << "\t"
+                  << report.instances << "\t"
+                  << report.failures << std::endl;
+    }
+
+    return 0;
+}
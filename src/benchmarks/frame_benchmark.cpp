@@ -0,0 +1,450 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boitatah/Renderer.hpp>
+#include <boitatah/BoitatahEnums.hpp>
+#include <boitatah/modules/Profiler.hpp>
+#include <boitatah/resources/builders/GeometryBuilder.hpp>
+
+using namespace boitatah;
+
+/// Renders a generated scene for a fixed number of frames and reports the time of each frame phase.
+/// The scene only depends on the parameters and the seed, so runs of two builds or two settings
+/// render the same work. Frames advance a fixed time step, never the wall clock.
+///
+/// The window is hidden. To run without a GPU point the vulkan loader at a software driver,
+/// e.g. VK_DRIVER_FILES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json under xvfb-run.
+///
+/// frame_benchmark [--objects N] [--geometries M] [--materials K] [--lights L]
+///                 [--moving percent] [--frames F] [--warmup W] [--seed S]
+///                 [--width W] [--height H] [--output file.json] [--trace trace.json]
+///                 [--gpu 0|1] [--memory memory.json]
+///
+/// The results also carry the renderer counters of the last frame, see Renderer::getFrameStats.
+/// --gpu 1 adds the gpu time of each stage scope, a few frames behind the cpu phases.
+/// --trace writes the profiler zones of the run, in builds with BOITATAH_PROFILER,
+/// and the gpu scopes with --gpu 1.
+/// --memory writes the renderer's memory report after the last frame.
+/// Builds with BOITATAH_ALLOC_AUDIT add the heap allocations per frame of each profiler zone,
+/// a steady state frame should have none outside the benchmark's own zones.
+
+struct BenchmarkScene{
+    uint32_t objects = 1000;
+    uint32_t geometries = 8;
+    uint32_t materials = 4;
+    uint32_t lights = 16;
+    //objects rotating every frame.
+    uint32_t movingPercent = 10;
+    uint32_t frames = 500;
+    uint32_t warmup = 20;
+    uint32_t seed = 1;
+    uint32_t width = 1280;
+    uint32_t height = 720;
+    //the renderer logs to stdout, results go to a file.
+    std::string output = "frame_benchmark.json";
+    std::string trace;
+    std::string memory;
+    bool gpu = false;
+};
+
+//mt19937 output is fixed by the standard, the distributions are not.
+struct SceneRandom{
+    std::mt19937 engine;
+
+    SceneRandom(uint32_t seed) : engine(seed) {}
+
+    float unit(){ return static_cast<float>(engine() >> 8) * (1.0f / 16777216.0f); }
+    float range(float min, float max){ return min + (max - min) * unit(); }
+    uint32_t below(uint32_t count){ return static_cast<uint32_t>(engine() % count); }
+};
+
+//heap allocations of a zone summed over the measured frames.
+struct ZoneAllocations{
+    const char* zone = nullptr;
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+    uint64_t frees = 0;
+};
+
+//mean and percentiles of one phase over the measured frames.
+struct PhaseSummary{
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double max = 0.0;
+};
+
+static PhaseSummary summarize(std::vector<double> samples){
+    PhaseSummary summary;
+    if(samples.empty())
+        return summary;
+    std::sort(samples.begin(), samples.end());
+    for(auto sample : samples)
+        summary.mean += sample;
+    summary.mean /= samples.size();
+    summary.p50 = samples[samples.size() / 2];
+    summary.p95 = samples[std::min(samples.size() - 1, samples.size() * 95 / 100)];
+    summary.max = samples.back();
+    return summary;
+}
+
+static bool parseArguments(int argc, char **argv, BenchmarkScene &scene){
+    for(int i = 1; i < argc; i++){
+        std::string argument = argv[i];
+        if(i + 1 >= argc)
+            return false;
+        std::string value = argv[++i];
+
+        if(argument == "--output"){
+            scene.output = value;
+            continue;
+        }
+        if(argument == "--trace"){
+            scene.trace = value;
+            continue;
+        }
+        if(argument == "--memory"){
+            scene.memory = value;
+            continue;
+        }
+
+        uint32_t number = static_cast<uint32_t>(std::stoul(value));
+        if(argument == "--objects")         scene.objects = number;
+        else if(argument == "--geometries") scene.geometries = std::max(1u, number);
+        else if(argument == "--materials")  scene.materials = std::max(1u, number);
+        else if(argument == "--lights")     scene.lights = number;
+        else if(argument == "--moving")     scene.movingPercent = std::min(100u, number);
+        else if(argument == "--frames")     scene.frames = number;
+        else if(argument == "--warmup")     scene.warmup = number;
+        else if(argument == "--seed")       scene.seed = number;
+        else if(argument == "--width")      scene.width = number;
+        else if(argument == "--height")     scene.height = number;
+        else if(argument == "--gpu")        scene.gpu = number != 0;
+        else return false;
+    }
+    return true;
+}
+
+//a checker of two colors, so materials differ in what they sample.
+static Handle<RenderTexture> checkerTexture(GPUResourceManager &manager, SceneRandom &random){
+    const uint32_t size = 64;
+    uint32_t colors[2];
+    for(auto& color : colors)
+        color = 0xFF000000u | (random.engine() & 0x00FFFFFFu);
+
+    std::vector<uint32_t> pixels(size * size);
+    for(uint32_t y = 0; y < size; y++){
+        for(uint32_t x = 0; x < size; x++)
+            pixels[y * size + x] = colors[((x / 8) + (y / 8)) % 2];
+    }
+
+    auto texture = manager.create(TextureCreateDescription{
+        .width = size,
+        .height = size,
+        .depth = 1,
+        .format = IMAGE_FORMAT::RGBA_8_SRGB,
+        .textureMode = TextureMode::READ,
+        .samplerInfo = SamplerData(),
+    });
+    manager.uploadTexture(texture, pixels.data());
+    return texture;
+}
+
+//cycles through the procedural shapes, their detail grows with the index.
+static Handle<Geometry> generatedGeometry(GPUResourceManager &manager, uint32_t index){
+    uint32_t detail = 8 + 4 * (index / 4);
+    switch(index % 4){
+        case 0:  return GeometryBuilder::Sphere(manager, 0.5f, detail);
+        case 1:  return GeometryBuilder::Cylinder(manager, 0.4f, 1.0f, 4, detail);
+        case 2:  return GeometryBuilder::Icosahedron(manager);
+        default: return GeometryBuilder::Pipe(manager, 0.4f, 1.0f, 4, detail);
+    }
+}
+
+static std::string toJson(const BenchmarkScene &scene,
+                          double setupMs,
+                          double firstFrameMs,
+                          const std::vector<std::pair<std::string, PhaseSummary>> &phases,
+                          const FrameStats &stats,
+                          const std::vector<ZoneAllocations> &allocations){
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(4);
+    out << "{\n  \"suite\": \"boitatah_frame_benchmark\",\n";
+    out << "  \"scene\": {\"objects\": " << scene.objects
+        << ", \"geometries\": " << scene.geometries
+        << ", \"materials\": " << scene.materials
+        << ", \"lights\": " << scene.lights
+        << ", \"moving_percent\": " << scene.movingPercent
+        << ", \"frames\": " << scene.frames
+        << ", \"warmup\": " << scene.warmup
+        << ", \"seed\": " << scene.seed
+        << ", \"width\": " << scene.width
+        << ", \"height\": " << scene.height << "},\n";
+    out << "  \"setup_ms\": " << setupMs << ",\n";
+    out << "  \"first_frame_ms\": " << firstFrameMs << ",\n";
+    out << "  \"phases\": [\n";
+    for(std::size_t i = 0; i < phases.size(); i++){
+        auto& [name, summary] = phases[i];
+        out << "    {\"name\": \"" << name << "\""
+            << ", \"mean_ms\": " << summary.mean
+            << ", \"p50_ms\": " << summary.p50
+            << ", \"p95_ms\": " << summary.p95
+            << ", \"max_ms\": " << summary.max << "}"
+            << (i + 1 < phases.size() ? "," : "") << "\n";
+    }
+    out << "  ],\n";
+    //tells apart a change that made the frame cheaper from one that made it do less.
+    auto& total = stats.total;
+    out << "  \"last_frame\": {\"draws\": " << total.commands.draws
+        << ", \"instances\": " << total.commands.instances
+        << ", \"triangles\": " << total.commands.triangles
+        << ", \"culled\": " << total.culled
+        << ", \"pipeline_binds\": " << total.commands.pipelines
+        << ", \"set_binds\": " << total.commands.sets
+        << ", \"vertex_buffer_binds\": " << total.commands.vertexBuffers
+        << ", \"index_buffer_binds\": " << total.commands.indexBuffers
+        << ", \"skipped_binds\": " << total.commands.skipped()
+        << ", \"copies\": " << total.commands.copies
+        << ", \"descriptor_allocations\": " << total.descriptorAllocations
+        << ", \"descriptor_writes\": " << total.descriptorWrites
+        << ", \"uploaded_bytes\": " << total.uploadedBytes
+        << ", \"batches\": " << total.batches
+        << ", \"queue_submits\": " << stats.queueSubmits
+        << ", \"staging_bytes\": " << stats.stagingBytes << "}";
+#ifdef BOITATAH_ALLOC_AUDIT
+    out << ",\n  \"allocations_per_frame\": [\n";
+    double frames = std::max(1u, scene.frames);
+    for(std::size_t i = 0; i < allocations.size(); i++){
+        auto& zone = allocations[i];
+        out << "    {\"zone\": " << std::quoted(zone.zone)
+            << ", \"allocations\": " << zone.allocations / frames
+            << ", \"bytes\": " << zone.bytes / frames
+            << ", \"frees\": " << zone.frees / frames << "}"
+            << (i + 1 < allocations.size() ? "," : "") << "\n";
+    }
+    out << "  ]";
+#else
+    (void)allocations;
+#endif
+    out << "\n}\n";
+    return out.str();
+}
+
+int main(int argc, char **argv){
+    BenchmarkScene config;
+    if(!parseArguments(argc, argv, config)){
+        std::cerr << "usage: frame_benchmark [--objects N] [--geometries M] [--materials K] [--lights L]\n"
+                     "                       [--moving percent] [--frames F] [--warmup W] [--seed S]\n"
+                     "                       [--width W] [--height H] [--output file.json] [--trace trace.json]\n"
+                     "                       [--gpu 0|1] [--memory memory.json]" << std::endl;
+        return 1;
+    }
+
+    auto setupStart = std::chrono::steady_clock::now();
+
+    Renderer r({
+        .windowDimensions = {config.width, config.height},
+        .appName = "Frame Benchmark",
+        .debug = false,
+        .swapchainFormat = IMAGE_FORMAT::BGRA_8_SRGB,
+        .backBufferDesc = BackBufferManager::BasicDeferredPipeline(config.width, config.height),
+        .hiddenWindow = true,
+        .gpuProfiling = config.gpu,
+    });
+    auto& manager = r.getResourceManager();
+    SceneRandom random(config.seed);
+
+    std::vector<Handle<RenderTexture>> textures;
+    std::vector<Handle<Material>> materials;
+    for(uint32_t i = 0; i < config.materials; i++){
+        textures.push_back(checkerTexture(manager, random));
+        materials.push_back(r.getMaterials().createLambertMaterial(0, 100, textures.back()));
+    }
+
+    std::vector<Handle<Geometry>> geometries;
+    for(uint32_t i = 0; i < config.geometries; i++)
+        geometries.push_back(generatedGeometry(manager, i));
+
+    //objects fill a square field around the origin.
+    auto scene = RenderScene::create_node({.name = "root scene"});
+    float extent = std::sqrt(static_cast<float>(std::max(1u, config.objects))) * 1.5f;
+    std::vector<std::shared_ptr<RenderScene>> moving;
+    for(uint32_t i = 0; i < config.objects; i++){
+        auto node = RenderScene::create_node({
+            .name = "object",
+            .content = {.geometry = geometries[random.below(config.geometries)],
+                        .material = materials[random.below(config.materials)]},
+            .position = glm::vec3(random.range(-extent, extent),
+                                  random.range(-2.0f, 0.0f),
+                                  random.range(-extent, extent)),
+            .rotation = glm::vec3(random.range(0.0f, glm::two_pi<float>()), 0.0f, 0.0f),
+        });
+        scene->add(node);
+        if(random.below(100) < config.movingPercent)
+            moving.push_back(node);
+    }
+
+    Handle<LightArray> lightHandle = r.createLightArray(std::max(1u, config.lights));
+    r.set_light_array(lightHandle);
+    auto& lights = r.getLightArray(lightHandle);
+    std::vector<float> lightPhases;
+    for(uint32_t i = 0; i < config.lights; i++){
+        lights.addLight({
+            .position = glm::vec4(random.range(-extent, extent), -4.0f, random.range(-extent, extent), 0),
+            .color = glm::vec4(random.range(0.2f, 1.0f), random.range(0.2f, 1.0f), random.range(0.2f, 1.0f), 0),
+            .intensity = random.range(2.0f, 10.0f),
+        });
+        lightPhases.push_back(random.range(0.0f, glm::two_pi<float>()));
+    }
+    lights.update();
+
+    //the light loop is bounded by the scene's light count.
+    auto composer = r.getMaterials().createLambertDeferredComposeMaterial(
+                        1, 150u, {Materials::maxLights(std::max(1u, config.lights))});
+    r.getMaterialManager().setBufferBindingAttribute(composer, lights.metadata(), 1, 0);
+    r.getMaterialManager().setBufferBindingAttribute(composer, lights.light_array(), 1, 1);
+    scene->add(RenderScene::create_node({
+        .name = "composer",
+        .content = {.geometry = GeometryBuilder::Quad(manager), .material = composer},
+    }));
+
+    BufferedCamera camera = r.create_camera({
+        .position = glm::vec3(0, -extent, -extent),
+        .far = extent * 4.0f,
+        .aspect = static_cast<float>(config.width) / config.height,
+    });
+    camera.lookAt(glm::vec3(0));
+
+    std::chrono::duration<double, std::milli> setup = std::chrono::steady_clock::now() - setupStart;
+
+    const char *phaseNames[] = {"animate", "transforms", "extract", "wait", "prepare", "record", "present", "frame"};
+    std::vector<std::vector<double>> samples(std::size(phaseNames));
+    for(auto& phase : samples)
+        phase.reserve(config.frames);
+    std::vector<ZoneAllocations> allocations;
+    //gpu scope names are interned, the pointer identifies a scope.
+    std::vector<std::pair<const char*, std::vector<double>>> gpuSamples;
+    double firstFrame = 0.0;
+
+    //every frame advances the same step.
+    const float step = 1.0f / 60.0f;
+    for(uint32_t frame = 0; frame < config.warmup + config.frames; frame++){
+        float t = frame * step;
+        auto frameStart = std::chrono::steady_clock::now();
+
+        for(auto& node : moving)
+            node->rotate(glm::vec3(0.0f, 1.0f, 0.0f), step);
+        for(uint32_t i = 0; i < config.lights; i++){
+            float phase = t + lightPhases[i];
+            lights[i].position.x += 0.05f * std::sin(phase);
+            lights[i].position.z += 0.05f * std::cos(phase);
+        }
+        lights.update();
+        camera.setPosition(glm::vec3(extent * std::sin(t * 0.1f), -extent, -extent * std::cos(t * 0.1f)));
+        camera.lookAt(glm::vec3(0));
+        std::chrono::duration<double, std::milli> animate = std::chrono::steady_clock::now() - frameStart;
+
+        r.render_tree(scene, camera);
+        std::chrono::duration<double, std::milli> total = std::chrono::steady_clock::now() - frameStart;
+
+        if(frame == 0)
+            firstFrame = total.count();
+        if(frame < config.warmup)
+            continue;
+
+        //the bookkeeping allocates, its own zone keeps it apart from the renderer's.
+        BOITATAH_ZONE("frame_benchmark samples");
+        for(auto& counts : r.getFrameAllocations()){
+            auto it = std::find_if(allocations.begin(), allocations.end(),
+                                   [&](auto& entry){ return entry.zone == counts.scope; });
+            if(it == allocations.end())
+                it = allocations.insert(allocations.end(), {.zone = counts.scope});
+            it->allocations += counts.allocations;
+            it->bytes += counts.bytes;
+            it->frees += counts.frees;
+        }
+
+        const auto& timings = r.getFrameTimings();
+        double phases[] = {animate.count(), timings.transforms, timings.extract, timings.wait,
+                           timings.prepare, timings.record, timings.present, total.count()};
+        for(std::size_t p = 0; p < std::size(phases); p++)
+            samples[p].push_back(phases[p]);
+
+        for(auto& timing : r.getGpuTimings()){
+            auto it = std::find_if(gpuSamples.begin(), gpuSamples.end(),
+                                   [&](auto& entry){ return entry.first == timing.name; });
+            if(it == gpuSamples.end())
+                it = gpuSamples.insert(gpuSamples.end(), {timing.name, {}});
+            it->second.push_back(timing.ms);
+        }
+    }
+
+    r.waitIdle();
+    std::sort(allocations.begin(), allocations.end(),
+              [](auto& a, auto& b){ return a.bytes > b.bytes; });
+
+    std::vector<std::pair<std::string, PhaseSummary>> phases;
+    for(std::size_t p = 0; p < std::size(phaseNames); p++)
+        phases.push_back({phaseNames[p], summarize(samples[p])});
+    for(auto& [name, gpu] : gpuSamples)
+        phases.push_back({std::string("gpu ") + name, summarize(gpu)});
+
+    std::ofstream file(config.output);
+    if(!file){
+        std::cerr << "failed to open " << config.output << std::endl;
+        return 1;
+    }
+    file << toJson(config, setup.count(), firstFrame, phases, r.getFrameStats(), allocations);
+
+    std::cout << std::endl << std::fixed << std::setprecision(3) << "phase\tmean ms\tp95 ms" << std::endl;
+    for(auto& [name, summary] : phases)
+        std::cout << name << "\t" << summary.mean << "\t" << summary.p95 << std::endl;
+#ifdef BOITATAH_ALLOC_AUDIT
+    std::cout << std::endl << "zone\tallocations/frame\tbytes/frame" << std::endl;
+    for(auto& zone : allocations)
+        std::cout << zone.zone << "\t" << zone.allocations / double(std::max(1u, config.frames))
+                  << "\t" << zone.bytes / double(std::max(1u, config.frames)) << std::endl;
+#endif
+    std::cout << "results written to " << config.output << std::endl;
+
+    if(!config.trace.empty()){
+#ifdef BOITATAH_PROFILER
+        bool traced = true;
+#else
+        bool traced = config.gpu;
+#endif
+        if(traced){
+            profiler::write_chrome_trace(config.trace);
+            std::cout << "trace written to " << config.trace << std::endl;
+        }else{
+            std::cout << "no trace written, profiler zones are not compiled in" << std::endl;
+        }
+    }
+
+    if(!config.memory.empty()){
+        std::ofstream memory(config.memory);
+        if(!memory){
+            std::cerr << "failed to open " << config.memory << std::endl;
+            return 1;
+        }
+        memory << r.getMemoryReport().toJson();
+        std::cout << "memory report written to " << config.memory << std::endl;
+    }
+
+    for(auto texture : textures)
+        manager.destroy(texture);
+    for(auto geometry : geometries)
+        manager.destroy(geometry);
+
+    return EXIT_SUCCESS;
+}
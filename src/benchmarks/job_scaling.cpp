@@ -0,0 +1,69 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <boitatah/modules/JobSystem.hpp>
+
+using namespace boitatah;
+
+/// Times a transform-like workload on the job system from 1 to N threads.
+/// Each item composes a chain of matrices, roughly the cost of
+/// updating a scene node plus its bounds.
+int main(){
+    const uint32_t itemCount = 1 << 18;
+    const uint32_t chainLength = 16;
+    const uint32_t grain = 256;
+    const uint32_t repeats = 5;
+
+    std::vector<glm::mat4> locals(itemCount);
+    std::vector<glm::mat4> globals(itemCount);
+    for(uint32_t i = 0; i < itemCount; i++)
+        locals[i] = glm::translate(glm::mat4(1.0f), glm::vec3(i % 7, i % 11, i % 13));
+
+    auto work = [&](uint32_t begin, uint32_t end){
+        for(uint32_t i = begin; i < end; i++){
+            glm::mat4 m = locals[i];
+            for(uint32_t c = 0; c < chainLength; c++)
+                m = glm::rotate(m, 0.01f * c, glm::vec3(0.0f, 1.0f, 0.0f)) * locals[(i + c) % itemCount];
+            globals[i] = m;
+        }
+    };
+
+    uint32_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    double baseline = 0.0;
+
+    std::cout << "threads\tms\tspeedup" << std::endl;
+    for(uint32_t threads = 1; threads <= maxThreads; threads++){
+        JobSystem jobs(threads);
+
+        //warm up, threads and caches.
+        jobs.parallel_for(itemCount, grain, work);
+
+        double best = 0.0;
+        for(uint32_t r = 0; r < repeats; r++){
+            auto start = std::chrono::steady_clock::now();
+            jobs.parallel_for(itemCount, grain, work);
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            if(r == 0 || elapsed.count() < best)
+                best = elapsed.count();
+        }
+        if(threads == 1)
+            baseline = best;
+
+        std::cout << threads << "\t" << best << "\t" << baseline / best << std::endl;
+    }
+
+    //keeps the work from being optimized away.
+    float checksum = 0.0f;
+    for(uint32_t i = 0; i < itemCount; i += 1024)
+        checksum += globals[i][3][0];
+    std::cout << "checksum " << checksum << std::endl;
+
+    return 0;
+}
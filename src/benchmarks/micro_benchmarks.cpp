@@ -0,0 +1,325 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <boitatah/collections/Pool.hpp>
+#include <boitatah/buffers/BufferAllocator.hpp>
+#include <boitatah/scene/Scene.hpp>
+#include <boitatah/resources/builders/GeometryData.hpp>
+#include "../collections/PartitionList.hpp"
+
+using namespace boitatah;
+using namespace boitatah::buffer;
+
+/// CPU only microbenchmarks of the collections, allocators, scene tree and geometry building.
+/// Every benchmark runs a few times after a warm up, the best and mean times are written
+/// as JSON to stdout or to the file given as first argument, to compare builds over time.
+///
+/// micro_benchmarks [output.json]
+
+struct BenchmarkResult{
+    std::string name;
+    uint64_t operations = 0;
+    double bestMs = 0.0;
+    double meanMs = 0.0;
+};
+
+//results of measured work end up here so it isn't optimized away.
+static uint64_t g_sink = 0;
+
+constexpr uint32_t REPEATS = 10;
+
+//prepare runs before every repeat and is not timed,
+//measure returns the operations it performed.
+static BenchmarkResult runBenchmark(const std::string &name,
+                                    const std::function<void()> &prepare,
+                                    const std::function<uint64_t()> &measure){
+    BenchmarkResult result{.name = name};
+
+    prepare();
+    measure();
+
+    double total = 0.0;
+    for(uint32_t r = 0; r < REPEATS; r++){
+        prepare();
+        auto start = std::chrono::steady_clock::now();
+        uint64_t operations = measure();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        total += elapsed.count();
+        if(r == 0 || elapsed.count() < result.bestMs){
+            result.bestMs = elapsed.count();
+            result.operations = operations;
+        }
+    }
+    result.meanMs = total / REPEATS;
+    return result;
+}
+
+//the buffer allocator reports its layout on creation.
+static std::unique_ptr<BufferAllocator> quietBufferAllocator(const BufferAllocatorDesc &desc){
+    auto buffer = std::cout.rdbuf(nullptr);
+    auto allocator = std::make_unique<BufferAllocator>(desc);
+    std::cout.rdbuf(buffer);
+    return allocator;
+}
+
+static void poolBenchmarks(std::vector<BenchmarkResult> &results){
+    const uint32_t count = 1 << 16;
+    std::unique_ptr<Pool<uint64_t>> pool;
+    std::vector<Handle<uint64_t>> handles(count);
+    std::mt19937 rng(1);
+
+    auto fixedPool = [&](){
+        pool = std::make_unique<Pool<uint64_t>>(PoolOptions{.size = count, .dynamic = false, .name = "bench"});
+    };
+    auto filledPool = [&](){
+        fixedPool();
+        for(uint64_t i = 0; i < count; i++)
+            handles[i] = pool->set(i);
+        std::shuffle(handles.begin(), handles.end(), rng);
+    };
+
+    results.push_back(runBenchmark("pool_set", fixedPool, [&](){
+        for(uint64_t i = 0; i < count; i++)
+            handles[i] = pool->set(i);
+        return count;
+    }));
+
+    results.push_back(runBenchmark("pool_get_random", filledPool, [&](){
+        uint64_t sum = 0;
+        for(auto handle : handles)
+            sum += pool->get(handle);
+        g_sink += sum;
+        return count;
+    }));
+
+    results.push_back(runBenchmark("pool_clear_random", filledPool, [&](){
+        for(auto handle : handles)
+            pool->clear(handle);
+        return count;
+    }));
+
+    results.push_back(runBenchmark("pool_set_growing", [&](){
+        pool = std::make_unique<Pool<uint64_t>>(PoolOptions{.size = 16, .dynamic = true, .name = "bench"});
+    }, [&](){
+        for(uint64_t i = 0; i < count; i++)
+            handles[i] = pool->set(i);
+        g_sink += pool->get(handles[count - 1]);
+        return count;
+    }));
+}
+
+//allocate until full then release in order, and random churn around half occupancy.
+template<class Allocate, class Release>
+static void allocatorBenchmarks(std::vector<BenchmarkResult> &results,
+                                const std::string &name,
+                                const std::function<void()> &create,
+                                Allocate allocate,
+                                Release release){
+    const uint32_t steps = 1 << 15;
+    std::mt19937 rng(2);
+    std::uniform_int_distribution<uint32_t> sizes(256, 16 * 1024);
+    std::vector<uint32_t> requests(steps);
+    for(auto& request : requests)
+        request = sizes(rng);
+
+    std::vector<uint32_t> live;
+    live.reserve(steps);
+
+    results.push_back(runBenchmark(name + "_fill_release", create, [&](){
+        live.clear();
+        for(auto request : requests){
+            uint32_t id;
+            if(!allocate(request, id))
+                break;
+            live.push_back(id);
+        }
+        for(auto id : live)
+            release(id);
+        return static_cast<uint64_t>(live.size() * 2);
+    }));
+
+    results.push_back(runBenchmark(name + "_churn", create, [&](){
+        live.clear();
+        std::mt19937 steady(3);
+        uint64_t operations = 0;
+        for(auto request : requests){
+            if(!live.empty() && (steady() & 1)){
+                uint32_t index = steady() % live.size();
+                release(live[index]);
+                live[index] = live.back();
+                live.pop_back();
+                operations++;
+                continue;
+            }
+            uint32_t id;
+            if(allocate(request, id)){
+                live.push_back(id);
+                operations++;
+            }
+        }
+        for(auto id : live)
+            release(id);
+        return operations + live.size();
+    }));
+}
+
+static void bufferAllocatorBenchmarks(std::vector<BenchmarkResult> &results){
+    std::unique_ptr<BufferAllocator> allocator;
+    std::vector<Handle<Block>> blocks;
+
+    allocatorBenchmarks(results, "buffer_allocator", [&](){
+        allocator = quietBufferAllocator({.alignment = 256, .partitionSize = 256, .height = 14, .maxSize = 0});
+        blocks.clear();
+    }, [&](uint32_t request, uint32_t &id){
+        auto block = allocator->allocate(request);
+        if(block.isNull())
+            return false;
+        id = static_cast<uint32_t>(blocks.size());
+        blocks.push_back(block);
+        return true;
+    }, [&](uint32_t id){
+        allocator->release(blocks[id]);
+    });
+}
+
+static void partitionListBenchmarks(std::vector<BenchmarkResult> &results){
+    std::unique_ptr<PartitionList> list;
+    std::vector<Handle<Partition>> partitions;
+
+    allocatorBenchmarks(results, "partition_list", [&](){
+        FreeListDesc desc{.size = 256u << 14, .minPartitionSize = 0, .maxPartitions = 1 << 16, .dynamic = true};
+        list = std::make_unique<PartitionList>(desc);
+        partitions.clear();
+    }, [&](uint32_t request, uint32_t &id){
+        auto partition = list->allocate(request);
+        if(partition.isNull())
+            return false;
+        id = static_cast<uint32_t>(partitions.size());
+        partitions.push_back(partition);
+        return true;
+    }, [&](uint32_t id){
+        list->release(partitions[id]);
+    });
+}
+
+static void sceneTreeBenchmarks(std::vector<BenchmarkResult> &results){
+    //fan out of 4, 7 levels deep.
+    const uint32_t fanOut = 4;
+    const uint32_t depth = 7;
+
+    auto root = SceneTree<uint32_t>::create_node({.name = "root"});
+    std::vector<std::shared_ptr<SceneTree<uint32_t>>> nodes{root};
+    std::vector<std::shared_ptr<SceneTree<uint32_t>>> level{root};
+    for(uint32_t d = 1; d < depth; d++){
+        std::vector<std::shared_ptr<SceneTree<uint32_t>>> next;
+        for(auto& parent : level){
+            for(uint32_t c = 0; c < fanOut; c++){
+                auto child = SceneTree<uint32_t>::create_node({
+                    .content = static_cast<uint32_t>(nodes.size()),
+                    .position = glm::vec3(c, d, 0.0f),
+                    .rotation = glm::vec3(0.1f * c, 0.0f, 0.0f),
+                });
+                parent->add(child);
+                next.push_back(child);
+                nodes.push_back(child);
+            }
+        }
+        level.swap(next);
+    }
+
+    auto globalMatrices = [&](){
+        float sum = 0.0f;
+        for(auto& node : nodes)
+            sum += node->getGlobalMatrix()[3][0];
+        g_sink += static_cast<uint64_t>(sum);
+        return static_cast<uint64_t>(nodes.size());
+    };
+
+    //every node is dirty, as when the root moves.
+    results.push_back(runBenchmark("scene_tree_update_all", [&](){
+        root->translate(glm::vec3(0.01f, 0.0f, 0.0f));
+    }, globalMatrices));
+
+    //only the leaves under one child of the root.
+    results.push_back(runBenchmark("scene_tree_update_subtree", [&](){
+        root->children[0]->translate(glm::vec3(0.01f, 0.0f, 0.0f));
+    }, globalMatrices));
+}
+
+static void geometryBenchmarks(std::vector<BenchmarkResult> &results){
+    results.push_back(runBenchmark("geometry_uv_sphere_64", [](){}, [](){
+        auto sphere = uv_sphere(1.0f, 64, 64);
+        g_sink += sphere.indices.size();
+        return static_cast<uint64_t>(sphere.vertices.size());
+    }));
+
+    //64 transformed cylinders merged into one mesh.
+    results.push_back(runBenchmark("geometry_merge_cylinders", [](){}, [](){
+        GeometryBuildData merged{};
+        for(uint32_t i = 0; i < 64; i++){
+            auto cylinder_data = cylinder(0.5f, 2.0f, 4, 24);
+            cylinder_data.transform(glm::translate(glm::mat4(1.0f), glm::vec3(i, 0.0f, 0.0f)));
+            merged += cylinder_data;
+        }
+        g_sink += merged.indices.size();
+        return static_cast<uint64_t>(merged.vertices.size());
+    }));
+}
+
+static std::string toJson(const std::vector<BenchmarkResult> &results){
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(4);
+    out << "{\n  \"suite\": \"boitatah_micro_benchmarks\",\n  \"repeats\": " << REPEATS << ",\n";
+    out << "  \"benchmarks\": [\n";
+    for(std::size_t i = 0; i < results.size(); i++){
+        auto& result = results[i];
+        double nsPerOperation = result.operations == 0 ? 0.0 : result.bestMs * 1e6 / result.operations;
+        out << "    {\"name\": \"" << result.name << "\""
+            << ", \"operations\": " << result.operations
+            << ", \"best_ms\": " << result.bestMs
+            << ", \"mean_ms\": " << result.meanMs
+            << ", \"ns_per_op\": " << nsPerOperation << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ],\n  \"checksum\": " << g_sink << "\n}\n";
+    return out.str();
+}
+
+int main(int argc, char **argv){
+    std::vector<BenchmarkResult> results;
+
+    poolBenchmarks(results);
+    bufferAllocatorBenchmarks(results);
+    partitionListBenchmarks(results);
+    sceneTreeBenchmarks(results);
+    geometryBenchmarks(results);
+
+    std::string json = toJson(results);
+    if(argc > 1){
+        std::ofstream file(argv[1]);
+        if(!file){
+            std::cerr << "failed to open " << argv[1] << std::endl;
+            return 1;
+        }
+        file << json;
+    }
+    else{
+        std::cout << json;
+    }
+
+    return 0;
+}
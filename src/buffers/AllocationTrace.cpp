@@ -0,0 +1,70 @@
+#include <boitatah/buffers/AllocationTrace.hpp>
+#include <stdexcept>
+
+namespace boitatah::buffer
+{
+    constexpr std::size_t PENDING_EVENTS = 4096;
+
+    AllocationTraceRecorder::AllocationTraceRecorder(const std::string &path)
+        : file(path, std::ios::binary | std::ios::trunc)
+    {
+        if(!file)
+            throw std::runtime_error("failed to open allocation trace " + path);
+
+        uint32_t header[2] = {ALLOCATION_TRACE_MAGIC, ALLOCATION_TRACE_VERSION};
+        file.write(reinterpret_cast<const char *>(header), sizeof(header));
+        pending.reserve(PENDING_EVENTS);
+    }
+
+    AllocationTraceRecorder::~AllocationTraceRecorder(void)
+    {
+        flush();
+    }
+
+    void AllocationTraceRecorder::record(const AllocationEvent &event)
+    {
+        pending.push_back(event);
+        eventCount++;
+        if(pending.size() == PENDING_EVENTS)
+            flush();
+    }
+
+    void AllocationTraceRecorder::flush()
+    {
+        if(pending.empty())
+            return;
+        file.write(reinterpret_cast<const char *>(pending.data()),
+                   static_cast<std::streamsize>(pending.size() * sizeof(AllocationEvent)));
+        file.flush();
+        pending.clear();
+    }
+
+    uint64_t AllocationTraceRecorder::getEventCount() const
+    {
+        return eventCount;
+    }
+
+    std::vector<AllocationEvent> readAllocationTrace(const std::string &path)
+    {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if(!file)
+            throw std::runtime_error("failed to open allocation trace " + path);
+
+        std::streamsize bytes = file.tellg();
+        file.seekg(0);
+
+        uint32_t header[2] = {};
+        if(bytes < static_cast<std::streamsize>(sizeof(header)) ||
+           !file.read(reinterpret_cast<char *>(header), sizeof(header)) ||
+           header[0] != ALLOCATION_TRACE_MAGIC)
+            throw std::runtime_error(path + " is not an allocation trace");
+        if(header[1] != ALLOCATION_TRACE_VERSION)
+            throw std::runtime_error(path + " has an unsupported allocation trace version");
+
+        //a trace cut by a crash keeps its whole events.
+        std::vector<AllocationEvent> events((bytes - sizeof(header)) / sizeof(AllocationEvent));
+        file.read(reinterpret_cast<char *>(events.data()),
+                  static_cast<std::streamsize>(events.size() * sizeof(AllocationEvent)));
+        return events;
+    }
+}
@@ -1,6 +1,7 @@
 #include <boitatah/buffers/Buffer.hpp>
 #include <boitatah/buffers/BufferManager.hpp>
 #include <boitatah/backend/vulkan/Vulkan.hpp>
+#include <algorithm>
 #include <bit>
 
 namespace boitatah::buffer
@@ -29,7 +30,8 @@ namespace boitatah::buffer
 
         setupBuffer(desc.estimatedElementSize, desc.partitions);
 
-        blockSize = mainAllocator->getPartitionSize();
+        blockSize = slabAllocator ? slabAllocator->getSlotSize() :
+                                    mainAllocator->getPartitionSize();
         buffer_quantity += 1;
         bufferManager = desc.bufferManager;
     }
@@ -55,9 +57,10 @@ namespace boitatah::buffer
         return false;
     }
 
-    Handle<BufferReservation> Buffer::reserve(const uint32_t request)
+    Handle<BufferReservation> Buffer::reserve(const VkDeviceSize request)
     {
-        auto blockHandle = mainAllocator->allocate(request);
+        auto blockHandle = slabAllocator ? slabAllocator->allocate(request) :
+                                           mainAllocator->allocate(request);
 
         // failed to reserve a buffer.
         if (!blockHandle){
@@ -66,7 +69,10 @@ namespace boitatah::buffer
         }
 
         BufferReservation reservation{};
-        mainAllocator->getBlockData(blockHandle, reservation.offset, reservation.size);
+        if(slabAllocator)
+            slabAllocator->getBlockData(blockHandle, reservation.offset, reservation.size);
+        else
+            mainAllocator->getBlockData(blockHandle, reservation.offset, reservation.size);
 
         reservation.reservedBlock = blockHandle;
         reservation.requestSize = request;
@@ -85,7 +91,11 @@ namespace boitatah::buffer
         if(!mainReservPool->tryGet(reservation, bufferReservation))
             throw std::runtime_error("reservation double release");
         
-        mainAllocator->release(bufferReservation.reservedBlock);
+        if(slabAllocator)
+            slabAllocator->release(bufferReservation.reservedBlock);
+        else
+            mainAllocator->release(bufferReservation.reservedBlock);
+        mainReservPool->clear(reservation);
 
         return true;
     }
@@ -119,12 +129,14 @@ namespace boitatah::buffer
 
     bool Buffer::checkCompatibility(const BufferReservationRequest &compatibility)
     {
-        return usage == compatibility.usage && 
-               sharing == compatibility.sharing &&
-               mainAllocator->getLargestFreeBlockSize() >= compatibility.request;
+        if(usage != compatibility.usage || sharing != compatibility.sharing)
+            return false;
+        if(slabAllocator)
+            return slabAllocator->getLargestFreeBlockSize() >= compatibility.request;
+        return mainAllocator->getLargestFreeBlockSize() >= compatibility.request;
     }
 
-    void Buffer::copyData(const Handle<BufferReservation> handle, const void *data, uint32_t size)
+    void Buffer::copyData(const Handle<BufferReservation> handle, const void *data, VkDeviceSize size)
     {
         BufferReservation reservation;
             if(!mainReservPool->tryGet(handle, reservation)) 
@@ -151,15 +163,53 @@ namespace boitatah::buffer
         return bufferData.memory;
     }
 
-    void Buffer::setupBuffer(uint32_t desiredSize, uint32_t partitions){
+    void *Buffer::getMappedMemory() const
+    {
+        return sharing == SHARING_MODE::CONCURRENT ? mappedMemory : nullptr;
+    }
+
+    VkDeviceSize Buffer::getSize() const
+    {
+        return slabAllocator ? slabAllocator->getSize() : mainAllocator->getSize();
+    }
+
+    VkDeviceSize Buffer::getLargestFreeBlockSize() const
+    {
+        return slabAllocator ? slabAllocator->getLargestFreeBlockSize() :
+                               mainAllocator->getLargestFreeBlockSize();
+    }
+
+    VkDeviceSize Buffer::getOccupiedSpace() const
+    {
+        return slabAllocator ? slabAllocator->getOccupiedSpace() :
+                               mainAllocator->getOccupiedSpace();
+    }
 
-        mainAllocator.reset(new BufferAllocator({.alignment = alignment,
-                                        .partitionSize = desiredSize,
-                                        .height = static_cast<uint32_t>(std::bit_width(partitions)) - 1u,
-                                        }));
+    VkDeviceSize Buffer::getSlabSlotSize() const
+    {
+        return slabAllocator ? slabAllocator->getSlotSize() : 0;
+    }
+
+    void Buffer::setupBuffer(VkDeviceSize desiredSize, uint32_t partitions){
+
+        if(description.slabSlotSize != 0){
+            //slot offsets are bound as uniform buffer offsets.
+            uint32_t slotAlignment = static_cast<uint32_t>(std::max(alignment,
+                vulkan->get_device_limits().minUniformBufferOffsetAlignment));
+            slabAllocator.reset(new SlabAllocator({.alignment = slotAlignment,
+                                                   .slotSize = description.slabSlotSize}));
+            partitions = SLAB_SLOTS;
+        }
+        else{
+            mainAllocator.reset(new BufferAllocator({.alignment = alignment,
+                                            .partitionSize = desiredSize,
+                                            .height = static_cast<uint32_t>(std::bit_width(partitions)) - 1u,
+                                            .maxSize = vulkan->get_max_buffer_size(MEMORY_PROPERTY::HOST_VISIBLE_COHERENT),
+                                            }));
+        }
 
         bufferData = this->vulkan->create_buffer({
-            .size = mainAllocator->getSize(),
+            .size = getSize(),
             .usage = usage,
             .sharing = sharing,
         });
@@ -19,17 +19,18 @@ namespace boitatah::buffer
                             ((desc.partitionSize / alignment) + 1u) * alignment;
 
         height = desc.height;
-        size = partitionSize * (1u << height);
+        size = partitionSize << height;
 
-        //while buffer is larger than 134mb
-        // or buffer overflowed (lol)
-        while( height!=1 && ((size > ((1u << 27u))) || size == 0u) ){
+        //fewer partitions while the buffer is larger than its heap allows.
+        while(height != 1 && desc.maxSize != 0 && size > desc.maxSize){
             height--;
-            size = desc.partitionSize * (1u << height);
+            size = partitionSize << height;
         }
+        if(desc.maxSize != 0 && size > desc.maxSize)
+            throw std::runtime_error("buffer allocator partitions are larger than the memory heap allows");
 
 
-        leafQuant = size / partitionSize;
+        leafQuant = static_cast<uint32_t>(size / partitionSize);
         std::cout<< "buffer size = "  << size  << 
                     " @@ partition size = " << partitionSize << 
                     " @@leaf quantity = " << leafQuant << std::endl;
@@ -50,7 +51,8 @@ namespace boitatah::buffer
             Block block{
                 .id = id,
                 .address = (size / pow_depth) * id_depth,
-                .size = partitionSize << (height - depth)};
+                //the last slot is past the leaves.
+                .size = depth <= height ? partitionSize << (height - depth) : 0};
 
             BinaryTreeNode node{
                 .index = i,
@@ -65,7 +67,7 @@ namespace boitatah::buffer
         }
     }
 
-    bool BufferAllocator::getBlockData(Handle<Block> &handle, uint32_t &offset, uint32_t &size)
+    bool BufferAllocator::getBlockData(Handle<Block> &handle, VkDeviceSize &offset, VkDeviceSize &size)
     {
         Block block;
         if (!blockPool->tryGet(handle, block))
@@ -77,8 +79,11 @@ namespace boitatah::buffer
         return true;
     }
 
-    Handle<Block> BufferAllocator::allocate(uint32_t request)
+    Handle<Block> BufferAllocator::allocate(VkDeviceSize request)
     {
+        if (request > nodes[0].largestFreeBlockSize)
+            return Handle<Block>();
+
         // << "allocating in allocator" << std::endl;
         uint32_t available_index = findFreeNode(request);
         // std::cout << "available node " << available_index << std::endl;
@@ -121,7 +126,7 @@ namespace boitatah::buffer
                                 nodes[node.leftChildIndex].largestFreeBlockSize,
                                 nodes[node.rightChildIndex].largestFreeBlockSize);
             } else if(node.occupation == FULL){
-                node.largestFreeBlockSize = static_cast<uint32_t>(0);
+                node.largestFreeBlockSize = 0;
             } else if(node.occupation == FREE){
                 node.largestFreeBlockSize = blocks[node.index].size;
             }
@@ -134,11 +139,11 @@ namespace boitatah::buffer
     }
 
     // Minimun Partition Block that fits this request
-    uint32_t BufferAllocator::getMinimunFitSize(uint32_t request)
+    VkDeviceSize BufferAllocator::getMinimunFitSize(VkDeviceSize request)
     {
         uint32_t depth = height; // start at bottom to figure out correct depth
         // (2^level) * partitionSize  < request 2^(level-1) * partitionSize
-        uint32_t fitSize = partitionSize << (height - depth);
+        VkDeviceSize fitSize = partitionSize << (height - depth);
         while (fitSize < request)
         {
             depth--;
@@ -206,6 +211,7 @@ namespace boitatah::buffer
 
         // Free Node
         nodes[index].occupation = FREE;
+        nodes[index].largestFreeBlockSize = blocks[index].size;
 
         // Correct Upstream <-- buddy system.
         upstreamOccupationCorrect(index);
@@ -213,22 +219,22 @@ namespace boitatah::buffer
         return true;
     }
 
-    uint32_t BufferAllocator::freeSpace()
+    VkDeviceSize BufferAllocator::freeSpace()
     {
         return size - occupiedSpace;
     }
 
-    uint32_t BufferAllocator::getOccupiedSpace()
+    VkDeviceSize BufferAllocator::getOccupiedSpace()
     {
         return occupiedSpace;
     }
 
-    uint32_t BufferAllocator::getLargestFreeBlockSize()
+    VkDeviceSize BufferAllocator::getLargestFreeBlockSize()
     {
         return nodes[0].largestFreeBlockSize;
     }
 
-    uint32_t BufferAllocator::getPartitionSize()
+    VkDeviceSize BufferAllocator::getPartitionSize()
     {
         return partitionSize;
     }
@@ -264,7 +270,7 @@ namespace boitatah::buffer
         return s;
     }
 
-    uint32_t BufferAllocator::getSize()
+    VkDeviceSize BufferAllocator::getSize()
     {
         return size;
     }
@@ -274,10 +280,10 @@ namespace boitatah::buffer
         return std::bit_width(index + 1) - 1;
     }
 
-    uint32_t BufferAllocator::findFreeNode(uint32_t request)
+    uint32_t BufferAllocator::findFreeNode(VkDeviceSize request)
     {
         //std::cout << "requested == "<< request << std::endl;
-        uint32_t fitSize = getMinimunFitSize(request);
+        VkDeviceSize fitSize = getMinimunFitSize(request);
         //std:: cout << "minimum fit size == " << fitSize <<
         //" partition size == " << partitionSize << std::endl;
 
@@ -9,10 +9,21 @@ namespace boitatah::buffer
 {
     using Vulkan = boitatah::vk::VulkanInstance;
     using VkCommandBufferWriter = boitatah::vk::VkCommandBufferWriter;
+
+    uint32_t bufferSizeClass(VkDeviceSize request)
+    {
+        for(uint32_t i = 0; i < BUFFER_SIZE_CLASSES.size(); i++){
+            if(request <= BUFFER_SIZE_CLASSES[i].maxRequest)
+                return i;
+        }
+        return DEDICATED_SIZE_CLASS;
+    }
     
     BufferManager::BufferManager(std::shared_ptr<vk::VulkanInstance> vk_instance)
     {
         m_vk = vk_instance;
+        slabAlignment = std::max<uint32_t>(1, static_cast<uint32_t>(
+                            m_vk->get_device_limits().minUniformBufferOffsetAlignment));
         m_transferFence = m_vk->create_fence(true);
 
 
@@ -52,12 +63,18 @@ namespace boitatah::buffer
     {
         // get buffer
         Buffer* buffer;
-        if(!m_bufferPool.tryGet(handle, buffer)){
-            std::runtime_error("doubly released buffer");
-       }
+        if(!m_bufferPool.tryGet(handle, buffer))
+            throw std::runtime_error("doubly released buffer");
         // delete buffer from pool of buffers
         m_bufferPool.clear(handle, buffer);
         
+        if(handle.i < m_bucketEntries.size()){
+            unlistBucket(handle);
+            m_bucketEntries[handle.i].bucket = nullptr;
+        }
+        if(handle.i < m_bufferAddresses.size())
+            m_bufferAddresses[handle.i].clear();
+
         // delete it from buffer list of active buffers
         auto position = std::find(m_activeBuffers.begin(), m_activeBuffers.end(), handle);
         if(position != m_activeBuffers.end()){
@@ -70,46 +87,131 @@ namespace boitatah::buffer
 
         //delete buffer
         delete buffer;
-        std::cout << "Deleted buffer " << buffer->getID() << std::endl;
     }
 
     Handle<Buffer *> BufferManager::findOrCreateCompatibleBuffer(const BufferReservationRequest &compatibility)
     {
+        //small requests go to fixed size slots instead of buddy blocks.
+        uint32_t slabSlot = slabSlotSize(compatibility.request, slabAlignment);
+        //0 for slabs, buddy classes start at 1.
+        uint32_t sizeClass = slabSlot != 0 ? 0 : bufferSizeClass(compatibility.request) + 1;
+
+        uint64_t key = static_cast<uint64_t>(compatibility.usage) << 48 |
+                       static_cast<uint64_t>(compatibility.sharing) << 40 |
+                       static_cast<uint64_t>(sizeClass) << 32 |
+                       slabSlot;
+        auto& bucket = m_buckets[key];
+
         // Find buffer
-        uint32_t bufferIndex = findCompatibleBuffer(compatibility);
-        if (bufferIndex != UINT32_MAX)
-        {
-            // return handle copy
-            return m_activeBuffers[bufferIndex];
+        auto position = bucket.lower_bound(compatibility.request);
+        if (position != bucket.end())
+            return position->second;
+
+        Handle<Buffer *> handle = createClassBuffer(compatibility, slabSlot, sizeClass);
+
+        Buffer * buffer = m_bufferPool.get(handle);
+        if(m_bucketEntries.size() <= handle.i)
+            m_bucketEntries.resize(handle.i + 1);
+        m_bucketEntries[handle.i] = {
+            .bucket = &bucket,
+            .position = bucket.emplace(buffer->getLargestFreeBlockSize(), handle),
+            .listed = true,
+        };
+        return handle;
+    }
+
+    Handle<Buffer *> BufferManager::createClassBuffer(const BufferReservationRequest &compatibility,
+                                                      uint32_t slabSlotSize,
+                                                      uint32_t sizeClass)
+    {
+        BufferDesc desc{
+            .usage = compatibility.usage,
+            .sharing = compatibility.sharing,
+            .slabSlotSize = slabSlotSize,
+            .bufferManager = shared_from_this(),
+        };
+
+        if(slabSlotSize != 0){
+            desc.estimatedElementSize = slabSlotSize;
+            desc.partitions = SLAB_SLOTS;
         }
-        else
-        {
-            Handle<Buffer *> buffer = createBuffer({
-                
-                .estimatedElementSize = compatibility.request,
-                .partitions = partitionsPerBuffer,
-                .usage = compatibility.usage,
-                .sharing = compatibility.sharing,
-                .bufferManager = shared_from_this(),
-                });
-            
-            // return handle copy
-            return buffer;
+        else if(sizeClass <= BUFFER_SIZE_CLASSES.size()){
+            //sized by the class, not by the first request that lands in it.
+            auto& sizing = BUFFER_SIZE_CLASSES[sizeClass - 1];
+            desc.estimatedElementSize = sizing.partitionSize;
+            desc.partitions = sizing.partitions;
+        }
+        else{
+            //the whole buffer is one block of the request.
+            desc.estimatedElementSize = (compatibility.request + 1) / 2;
+            desc.partitions = 2;
         }
+
+        return createBuffer(std::move(desc));
     }
 
-    uint32_t BufferManager::findCompatibleBuffer(const BufferReservationRequest &compatibility)
+    void BufferManager::updateBucket(Handle<Buffer *> handle)
     {
-        {
-            for (int i = 0; i < m_activeBuffers.size(); i++)
-            {
-                Buffer * buffer;
-                m_bufferPool.tryGet(m_activeBuffers[i], buffer);
-                if (buffer->checkCompatibility(compatibility))
-                    return i;
-            }            
-            return UINT32_MAX;
-        }
+        if(handle.i >= m_bucketEntries.size() || !m_bucketEntries[handle.i].listed)
+            return;
+
+        Buffer * buffer;
+        if(!m_bufferPool.tryGet(handle, buffer))
+            return;
+
+        auto& entry = m_bucketEntries[handle.i];
+        VkDeviceSize largest = buffer->getLargestFreeBlockSize();
+        if(entry.position->first == largest)
+            return;
+
+        entry.bucket->erase(entry.position);
+        entry.position = entry.bucket->emplace(largest, handle);
+    }
+
+    void BufferManager::unlistBucket(Handle<Buffer *> handle)
+    {
+        auto& entry = m_bucketEntries[handle.i];
+        if(!entry.listed)
+            return;
+        entry.bucket->erase(entry.position);
+        entry.listed = false;
+    }
+
+    void BufferManager::relistBucket(Handle<Buffer *> handle)
+    {
+        auto& entry = m_bucketEntries[handle.i];
+        Buffer * buffer;
+        if(entry.listed || !entry.bucket || !m_bufferPool.tryGet(handle, buffer))
+            return;
+        entry.position = entry.bucket->emplace(buffer->getLargestFreeBlockSize(), handle);
+        entry.listed = true;
+    }
+
+    void BufferManager::trackAddress(Handle<Buffer *> buffer, Handle<BufferAddress> address)
+    {
+        if(m_bufferAddresses.size() <= buffer.i)
+            m_bufferAddresses.resize(buffer.i + 1);
+        if(m_addressSlots.size() <= address.i)
+            m_addressSlots.resize(address.i + 1);
+
+        auto& addresses = m_bufferAddresses[buffer.i];
+        m_addressSlots[address.i] = static_cast<uint32_t>(addresses.size());
+        addresses.push_back(address);
+    }
+
+    void BufferManager::untrackAddress(Handle<Buffer *> buffer, Handle<BufferAddress> address)
+    {
+        if(buffer.i >= m_bufferAddresses.size() || address.i >= m_addressSlots.size())
+            return;
+
+        //swaps the last address into the freed slot.
+        auto& addresses = m_bufferAddresses[buffer.i];
+        uint32_t slot = m_addressSlots[address.i];
+        if(slot >= addresses.size() || !(addresses[slot] == address))
+            return;
+        addresses[slot] = addresses.back();
+        m_addressSlots[addresses[slot].i] = slot;
+        addresses.pop_back();
     }
 
 
@@ -131,9 +233,22 @@ namespace boitatah::buffer
         BufferAddress bufferAddress{
             .buffer = bufferHandle,
             .reservation = buffer->reserve(request.request),
-            .size = static_cast<uint32_t>(request.request)
+            .size = request.request
         };
+        updateBucket(bufferHandle);
         auto handle = m_addressPool.set(bufferAddress);
+        trackAddress(bufferHandle, handle);
+        m_stats.reservedBytes[static_cast<uint32_t>(buffer->usage)] += request.request;
+
+        if(m_trace)
+            m_trace->record({
+                .size = request.request,
+                .id = handle.i,
+                .frame = m_traceFrame,
+                .type = ALLOCATION_EVENT::RESERVE,
+                .usage = static_cast<uint8_t>(request.usage),
+                .sharing = static_cast<uint8_t>(request.sharing),
+            });
 
         BufferReservation reserv;
         getAddressReservation(handle, reserv);
@@ -160,11 +275,12 @@ namespace boitatah::buffer
         Buffer*& buffer = m_bufferPool.get(address.buffer);
         
         buffer->copyData(address.reservation, desc.data);
+        m_stats.uploadedBytes += desc.dataSize;
         std::cout << "finished copy to buffer" << std::endl;
         return true;
     }
     
-    void BufferManager::memoryCopy(uint32_t dataSize, const void *data, Handle<BufferAddress> &handle)
+    void BufferManager::memoryCopy(VkDeviceSize dataSize, const void *data, Handle<BufferAddress> &handle)
     {
         //TODO handle except
         auto& bufferAddr = m_addressPool.get(handle);
@@ -177,7 +293,7 @@ namespace boitatah::buffer
             std::runtime_error("Buffer is smaller than required space in buffermanager copy.");
 
         buffer->copyData(bufferAddr.reservation, data, dataSize);
-        
+        m_stats.uploadedBytes += dataSize;
     }
 
 
@@ -220,6 +336,30 @@ namespace boitatah::buffer
 
     void BufferManager::freeBufferReservation(Handle<BufferAddress> handle)
     {
+        BufferAddress address;
+        if(!m_addressPool.tryGet(handle, address))
+            return;
+
+        cancelDefragmentMove(handle);
+        untrackAddress(address.buffer, handle);
+
+        Buffer *buffer;
+        if(m_bufferPool.tryGet(address.buffer, buffer)){
+            if(m_trace)
+                m_trace->record({
+                    .size = address.size,
+                    .id = handle.i,
+                    .frame = m_traceFrame,
+                    .type = ALLOCATION_EVENT::FREE,
+                    .usage = static_cast<uint8_t>(buffer->usage),
+                    .sharing = static_cast<uint8_t>(buffer->sharing),
+                });
+            buffer->unreserve(address.reservation);
+            updateBucket(address.buffer);
+            m_stats.reservedBytes[static_cast<uint32_t>(buffer->usage)] -= address.size;
+        }
+        m_addressPool.clear(handle);
+        finishDefragmentSource();
     }
 
     bool BufferManager::areTransfersFinished() const
@@ -245,6 +385,33 @@ namespace boitatah::buffer
         return buffer->getBuffer();
     }
 
+    const BufferManagerStats &BufferManager::getStats() const
+    {
+        return m_stats;
+    }
+
+    void BufferManager::getBufferStats(std::vector<BufferMemoryStats> &stats)
+    {
+        for(auto handle : m_activeBuffers){
+            auto buffer = m_bufferPool.get(handle);
+            stats.push_back({
+                .id = buffer->getID(),
+                .usage = buffer->usage,
+                .sharing = buffer->sharing,
+                .size = buffer->getSize(),
+                .occupied = buffer->getOccupiedSpace(),
+                .largestFree = buffer->getLargestFreeBlockSize(),
+                .slabSlotSize = buffer->getSlabSlotSize(),
+            });
+        }
+    }
+
+    void BufferManager::getPoolStats(std::vector<PoolStats> &stats) const
+    {
+        stats.push_back(m_bufferPool.getStats());
+        stats.push_back(m_addressPool.getStats());
+    }
+
     template <class T>
     bool BufferManager::queueCopy(CommandBufferWriter<T> &writer, const Handle<BufferAddress> src, const Handle<BufferAddress> dst)
     {
@@ -257,6 +424,8 @@ namespace boitatah::buffer
            getAddressReservation(dst, dstReservation) &&
            getAddressReservation(src, srcReservation)){
 
+            //the copy lands on the old location.
+            cancelDefragmentMove(dst);
             writer.copy_buffer({
                 .srcBuffer = srcBuffer->getBuffer(),
                 .srcOffset = srcReservation.offset,
@@ -270,4 +439,235 @@ namespace boitatah::buffer
     };
     template bool BufferManager::queueCopy(CommandBufferWriter<VkCommandBufferWriter> &writer, const Handle<BufferAddress> src, const Handle<BufferAddress> dst);
 
-};
\ No newline at end of file
+    Handle<Buffer *> BufferManager::findDefragmentSource()
+    {
+        Handle<Buffer *> sparsest{};
+        double sparsestRatio = DEFRAG_SPARSE_RATIO;
+        for(auto handle : m_activeBuffers){
+            if(handle.i >= m_bucketEntries.size())
+                continue;
+            auto& entry = m_bucketEntries[handle.i];
+            if(!entry.listed || entry.bucket->size() < 2)
+                continue;
+
+            Buffer * buffer = m_bufferPool.get(handle);
+            if(buffer->sharing != SHARING_MODE::EXCLUSIVE)
+                continue;
+            //a copy may still be landing in it.
+            if(isDefragmentDestination(handle))
+                continue;
+
+            double ratio = static_cast<double>(buffer->getOccupiedSpace()) /
+                           static_cast<double>(buffer->getSize());
+            if(ratio < sparsestRatio){
+                sparsest = handle;
+                sparsestRatio = ratio;
+            }
+        }
+        return sparsest;
+    }
+
+    bool BufferManager::planDefragmentMoves(VkDeviceSize byteBudget)
+    {
+        if(!m_defragSource){
+            if(m_defragCooldown > 0){
+                m_defragCooldown--;
+                return false;
+            }
+            m_defragSource = findDefragmentSource();
+            if(!m_defragSource)
+                return false;
+            //nothing new lands in it while it drains.
+            unlistBucket(m_defragSource);
+            finishDefragmentSource();
+            if(!m_defragSource)
+                return false;
+        }
+
+        Buffer * source = m_bufferPool.get(m_defragSource);
+        auto& bucket = *m_bucketEntries[m_defragSource.i].bucket;
+        auto& addresses = m_bufferAddresses[m_defragSource.i];
+
+        VkDeviceSize planned = 0;
+        for(auto addressHandle : addresses){
+            if(planned >= byteBudget)
+                break;
+
+            bool moving = std::any_of(m_defragMoves.begin(), m_defragMoves.end(),
+                            [&](const DefragmentMove& move){ return move.address == addressHandle; });
+            if(moving)
+                continue;
+
+            auto& address = m_addressPool.get(addressHandle);
+            BufferReservation reservation;
+            if(!source->getReservationData(address.reservation, reservation))
+                continue;
+
+            //best fit among the other buffers of the bucket.
+            auto position = bucket.lower_bound(reservation.requestSize);
+            if(position == bucket.end()){
+                //the rest of the bucket is too full, try again later.
+                relistBucket(m_defragSource);
+                m_defragSource = Handle<Buffer *>{};
+                m_defragCooldown = DEFRAG_RETRY_CALLS;
+                break;
+            }
+
+            Handle<Buffer *> destination = position->second;
+            auto destinationReservation = m_bufferPool.get(destination)->reserve(reservation.requestSize);
+            updateBucket(destination);
+            if(!destinationReservation)
+                break;
+
+            m_defragMoves.push_back({
+                .address = addressHandle,
+                .buffer = destination,
+                .reservation = destinationReservation,
+            });
+            planned += reservation.requestSize;
+        }
+
+        return std::any_of(m_defragMoves.begin(), m_defragMoves.end(),
+                    [](const DefragmentMove& move){ return !move.recorded; });
+    }
+
+    template <class T>
+    void BufferManager::recordDefragmentMoves(CommandBufferWriter<T> &writer, const TimelineFrontier &frontier)
+    {
+        //the source may still be written by batches queued before.
+        for(uint32_t i = 0; i < MAX_SUBMISSION_QUEUES; i++)
+            writer.self().add_timeline_wait({.queue = i, .value = frontier.values[i]});
+
+        for(auto& move : m_defragMoves){
+            if(move.recorded)
+                continue;
+            move.recorded = true;
+            if(move.cancelled)
+                continue;
+
+            auto& address = m_addressPool.get(move.address);
+            Buffer * source = m_bufferPool.get(address.buffer);
+            Buffer * destination = m_bufferPool.get(move.buffer);
+            BufferReservation sourceReservation;
+            BufferReservation destinationReservation;
+            source->getReservationData(address.reservation, sourceReservation);
+            destination->getReservationData(move.reservation, destinationReservation);
+
+            writer.copy_buffer({
+                .srcBuffer = source->getBuffer(),
+                .srcOffset = sourceReservation.offset,
+                .dstBuffer = destination->getBuffer(),
+                .dstOffset = destinationReservation.offset,
+                .size = sourceReservation.requestSize,
+            });
+        }
+    }
+    template void BufferManager::recordDefragmentMoves(CommandBufferWriter<VkCommandBufferWriter> &writer, const TimelineFrontier &frontier);
+
+    void BufferManager::stampDefragmentMoves(TimelinePoint copies)
+    {
+        for(auto& move : m_defragMoves){
+            if(move.recorded && !move.stamped){
+                move.copied = copies;
+                move.stamped = true;
+            }
+        }
+    }
+
+    void BufferManager::collectDefragmentMoves(VkSubmissionList &submissions)
+    {
+        auto frontier = submissions.frontier();
+
+        for(std::size_t i = 0; i < m_defragMoves.size();){
+            auto& move = m_defragMoves[i];
+            if(!move.stamped || !submissions.is_complete(move.copied)){
+                i++;
+                continue;
+            }
+
+            if(move.cancelled){
+                m_bufferPool.get(move.buffer)->unreserve(move.reservation);
+                updateBucket(move.buffer);
+            }
+            else{
+                //frames queued until now may have bound the old location.
+                auto& address = m_addressPool.get(move.address);
+                m_retiredReservations.push_back({
+                    .buffer = address.buffer,
+                    .reservation = address.reservation,
+                    .frontier = frontier,
+                });
+                untrackAddress(address.buffer, move.address);
+                address.buffer = move.buffer;
+                address.reservation = move.reservation;
+                trackAddress(move.buffer, move.address);
+            }
+
+            m_defragMoves[i] = m_defragMoves.back();
+            m_defragMoves.pop_back();
+        }
+
+        for(std::size_t i = 0; i < m_retiredReservations.size();){
+            auto& retired = m_retiredReservations[i];
+            if(!submissions.is_complete(retired.frontier)){
+                i++;
+                continue;
+            }
+
+            m_bufferPool.get(retired.buffer)->unreserve(retired.reservation);
+            updateBucket(retired.buffer);
+            m_retiredReservations[i] = m_retiredReservations.back();
+            m_retiredReservations.pop_back();
+        }
+
+        finishDefragmentSource();
+    }
+
+    void BufferManager::cancelDefragmentMove(Handle<BufferAddress> address)
+    {
+        for(auto& move : m_defragMoves){
+            if(move.address == address)
+                move.cancelled = true;
+        }
+    }
+
+    bool BufferManager::isDefragmentDestination(Handle<Buffer *> handle) const
+    {
+        //cancelled moves keep their reservation until the copy completes.
+        return std::any_of(m_defragMoves.begin(), m_defragMoves.end(),
+                    [&](const DefragmentMove& move){ return move.buffer == handle; });
+    }
+
+    void BufferManager::finishDefragmentSource()
+    {
+        if(!m_defragSource)
+            return;
+        if(!m_bufferAddresses[m_defragSource.i].empty())
+            return;
+        for(auto& retired : m_retiredReservations){
+            if(retired.buffer == m_defragSource)
+                return;
+        }
+        if(isDefragmentDestination(m_defragSource))
+            return;
+
+        releaseBuffer(m_defragSource);
+        m_defragSource = Handle<Buffer *>{};
+    }
+
+    void BufferManager::startAllocationTrace(const std::string &path)
+    {
+        m_trace = std::make_unique<AllocationTraceRecorder>(path);
+        m_traceFrame = 0;
+    }
+
+    void BufferManager::stopAllocationTrace()
+    {
+        m_trace.reset();
+    }
+
+    void BufferManager::nextAllocationTraceFrame()
+    {
+        m_traceFrame++;
+    }
+};
@@ -0,0 +1,99 @@
+#include <boitatah/buffers/SlabAllocator.hpp>
+#include <bit>
+#include <algorithm>
+#include <stdexcept>
+
+namespace boitatah::buffer
+{
+    uint32_t slabSlotSize(VkDeviceSize request, uint32_t alignment)
+    {
+        for(auto sizeClass : SLAB_SIZE_CLASSES){
+            if(request > sizeClass)
+                continue;
+            //large alignments fold the small classes into one.
+            return std::max(sizeClass, alignment);
+        }
+        return 0;
+    }
+
+    SlabAllocator::SlabAllocator(const SlabAllocatorDesc &desc)
+    {
+        if(desc.slotSize == 0 || !std::has_single_bit(desc.alignment))
+            throw std::runtime_error("slab allocator needs a slot size and a power of 2 alignment");
+
+        slotSize = (desc.slotSize + desc.alignment - 1) / desc.alignment * desc.alignment;
+        size = slotSize * SLAB_SLOTS;
+
+        freeWords.fill(UINT64_MAX);
+        summary = UINT64_MAX;
+        //generation 0 is a null handle.
+        generations.assign(SLAB_SLOTS, 1);
+    }
+
+    bool SlabAllocator::getBlockData(Handle<Block> &handle, VkDeviceSize &offset, VkDeviceSize &size)
+    {
+        if(handle.i >= SLAB_SLOTS || handle.isNull() || generations[handle.i] != handle.gen)
+            return false;
+
+        offset = static_cast<VkDeviceSize>(handle.i) * slotSize;
+        size = slotSize;
+        return true;
+    }
+
+    Handle<Block> SlabAllocator::allocate(VkDeviceSize request)
+    {
+        if(request > slotSize || summary == 0)
+            return Handle<Block>();
+
+        uint32_t word = std::countr_zero(summary);
+        uint32_t bit = std::countr_zero(freeWords[word]);
+
+        freeWords[word] &= freeWords[word] - 1;
+        if(freeWords[word] == 0)
+            summary &= ~(1ull << word);
+        occupiedSlots++;
+
+        uint32_t slot = word * 64 + bit;
+        return Handle<Block>{.i = slot, .gen = generations[slot]};
+    }
+
+    bool SlabAllocator::release(Handle<Block> &handle)
+    {
+        if(handle.i >= SLAB_SLOTS || handle.isNull() || generations[handle.i] != handle.gen)
+            return false;
+
+        uint32_t word = handle.i / 64;
+        freeWords[word] |= 1ull << (handle.i % 64);
+        summary |= 1ull << word;
+        occupiedSlots--;
+
+        //skips 0 when it wraps.
+        generations[handle.i] = std::max(1u, generations[handle.i] + 1);
+        return true;
+    }
+
+    VkDeviceSize SlabAllocator::freeSpace()
+    {
+        return size - getOccupiedSpace();
+    }
+
+    VkDeviceSize SlabAllocator::getOccupiedSpace()
+    {
+        return occupiedSlots * slotSize;
+    }
+
+    VkDeviceSize SlabAllocator::getLargestFreeBlockSize()
+    {
+        return summary == 0 ? 0 : slotSize;
+    }
+
+    VkDeviceSize SlabAllocator::getSlotSize()
+    {
+        return slotSize;
+    }
+
+    VkDeviceSize SlabAllocator::getSize()
+    {
+        return size;
+    }
+}
@@ -0,0 +1,86 @@
+#include <boitatah/buffers/TransientRing.hpp>
+#include <boitatah/buffers/Buffer.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace boitatah::buffer
+{
+    TransientRing::TransientRing(std::shared_ptr<vk::VulkanInstance> vk_instance,
+                                 std::shared_ptr<vk::VkSubmissionList> submissions,
+                                 uint32_t regionSize,
+                                 uint32_t regions)
+        : m_vk(vk_instance), m_submissions(submissions)
+    {
+        if(regions == 0 || regionSize == 0)
+            throw std::runtime_error("transient ring needs at least one non empty region");
+
+        m_minAlignment = std::max<uint32_t>(1,
+            static_cast<uint32_t>(m_vk->get_device_limits().minUniformBufferOffsetAlignment));
+
+        //regions start aligned, so offsets aligned within a region are aligned in the buffer.
+        m_regionSize = (regionSize + m_minAlignment - 1) / m_minAlignment * m_minAlignment;
+        VkDeviceSize total = static_cast<VkDeviceSize>(m_regionSize) * regions;
+
+        //the allocator needs two partitions, the ring only uses the mapping.
+        m_buffer = std::make_unique<Buffer>(BufferDesc{
+            .estimatedElementSize = (total + 1) / 2,
+            .partitions = 2,
+            .usage = BUFFER_USAGE::TRANSIENT,
+            .sharing = SHARING_MODE::CONCURRENT,
+        }, m_vk.get());
+
+        m_mapped = static_cast<std::byte*>(m_buffer->getMappedMemory());
+        if(m_mapped == nullptr)
+            throw std::runtime_error("transient ring buffer is not mapped");
+
+        m_regionFrontiers.resize(regions);
+    }
+
+    TransientRing::~TransientRing()
+    {
+        for(auto& frontier : m_regionFrontiers)
+            m_submissions->wait(frontier);
+    }
+
+    TransientAllocation TransientRing::allocate(uint32_t size, uint32_t alignment)
+    {
+        if(alignment == 0)
+            alignment = m_minAlignment;
+
+        uint32_t offset = (m_offset + alignment - 1) / alignment * alignment;
+        if(offset + size > m_regionSize)
+            throw std::runtime_error("transient ring region is full");
+        m_offset = offset + size;
+
+        uint32_t bufferOffset = m_region * m_regionSize + offset;
+        return {
+            .data = m_mapped + bufferOffset,
+            .access = {.buffer = m_buffer.get(), .offset = bufferOffset, .size = size},
+        };
+    }
+
+    void TransientRing::nextFrame()
+    {
+        m_regionFrontiers[m_region] = m_submissions->frontier();
+
+        m_region = (m_region + 1) % static_cast<uint32_t>(m_regionFrontiers.size());
+        m_offset = 0;
+        m_submissions->wait(m_regionFrontiers[m_region]);
+    }
+
+    uint32_t TransientRing::getRegionSize() const
+    {
+        return m_regionSize;
+    }
+
+    uint32_t TransientRing::getRegionCount() const
+    {
+        return static_cast<uint32_t>(m_regionFrontiers.size());
+    }
+
+    uint32_t TransientRing::getUsed() const
+    {
+        return m_offset;
+    }
+}
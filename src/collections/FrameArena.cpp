@@ -0,0 +1,105 @@
+#include <boitatah/collections/FrameArena.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+namespace boitatah{
+
+    static std::size_t align_up(std::size_t value, std::size_t alignment){
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    FrameArena::FrameArena(std::size_t capacity) : m_capacity(capacity)
+    {
+        if(m_capacity > 0)
+            m_block = static_cast<std::byte*>(::operator new(m_capacity));
+    }
+
+    FrameArena::~FrameArena()
+    {
+        release_overflow();
+        ::operator delete(m_block);
+    }
+
+    void FrameArena::reset()
+    {
+        m_last = m_current;
+        m_current = {};
+
+        //the block is empty now, grow it to hold a frame like the last one.
+        if(m_overflowBytes > 0){
+            std::size_t needed = m_offset + m_overflowBytes;
+            ::operator delete(m_block);
+            m_capacity = std::max(m_capacity * 2, align_up(needed + needed / 2, 4096));
+            m_block = static_cast<std::byte*>(::operator new(m_capacity));
+        }
+
+        release_overflow();
+        m_offset = 0;
+    }
+
+    std::size_t FrameArena::capacity() const
+    {
+        return m_capacity;
+    }
+
+    FrameArenaStats FrameArena::current() const
+    {
+        return m_current;
+    }
+
+    FrameArenaStats FrameArena::last_frame() const
+    {
+        return m_last;
+    }
+
+    void *FrameArena::do_allocate(std::size_t bytes, std::size_t alignment)
+    {
+        m_current.bytes += bytes;
+        m_current.allocations++;
+
+        if(m_block != nullptr){
+            auto base = reinterpret_cast<std::uintptr_t>(m_block);
+            std::size_t offset = align_up(base + m_offset, alignment) - base;
+            if(offset + bytes <= m_capacity){
+                m_offset = offset + bytes;
+                return m_block + offset;
+            }
+        }
+
+        m_current.heapAllocations++;
+        alignment = std::max(alignment, alignof(Overflow));
+        std::size_t header = align_up(sizeof(Overflow), alignment);
+        auto base = static_cast<std::byte*>(::operator new(header + bytes, std::align_val_t(alignment)));
+
+        auto overflow = new (base) Overflow{.next = m_overflow,
+                                            .size = header + bytes,
+                                            .alignment = alignment};
+        m_overflow = overflow;
+        m_overflowBytes += bytes;
+        return base + header;
+    }
+
+    void FrameArena::do_deallocate(void *, std::size_t, std::size_t)
+    {
+        //released all at once by reset.
+    }
+
+    bool FrameArena::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+    {
+        return this == &other;
+    }
+
+    void FrameArena::release_overflow()
+    {
+        while(m_overflow != nullptr){
+            Overflow* next = m_overflow->next;
+            ::operator delete(static_cast<void*>(m_overflow),
+                              m_overflow->size,
+                              std::align_val_t(m_overflow->alignment));
+            m_overflow = next;
+        }
+        m_overflowBytes = 0;
+    }
+}
@@ -1,4 +1,5 @@
 #include "PartitionList.hpp"
+#include <algorithm>
 
 namespace boitatah
 {
@@ -76,6 +77,17 @@ namespace boitatah
     {
         return totalOccupation;
     }
+    uint32_t PartitionList::getLargestFreeSpace()
+    {
+        uint32_t largest = 0;
+        for (PartitionNode *n = root; n != nullptr; n = n->next)
+        {
+            Partition p;
+            if (n->free && partitionPool.tryGet(n->partition, p))
+                largest = std::max(largest, p.size);
+        }
+        return largest;
+    }
     std::string PartitionList::coolPrint()
     {
         int print_chars = 100;
@@ -213,6 +225,8 @@ namespace boitatah
         // if tagetPartition wasnt the last node
         if (newNode->next != nullptr)
             newNode->next->previous = newNode;
+        else
+            last = newNode;
 
         return targetPartition;
     }
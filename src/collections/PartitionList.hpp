@@ -54,6 +54,8 @@ namespace boitatah{
             bool release(Handle<Partition> handle);
 
             uint32_t getOccupiedSpace();
+            //walks the whole list.
+            uint32_t getLargestFreeSpace();
             std::string coolPrint();
 
         private:
@@ -39,9 +39,20 @@ namespace boitatah{
 
     void LightArray::update()
     {
-        m_manager->getResource(m_light_buffer).copyData(light_content.data(),
-                                                        m_active_lights * sizeof(Light));
-        m_manager->getResource(m_lightmetada).copyData(&m_active_lights, sizeof(uint32_t));
+        upload(active_lights());
+    }
+
+    std::span<const Light> LightArray::active_lights() const
+    {
+        return std::span(light_content.data(), m_active_lights);
+    }
+
+    void LightArray::upload(std::span<const Light> lights)
+    {
+        uint32_t count = static_cast<uint32_t>(std::min<std::size_t>(lights.size(), m_light_capacity));
+        m_manager->getResource(m_light_buffer).copyData(lights.data(),
+                                                        count * sizeof(Light));
+        m_manager->getResource(m_lightmetada).copyData(&count, sizeof(uint32_t));
     }
 
     Handle<GPUBuffer> LightArray::metadata()
@@ -1,6 +1,11 @@
 #include <boitatah/Renderer.hpp>
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
 #include <iostream>
+#include <span>
 #include <stdexcept>
 
 #include <GLFW/glfw3.h>
@@ -8,17 +13,44 @@
 
 #include <stdexcept>
 #include <boitatah/utils/utils.hpp>
+#include <boitatah/modules/Profiler.hpp>
 
 
 namespace boitatah
 {
+    //milliseconds since start, which restarts.
+    static double lap_ms(std::chrono::steady_clock::time_point &start)
+    {
+        auto now = std::chrono::steady_clock::now();
+        std::chrono::duration<double, std::milli> elapsed = now - start;
+        start = now;
+        return elapsed.count();
+    }
+
+    //counters gathered between two running_stats, culled is not running.
+    static RenderStats diff_stats(const RenderStats &end, const RenderStats &start)
+    {
+        RenderStats stats = end;
+        stats.commands -= start.commands;
+        stats.descriptorAllocations -= start.descriptorAllocations;
+        stats.descriptorWrites -= start.descriptorWrites;
+        stats.uploadedBytes -= start.uploadedBytes;
+        stats.batches -= start.batches;
+        stats.culled = 0;
+        return stats;
+    }
+
 #pragma region Initialization
 
     Renderer::Renderer(RendererOptions opts)
     {
         m_options = opts;
+        m_jobs = std::make_unique<JobSystem>(m_options.jobThreads);
+        m_frameArena = std::make_unique<FrameArena>(m_options.frameArenaSize);
+
         WindowDesc desc{.dimensions = m_options.windowDimensions,
-                        .windowName = m_options.appName};
+                        .windowName = m_options.appName,
+                        .visible = !m_options.hiddenWindow};
 
         m_window = std::make_shared<WindowManager>(desc);
 
@@ -43,6 +75,8 @@ namespace boitatah
 
         //Initialize the VulkanBuffer manager
         m_bufferManager = std::make_shared<BufferManager>(m_vk);
+        if(m_options.allocationTrace != nullptr)
+            m_bufferManager->startAllocationTrace(m_options.allocationTrace);
 
         //Initializethe command buffer writer
         m_buffer_writer = std::make_shared<VkCommandBufferWriter>(m_vk);
@@ -51,18 +85,42 @@ namespace boitatah
         //                                             .type = COMMAND_BUFFER_TYPE::TRANSFER}).buffer);
         m_buffer_writer->set_fence(m_vk->create_fence(true));
         m_buffer_writer->set_signal(m_vk->create_semaphore());
+
+        //reused every frame, keeps its wait list allocation.
+        m_presentWriter = std::make_unique<VkCommandBufferWriter>(m_vk);
+
+        //frame submissions are batched and flushed at present.
+        m_submissions = std::make_shared<VkSubmissionList>(m_vk);
+
+        //one query slice per backbuffer graph.
+        m_gpuProfiler = std::make_unique<GpuProfiler>(m_vk, 3, m_options.gpuProfiling);
+
+        //one region per backbuffer graph.
+        m_transientRing = std::make_unique<TransientRing>(m_vk, m_submissions,
+                                                          m_options.transientRingSize, 3);
+
+        //draw recording threads, each with its own command pools.
+        uint32_t record_threads = m_options.recordThreads;
+        if(record_threads == 0)
+            record_threads = m_jobs->thread_count();
+        m_recordWorkers.resize(record_threads);
+        for(auto& worker : m_recordWorkers)
+            worker.writer = std::make_unique<VkCommandBufferWriter>(m_vk);
         
 
         //Initialize the renderer Modules
         m_resourceManager = std::make_shared<GPUResourceManager>(   m_vk, m_bufferManager, 
                                                                     m_imageManager,
+                                                                    m_submissions,
                                                                     20);
         
         m_descriptorManager= std::make_shared<DescriptorSetManager>(m_vk, 4096);
+        m_descriptorManager->setFrameResource(m_frameArena.get());
         m_materialMngr = std::make_shared<MaterialManager>(m_vk, 
                                                            m_renderTargetManager, 
                                                            m_descriptorManager,
-                                                           m_resourceManager); 
+                                                           m_resourceManager,
+                                                           m_jobs.get()); 
 
         //Create a backbuffer
         m_backBufferManager = std::make_shared<BackBufferManager>(m_renderTargetManager,
@@ -83,8 +141,11 @@ namespace boitatah
                                                         m_renderTargetManager,
                                                         m_backBufferManager);
 
-
-
+        //started last, it renders with everything above.
+        if(m_options.renderThread){
+            m_snapshots = std::make_unique<Mailbox<FrameSnapshot>>(m_options.snapshotBuffers);
+            m_renderThread = std::thread(&Renderer::render_thread_loop, this);
+        }
 
         std::cout << "Renderer Initialization Complete " << std::endl;
     }
@@ -93,9 +154,12 @@ namespace boitatah
     {
         m_vk->wait_idle();
 
-        m_swapchain->createSwapchain();
+        m_swapchain->createSwapchain({
+            .width = static_cast<uint32_t>(m_framebufferSize.x),
+            .height = static_cast<uint32_t>(m_framebufferSize.y),
+        });
 
-        auto newWindowSize = m_window->getWindowDimensions();
+        auto newWindowSize = m_framebufferSize;
 
         m_options.backBufferDesc.dimensions = {
             static_cast<uint32_t>(newWindowSize.x),
@@ -110,7 +174,11 @@ namespace boitatah
         m_swapchain = std::make_shared<Swapchain>(SwapchainOptions{.format = m_options.swapchainFormat,
                                    .useValidationLayers = m_options.debug});
         m_swapchain->attach(m_vk, m_window);
-        m_swapchain->createSwapchain(); // options.windowDimensions, false, false);
+        m_framebufferSize = m_window->getWindowDimensions();
+        m_swapchain->createSwapchain({
+            .width = static_cast<uint32_t>(m_framebufferSize.x),
+            .height = static_cast<uint32_t>(m_framebufferSize.y),
+        });
     }
 
     std::vector<std::shared_ptr<RenderScene>> 
@@ -156,7 +224,17 @@ namespace boitatah
 #pragma region CleanUp/Destructor
     void Renderer::cleanup()
     {
+        if(m_renderThread.joinable()){
+            m_snapshots->close();
+            m_renderThread.join();
+        }
+
         m_vk->wait_idle();
+
+        for(auto& worker : m_recordWorkers)
+            for(auto& pool : worker.pools)
+                m_vk->destroy_commandpool(pool.pool);
+        m_recordWorkers.clear();
     }
 
     Renderer::~Renderer(void)
@@ -200,6 +278,24 @@ namespace boitatah
         return *m_baseMaterials;
     }
 
+    FrameArena &Renderer::getFrameArena()
+    {
+        return *m_frameArena;
+    }
+
+    TransientRing &Renderer::getTransientRing()
+    {
+        return *m_transientRing;
+    }
+
+    JobSystem &Renderer::getJobSystem()
+    {
+        if(m_jobs == nullptr){
+            throw std::runtime_error("null job system");
+        }
+        return *m_jobs;
+    }
+
     BufferedCamera Renderer::create_camera(const CameraDesc &desc)
     {
         return BufferedCamera(desc, m_resourceManager);
@@ -271,12 +367,23 @@ namespace boitatah
         });
     }
 
+    //the stage loop records resolved draws, keep this one for custom render loops.
+    template void Renderer::write_draw_command(CommandBufferWriter<VkCommandBufferWriter> &writer,
+                                               RenderScene &scene,
+                                               const Handle<RenderTarget> &rendertarget,
+                                               uint32_t frameIndex);
 
     void Renderer::present_rendertarget(Handle<RenderTarget> &rendertarget,
-                                          VkSemaphore stage_wait,
+                                          TimelinePoint stage_wait,
                                           uint32_t attachment_index = 0)
     {
-        m_window->windowEvents();
+        BOITATAH_ZONE("Renderer::present_rendertarget");
+        //glfw polls on the main thread, submit_frame does it for the render thread
+        //and hands the framebuffer size over in the snapshot.
+        if(!m_renderThread.joinable()){
+            m_window->windowEvents();
+            m_framebufferSize = m_window->getWindowDimensions();
+        }
 
         if (!m_renderTargetManager->isActive(rendertarget))
             throw std::runtime_error("Failed to write command buffer \n\tRender Pass");
@@ -299,6 +406,8 @@ namespace boitatah
         // failed to find swapchain image.
         if (swapchainImage.index == UINT32_MAX) // Fail case.
         {
+            m_gpuProfiler->endFrame();
+            m_submissions->flush();
             handleWindowResize();
             return;
         }
@@ -307,26 +416,24 @@ namespace boitatah
         if (swapchainImage.index == UINT32_MAX -1u) // Fail case.
         {
             //handleWindowResize();
+            m_gpuProfiler->endFrame();
+            m_submissions->flush();
             return;
         }
 
-        std::vector<VkSemaphore> waits;
-        waits.push_back(buffers.sc_aquired_semaphore);
-        waits.push_back(stage_wait);
-
-        auto present_writer = VkCommandBufferWriter(m_vk);
+        auto& present_writer = *m_presentWriter;
         present_writer.set_commandbuffer(buffers.present_buffer.buffer);
-        present_writer.set_fence(buffers.in_flight_fence);
-        //TODO fix this garbo
-        m_vk->reset_fence(buffers.in_flight_fence);
+        present_writer.set_submission_list(m_submissions);
 
-        //sets semaphores
-        present_writer.setWait(waits);
+        //sets semaphores, swapchain sync stays binary.
+        present_writer.setWait(std::span(&buffers.sc_aquired_semaphore, 1));
+        present_writer.add_timeline_wait(stage_wait);
         present_writer.set_signal(buffers.transfer_semaphore);
         
         
         present_writer.reset({});
         present_writer.begin({});
+        uint32_t present_scope = m_gpuProfiler->beginScope(present_writer, "present copy");
         present_writer.copy_image({ 
             .srcLayout = castEnum<VkImageLayout>(IMAGE_LAYOUT::COLOR_ATT),
             .dstLayout = castEnum<VkImageLayout>(IMAGE_LAYOUT::PRESENT_SRC),
@@ -334,15 +441,22 @@ namespace boitatah
             .srcImage = image.image,
             .dstImage = swapchainImage.image.image,
         });
+        m_gpuProfiler->endScope(present_writer, present_scope);
         
-        present_writer.submit({.submitType = COMMAND_BUFFER_TYPE::TRANSFER, .signal= true});
+        present_writer.submit({.submitType = COMMAND_BUFFER_TYPE::GRAPHICS, .signal= true});
+        m_writerStats += present_writer.get_stats();
+        present_writer.reset_stats();
+
+        //the whole frame goes to the queues here.
+        m_gpuProfiler->endFrame();
+        m_submissions->flush();
 
         //present image
         bool successfullyPresent = m_vk->present(swapchainImage.image,
                                                       swapchainImage.sc,
                                                       swapchainImage.index,
                                                       {
-                                                          .waitSemaphores = {buffers.transfer_semaphore},
+                                                          .waitSemaphores = std::span(&buffers.transfer_semaphore, 1),
                                                       });
 
         // If present was unsucessful we must remake the swapchain
@@ -355,34 +469,317 @@ namespace boitatah
 
     void Renderer::render_tree(std::shared_ptr<RenderScene> scene, BufferedCamera &camera)
     {
+        BOITATAH_ZONE("Renderer::render_tree");
+        //the render thread owns the command pools, arena and frontiers.
+        if(m_renderThread.joinable())
+            throw std::runtime_error("render_tree can't record while the render thread runs, use submit_frame");
+        auto phase_start = std::chrono::steady_clock::now();
+        update_transforms(*scene);
+        m_frameTimings.transforms = lap_ms(phase_start);
+        extract_draws(*scene, m_immediateDraws);
+        m_frameTimings.extract = lap_ms(phase_start);
+        render_frame(m_immediateDraws, camera.getCameraUniforms());
+    }
+
+    void Renderer::submit_frame(std::shared_ptr<RenderScene> scene, BufferedCamera &camera)
+    {
+        BOITATAH_ZONE("Renderer::submit_frame");
+        if(!m_renderThread.joinable()){
+            extract_snapshot(*scene, camera, m_immediateSnapshot);
+            render_snapshot(m_immediateSnapshot);
+            return;
+        }
+
+        m_window->windowEvents();
+        extract_snapshot(*scene, camera, m_snapshots->write_slot());
+        if(!m_snapshots->publish())
+            rethrow_render_error();
+    }
+
+    void Renderer::wait_render_thread()
+    {
+        if(!m_renderThread.joinable())
+            return;
+        m_snapshots->wait_idle();
+        rethrow_render_error();
+    }
+
+    const FrameTimings &Renderer::getFrameTimings() const
+    {
+        return m_frameTimings;
+    }
+
+    std::span<const GpuTiming> Renderer::getGpuTimings() const
+    {
+        return m_gpuProfiler->getTimings();
+    }
+
+    const FrameStats &Renderer::getFrameStats() const
+    {
+        return m_frameStats;
+    }
+
+    MemoryReport Renderer::getMemoryReport()
+    {
+        MemoryReport report;
+
+        MemoryHeaps heaps;
+        uint32_t heapCount = m_vk->get_memory_heaps(heaps);
+        report.heaps.assign(heaps.begin(), heaps.begin() + heapCount);
+
+        m_bufferManager->getBufferStats(report.buffers);
+        report.staging.reserved = m_bufferManager->getStats().reserved(BUFFER_USAGE::TRANSFER_SRC);
+        for(auto& buffer : report.buffers)
+            if(buffer.usage == BUFFER_USAGE::TRANSFER_SRC)
+                report.staging.capacity += buffer.size;
+        report.staging.transientUsed = m_transientRing->getUsed();
+        report.staging.transientCapacity = static_cast<uint64_t>(m_transientRing->getRegionSize()) *
+                                           m_transientRing->getRegionCount();
+
+        auto images = m_imageManager->getMemoryStats();
+        report.images.assign(images.begin(), images.end());
+        m_descriptorManager->getPoolUsage(report.descriptorPools);
+
+        m_bufferManager->getPoolStats(report.pools);
+        m_imageManager->getPoolStats(report.pools);
+        m_resourceManager->getPoolStats(report.pools);
+        m_materialMngr->getPoolStats(report.pools);
+        report.pools.push_back(m_lightpool->getStats());
+
+        auto heapSpan = std::span<const MemoryHeapUsage>(heaps.data(), heapCount);
+        memory_budget::describe(memory_budget::exceeded(m_options.memoryBudget, heapSpan, report.staging.reserved),
+                                m_options.memoryBudget, heapSpan, report.staging.reserved,
+                                report.warnings);
+        return report;
+    }
+
+    std::span<const alloc_audit::ScopeAllocations> Renderer::getFrameAllocations() const
+    {
+        return alloc_audit::last_frame();
+    }
+
+    void Renderer::check_memory_budget()
+    {
+        MemoryHeaps heaps;
+        uint32_t heapCount = m_vk->get_memory_heaps(heaps);
+        auto heapSpan = std::span<const MemoryHeapUsage>(heaps.data(), heapCount);
+        uint64_t staging = m_bufferManager->getStats().reserved(BUFFER_USAGE::TRANSFER_SRC);
+
+        //warns once when a limit is crossed, again only after it went back under.
+        uint32_t exceeded = memory_budget::exceeded(m_options.memoryBudget, heapSpan, staging);
+        uint32_t crossed = exceeded & ~m_budgetExceeded;
+        m_budgetExceeded = exceeded;
+        if(crossed == 0)
+            return;
+
+        std::vector<std::string> lines;
+        memory_budget::describe(crossed, m_options.memoryBudget, heapSpan, staging, lines);
+        for(auto& line : lines)
+            std::cout << "memory budget exceeded: " << line << std::endl;
+    }
+
+    RenderStats Renderer::running_stats() const
+    {
+        auto& descriptors = m_descriptorManager->getStats();
+        RenderStats stats{
+            .commands = m_resourceManager->getCommandStats(),
+            .descriptorAllocations = descriptors.allocations,
+            .descriptorWrites = descriptors.writes,
+            .uploadedBytes = m_bufferManager->getStats().uploadedBytes,
+            .batches = m_submissions->get_batch_count(),
+        };
+        stats.commands += m_writerStats;
+        return stats;
+    }
+
+    void Renderer::extract_draws(RenderScene &scene, std::vector<SnapshotDraw> &draws)
+    {
+        BOITATAH_ZONE("Renderer::extract_draws");
+        m_sceneNodes.clear();
+        scene.sceneAsList(m_sceneNodes);
+
+        draws.clear();
+        for(const auto& node_weak : m_sceneNodes){
+            auto node = std::shared_ptr<RenderScene>(node_weak);
+            //skip empty node
+            if(!node->content.material)
+                continue;
+            draws.push_back({
+                .geometry = node->content.geometry,
+                .material = node->content.material,
+                .model = node->getGlobalMatrix(),
+            });
+        }
+    }
+
+    void Renderer::extract_snapshot(RenderScene &scene, BufferedCamera &camera, FrameSnapshot &snapshot)
+    {
+        auto phase_start = std::chrono::steady_clock::now();
+        update_transforms(scene);
+        m_frameTimings.transforms = lap_ms(phase_start);
+        extract_draws(scene, snapshot.draws);
+        m_frameTimings.extract = lap_ms(phase_start);
+
+        snapshot.camera = camera.getCameraUniforms();
+        snapshot.framebufferSize = m_window->getWindowDimensions();
+
+        snapshot.lightArray = lights;
+        snapshot.lights.clear();
+        if(!lights.isNull() && m_lightpool->contains(lights)){
+            auto active = m_lightpool->get(lights).active_lights();
+            snapshot.lights.assign(active.begin(), active.end());
+        }
+    }
+
+    void Renderer::render_snapshot(const FrameSnapshot &snapshot)
+    {
+        if(!snapshot.lightArray.isNull() && m_lightpool->contains(snapshot.lightArray))
+            m_lightpool->get(snapshot.lightArray).upload(snapshot.lights);
+
+        m_framebufferSize = snapshot.framebufferSize;
+        render_frame(snapshot.draws, snapshot.camera);
+    }
+
+    void Renderer::render_thread_loop()
+    {
+        BOITATAH_PROFILER_THREAD("render thread");
+        while(auto snapshot = m_snapshots->acquire()){
+            try{
+                render_snapshot(*snapshot);
+            }catch(...){
+                {
+                    std::lock_guard lock(m_renderErrorMutex);
+                    m_renderError = std::current_exception();
+                }
+                //fails the next submit_frame with the error.
+                m_snapshots->close();
+                return;
+            }
+        }
+    }
+
+    void Renderer::rethrow_render_error()
+    {
+        std::lock_guard lock(m_renderErrorMutex);
+        if(m_renderError)
+            std::rethrow_exception(m_renderError);
+    }
+
+    void Renderer::render_frame(std::span<const SnapshotDraw> draws, const CameraUniforms &camera)
+    {
+        BOITATAH_ZONE("Renderer::render_frame");
+        auto phase_start = std::chrono::steady_clock::now();
+        m_frameArena->reset();
+        m_bufferManager->nextAllocationTraceFrame();
+        RenderStats frame_start = running_stats();
+        uint64_t submits_start = m_submissions->get_submit_count();
+        m_frameStats.stages.clear();
+
         auto& backbuffer = m_backBufferManager->getNext_Graph();
-        m_descriptorManager->resetPools(m_backBufferManager->getCurrentIndex());
+        uint32_t graph_index = m_backBufferManager->getCurrentIndex();
+
+        //waits for the last frame that used this graph.
+        if(graph_index >= m_frameFrontiers.size())
+            m_frameFrontiers.resize(graph_index + 1);
+        m_submissions->wait(m_frameFrontiers[graph_index]);
+        m_frameTimings.wait = lap_ms(phase_start);
+        //the graph's last frame is complete, its timestamps are read back.
+        m_gpuProfiler->beginFrame(graph_index);
+        m_resourceManager->collectReleases();
+
+        //background uploads recorded since the last frame go out with this one.
+        m_resourceManager->submitUploads();
+
+        //moves a few reservations out of a sparse buffer.
+        m_bufferManager->collectDefragmentMoves(*m_submissions);
+        if(m_options.defragmentBudget != 0 &&
+           m_bufferManager->planDefragmentMoves(m_options.defragmentBudget)){
+            m_resourceManager->beginCommitCommands();
+            auto& defrag_writer = m_resourceManager->getCurrentBufferWriter();
+            uint32_t defrag_scope = m_gpuProfiler->beginScope(defrag_writer, "defragment");
+            m_bufferManager->recordDefragmentMoves(defrag_writer, m_submissions->frontier());
+            m_gpuProfiler->endScope(defrag_writer, defrag_scope);
+            m_resourceManager->submitCommitCommands();
+            m_bufferManager->stampDefragmentMoves(defrag_writer.get_timeline_point());
+        }
 
-        VkSemaphore last_stage_wait = VK_NULL_HANDLE;
+        //the secondaries of this graph's last frame are done.
+        reset_record_pools(graph_index);
 
+        m_descriptorManager->resetPools(graph_index);
+
+        //the camera is written once per frame, no copy through a GPUBuffer.
+        auto camera_alloc = m_transientRing->allocate(sizeof(CameraUniforms));
+        std::memcpy(camera_alloc.data, &camera, sizeof(CameraUniforms));
+        StageCamera stage_camera{.transient = camera_alloc.access};
+
+        TimelinePoint last_stage_wait{};
+        m_frameTimings.prepare = lap_ms(phase_start);
+
+        uint32_t culled = 0;
         for(const auto& stage : backbuffer){
-            last_stage_wait = render_graph_stage(scene, camera, stage, last_stage_wait);
+            last_stage_wait = render_stage(draws, stage_camera, stage, last_stage_wait);
+            m_frameStats.stages.push_back({
+                .name = stage_scope_names(m_backBufferManager->getStage(stage)).stage,
+                .stats = m_lastStageStats,
+            });
+            culled += m_lastStageStats.culled;
         }
+        m_frameTimings.record = lap_ms(phase_start);
 
         auto present_target = m_backBufferManager->getPresentTarget();
         auto present_target_index = m_backBufferManager->getPresentTargetIndex();
         present_rendertarget(present_target, last_stage_wait, present_target_index);
+        m_frameFrontiers[graph_index] = m_submissions->frontier();
+        m_transientRing->nextFrame();
+        m_frameTimings.present = lap_ms(phase_start);
+
+        m_frameStats.total = diff_stats(running_stats(), frame_start);
+        m_frameStats.total.culled = culled;
+        m_frameStats.queueSubmits = m_submissions->get_submit_count() - submits_start;
+        m_frameStats.stagingBytes = m_bufferManager->getStats().reserved(BUFFER_USAGE::TRANSFER_SRC);
+        check_memory_budget();
+        alloc_audit::end_frame();
     }
 
-    VkSemaphore Renderer::render_graph_stage(std::shared_ptr<RenderScene> scene, 
+    TimelinePoint Renderer::render_graph_stage(std::shared_ptr<RenderScene> scene, 
                                             BufferedCamera &camera, 
                                             Handle<RenderStage> stage_handle,
-                                            VkSemaphore wait_for_last_stage)
+                                            TimelinePoint wait_for_last_stage)
     {
+        BOITATAH_ZONE("Renderer::render_graph_stage");
+        if(m_renderThread.joinable())
+            throw std::runtime_error("render_graph_stage can't record while the render thread runs");
+        //custom loops render stage by stage, nothing transient outlives one.
+        m_frameArena->reset();
+        uint32_t graph_index = m_backBufferManager->getCurrentIndex();
+
+        //like render_frame, the secondaries and descriptor sets of the graph's
+        // last submission are recycled once it is done.
+        if(graph_index >= m_frameFrontiers.size())
+            m_frameFrontiers.resize(graph_index + 1);
+        m_submissions->wait(m_frameFrontiers[graph_index]);
+        reset_record_pools(graph_index);
+        m_descriptorManager->resetPools(graph_index);
+
+        extract_draws(*scene, m_immediateDraws);
+        auto stage_point = render_stage(m_immediateDraws,
+                                        {.buffer = camera.getCameraBuffer()},
+                                        stage_handle,
+                                        wait_for_last_stage);
+        m_frameFrontiers[graph_index] = m_submissions->frontier();
+        return stage_point;
+    }
 
-        std::vector<std::weak_ptr<RenderScene>> nodes;
-        scene->sceneAsList(nodes);
-
+    TimelinePoint Renderer::render_stage(std::span<const SnapshotDraw> draws,
+                                         const StageCamera &camera,
+                                         Handle<RenderStage> stage_handle,
+                                         TimelinePoint wait_for_last_stage)
+    {
+        BOITATAH_ZONE("Renderer::render_stage");
         // TODO cullings and whatever
         // ETC
-        
-        auto ordered_nodes = nodes;//orderSceneNodes(nodes);
-        
+
         // Unpack data structures.
         auto& stage = m_backBufferManager->getStage(stage_handle);
         //std::cout << "drawing stage " << stage.stage_index <<std::endl;
@@ -394,25 +791,50 @@ namespace boitatah
         Image& image = m_imageManager->getImage(target.attachments[0]);
         
         uint32_t frame_index = m_backBufferManager->getCurrentIndex();
-        
-        
-        auto& shader_mngr = m_materialMngr->getShaderManager();
+        auto& scope_names = stage_scope_names(stage);
+        RenderStats stage_start = running_stats();
         
         //m_vk->waitForFence(buffers.in_flight_fence);
         m_resourceManager->beginCommitCommands();
         auto& resource_writer = m_resourceManager->getCurrentBufferWriter();
+        uint32_t commit_scope = m_gpuProfiler->beginScope(resource_writer, scope_names.commit);
 
-        if(wait_for_last_stage != VK_NULL_HANDLE)
-            resource_writer.setWait({wait_for_last_stage});
-        
+        resource_writer.add_timeline_wait(wait_for_last_stage);
+        m_resourceManager->acquireUploads(resource_writer);
+
+        auto base_mat_handle = m_baseMaterials->getStageBaseMaterial(stage.stage_index);
+        //Bind base data to material
+        switch(stage.type){
+            //bind camera info to set 0 binding 0 of base material bindings
+            case StageType::CAMERA:{
+                if(camera.buffer)
+                    m_materialMngr->setBufferBindingAttribute(base_mat_handle,
+                                                              camera.buffer,
+                                                              0, 0);
+                else
+                    m_materialMngr->setTransientBindingAttribute(base_mat_handle,
+                                                                 camera.transient,
+                                                                 0, 0);
+                break;
+            }
+        }
+
+        //descriptor writes and uploads happen here, on this thread.
+        uint32_t culled;
+        {
+            //stage filtering, where culling would go.
+            BOITATAH_ZONE("Renderer::gather_stage_draws");
+            culled = gather_stage_draws(draws, stage.stage_index, frame_index);
+        }
+        uint32_t chunks = record_chunk_count(m_stageDraws.size());
 
         auto writer = VkCommandBufferWriter(m_vk);
         writer.set_commandbuffer(buffers.draw_buffer.buffer);
-        writer.set_signal(buffers.draw_semaphore);
-        writer.setWait({*resource_writer.get_signal()});
+        writer.set_submission_list(m_submissions);
         writer.reset({});
         writer.begin({});
 
+        uint32_t pass_scope = m_gpuProfiler->beginScope(writer, scope_names.pass);
         writer.begin_renderpass({
             .pass = pass.renderPass,
             .frame_buffer = target.buffer,
@@ -421,75 +843,36 @@ namespace boitatah
             .scissorOffset = glm::vec2(0, 0),
             .depth = pass.description.use_depthStencil,
             .attachment_count = static_cast<uint32_t>(target.attachments.size()),
+            .secondary = chunks > 1,
         });
 
-
-        auto base_mat_handle = m_baseMaterials->getStageBaseMaterial(stage.stage_index);
-        //Bind base data to material
-        switch(stage.type){
-            //bind camera info to set 0 binding 0 of base material bindings
-            case StageType::CAMERA:{
-                m_materialMngr->setBufferBindingAttribute(base_mat_handle,
-                                                          camera.getCameraBuffer(),
-                                                          0, 0);
-                break;
-            }
-        }
-        //Bind Pipeline <-- relevant when shader is reused.
-        Handle<Shader> boundPipeline;
-        Handle<Geometry> boundVertices;
-        std::vector<VERTEX_BUFFER_TYPE> boundVertexTypes;
-        for (const auto &node_weak : ordered_nodes)
-        {
-            auto node = std::shared_ptr<RenderScene>(node_weak);
-            //skip empty node
-            if (!node->content.material)
-            {
-                continue;
-            }
-            auto& material = m_materialMngr->getMaterialContent(node->content.material);
-
-            //skip wrong stage node
-            if( !((1u << stage.stage_index) &  material.stage_mask)){
-                continue;
-            }
-            m_materialMngr->BindMaterial(writer, node->content.material, frame_index);
-            
-            Handle<Shader>& shader = material.shader;
-            // TODO separate to avoid rebinding when drawing a lot of the same object
-            bind_vertexbuffers(
-                m_backBufferManager->getCurrentIndex(),
-                node->content.geometry,
-                true,
-                material.vertexBufferBindings,
-                writer);
-
-            glm::mat4 model_mat = node->getGlobalMatrix();
-
-            writer.push_constants({
-                .layout = shader_mngr.get(shader).layout.pipeline,
-                .push_constants = {
-                    { //camera constant
-                        .ptr = &model_mat,
-                        .offset = 0,
-                        .size = sizeof(glm::mat4),
-                        .stages = castEnum<VkShaderStageFlags>(SHADER_STAGE::ALL_GRAPHICS)
-                    }
-            }});
-            // //draw one node to target.
-            write_draw_command(writer,
-                               *node, 
-                               stage.target, 
-                               m_backBufferManager->getCurrentIndex());
+        //the writers drop pipeline, set and buffer binds that are already bound.
+        if(chunks > 1){
+            record_draws_parallel(writer,
+                                  {
+                                    .pass = pass.renderPass,
+                                    .frame_buffer = target.buffer,
+                                    .scissorDims = image.dimensions,
+                                  },
+                                  frame_index,
+                                  chunks);
+        }else{
+            record_draws(writer, m_stageDraws);
         }
 
         writer.end_renderpass({});
+        m_gpuProfiler->endScope(writer, pass_scope);
 
+        m_writerStats += writer.get_stats();
+        for(uint32_t c = 0; chunks > 1 && c < chunks; c++)
+            m_writerStats += m_recordWorkers[c].writer->get_stats();
+
+        m_gpuProfiler->endScope(resource_writer, commit_scope);
         m_resourceManager->submitCommitCommands();
 
-        //writer.set_fence(buffers.in_flight_fence);
+        writer.add_timeline_wait(resource_writer.get_timeline_point());
         writer.submit({ .submitType = COMMAND_BUFFER_TYPE::GRAPHICS,
-                        .signal = true});
+                        .signal = false});
         
         m_materialMngr->resetBindings();
         
@@ -497,17 +880,41 @@ namespace boitatah
         m_resourceManager->beginCommitCommands();
 
         auto& buffer_writer = m_resourceManager->getCurrentBufferWriter();
+        uint32_t copy_scope = m_gpuProfiler->beginScope(buffer_writer, scope_names.copy);
         auto& stage_textures =  m_backBufferManager->getStageTextures(stage_handle);
         for(int i = 0; i < stage_textures.size(); i++){  
             m_resourceManager->getResource(stage_textures[i])
                               .CmdCopyImageFromImage(target.attachments[i],
                                                      IMAGE_LAYOUT::COLOR_ATT);
         }
-        buffer_writer.setWait({buffers.draw_semaphore});
-        //buffer_writer.set_fence(buffers.in_flight_fence);
+        m_gpuProfiler->endScope(buffer_writer, copy_scope);
+        buffer_writer.add_timeline_wait(writer.get_timeline_point());
         m_resourceManager->submitCommitCommands();
 
-        return *buffer_writer.get_signal();
+        m_lastStageStats = diff_stats(running_stats(), stage_start);
+        m_lastStageStats.culled = culled;
+
+        return buffer_writer.get_timeline_point();
+    }
+
+    const Renderer::StageScopeNames &Renderer::stage_scope_names(const RenderStage &stage)
+    {
+        if(stage.stage_index >= m_stageScopeNames.size())
+            m_stageScopeNames.resize(stage.stage_index + 1, {nullptr, nullptr, nullptr, nullptr});
+
+        auto& names = m_stageScopeNames[stage.stage_index];
+        if(names.pass == nullptr){
+            std::string name = stage.description.name.empty()
+                                ? "stage " + std::to_string(stage.stage_index)
+                                : stage.description.name;
+            names = {
+                .stage = profiler::intern(name),
+                .commit = profiler::intern(name + " commit"),
+                .pass = profiler::intern(name + " pass"),
+                .copy = profiler::intern(name + " texture copy"),
+            };
+        }
+        return names;
     }
 
 #pragma endregion Rendering
@@ -519,46 +926,224 @@ namespace boitatah
     void Renderer::bind_vertexbuffers(uint32_t           frame_index, 
                                     Handle<Geometry>    geometry, 
                                     bool                indexed, 
-                                    std::vector<VERTEX_BUFFER_TYPE> vertex_buffers, 
+                                    const std::vector<VERTEX_BUFFER_TYPE>& vertex_buffers, 
                                     VkCommandBufferWriter           &writer) {
-        auto geom = m_resourceManager->getResource(geometry);
-        std::vector<BufferAccessData> bufferData;
+        GeometryDrawData data;
+        resolve_vertexbuffers(frame_index, geometry, indexed, vertex_buffers, data);
 
-        for(uint32_t i = 0; i < vertex_buffers.size(); ++i){
-            auto buffer_handle = geom.getBuffer(vertex_buffers[i]);
-            bufferData.push_back(
-                m_resourceManager->getCommitResourceAccessData(buffer_handle, frame_index)
-            );
-        }
+        writer.bind_vertexbuffers({
+            .buffers = std::span(data.buffers.data(), data.bufferCount),
+            .offsets = std::span(data.offsets.data(), data.bufferCount)
+        });
+
+        if(data.indexed)
+            writer.bind_indexbuffer({
+                                    .buffers = data.indexBuffer,
+                                    .offsets = data.indexOffset});
+    };
 
-        std::vector<VkDeviceSize> offsets; 
-        std::vector<VkBuffer> buffers;
+    void Renderer::resolve_vertexbuffers(uint32_t           frame_index, 
+                                        Handle<Geometry>    geometry, 
+                                        bool                indexed, 
+                                        const std::vector<VERTEX_BUFFER_TYPE>& vertex_buffers, 
+                                        GeometryDrawData    &data) {
+        auto& geom = m_resourceManager->getResource(geometry);
 
+        if(vertex_buffers.size() > VERTEX_BUFFER_TYPE_COUNT)
+            throw std::runtime_error("too many vertex buffer bindings");
+
+        data.bufferCount = static_cast<uint32_t>(vertex_buffers.size());
         for (std::size_t i = 0; i < vertex_buffers.size(); i++)
         {
-            offsets.push_back(static_cast<VkDeviceSize>(bufferData[i].offset));
-            buffers.push_back(bufferData[i].buffer->getBuffer());
+            auto buffer_handle = geom.getBuffer(vertex_buffers[i]);
+            auto bufferData = m_resourceManager->getCommitResourceAccessData(buffer_handle, frame_index);
+            data.offsets[i] = static_cast<VkDeviceSize>(bufferData.offset);
+            data.buffers[i] = bufferData.buffer->getBuffer();
         }
-        
-        writer.bind_vertexbuffers({
-            .buffers = buffers,
-            .offsets = offsets
-        });
 
-         if(indexed)  
+        data.indexed = indexed;
+        if(indexed)  
         {
             auto indexHandle = geom.IndexBuffer();
             auto indexData = m_resourceManager->getCommitResourceAccessData(indexHandle, frame_index);
-            // m_vk->CmdBindIndexBuffer({.drawBuffer = command.commandBuffer.buffer,
-            //                         .buffers = {indexData.buffer->getBuffer()},
-            //                         .offsets = {indexData.offset}});
-            writer.bind_indexbuffer({
-                                    .buffers = {indexData.buffer->getBuffer()},
-                                    .offsets = {indexData.offset}});
+            data.indexBuffer = indexData.buffer->getBuffer();
+            data.indexOffset = indexData.offset;
         }
-    
     };
 
+    uint32_t Renderer::gather_stage_draws(std::span<const SnapshotDraw> nodes,
+                                          uint32_t stage_index,
+                                          uint32_t frame_index)
+    {
+        m_stageDraws.clear();
+        uint32_t culled = 0;
+        for (const auto &node : nodes)
+        {
+            auto& material = m_materialMngr->getMaterialContent(node.material);
+
+            //skip wrong stage node
+            if( !((1u << stage_index) &  material.stage_mask)){
+                continue;
+            }
+            //skip geometry still uploading on the transfer queue
+            if(!m_resourceManager->isVisible(node.geometry)){
+                culled++;
+                continue;
+            }
+
+            StageDrawItem item;
+            m_materialMngr->ResolveMaterial(node.material, frame_index, item.material);
+            //nothing to draw with
+            if(item.material.pipeline == VK_NULL_HANDLE){
+                culled++;
+                continue;
+            }
+
+            resolve_vertexbuffers(frame_index,
+                                  node.geometry,
+                                  true,
+                                  material.vertexBufferBindings,
+                                  item.geometry);
+
+            item.model = node.model;
+
+            auto& geom = m_resourceManager->getResource(node.geometry);
+            item.draw = {
+                .vertexCount = static_cast<uint32_t>(geom.VertexInfo().x),
+                .instaceCount = 1,
+                .firstVertex = static_cast<uint32_t>(geom.VertexInfo().y),
+                .firstInstance = 0,
+                .indexed = true,
+                .indexCount = geom.IndexCount(),
+            };
+            m_stageDraws.push_back(item);
+        }
+        return culled;
+    }
+
+    void Renderer::record_draws(VkCommandBufferWriter &writer,
+                                std::span<StageDrawItem> draws)
+    {
+        BOITATAH_ZONE("Renderer::record_draws");
+        for(auto& draw : draws){
+            MaterialManager::BindMaterialData(writer, draw.material);
+
+            auto& geometry = draw.geometry;
+            writer.bind_vertexbuffers({
+                .buffers = std::span(geometry.buffers.data(), geometry.bufferCount),
+                .offsets = std::span(geometry.offsets.data(), geometry.bufferCount)
+            });
+            if(geometry.indexed)
+                writer.bind_indexbuffer({
+                                        .buffers = geometry.indexBuffer,
+                                        .offsets = geometry.indexOffset});
+
+            std::array<VulkanPushConstant, 1> constants{{
+                { //model constant
+                    .ptr = &draw.model,
+                    .offset = 0,
+                    .size = sizeof(glm::mat4),
+                    .stages = castEnum<VkShaderStageFlags>(SHADER_STAGE::ALL_GRAPHICS)
+                }
+            }};
+            writer.push_constants({
+                .layout = draw.material.layout,
+                .push_constants = constants,
+            });
+            writer.draw(draw.draw);
+        }
+    }
+
+    uint32_t Renderer::record_chunk_count(std::size_t draws) const
+    {
+        std::size_t chunks = (draws + DRAWS_PER_RECORD_CHUNK - 1) / DRAWS_PER_RECORD_CHUNK;
+        return static_cast<uint32_t>(std::clamp<std::size_t>(chunks, 1, m_recordWorkers.size()));
+    }
+
+    void Renderer::record_draws_parallel(VkCommandBufferWriter &writer,
+                                         const VulkanWriterBegin &inheritance,
+                                         uint32_t graph_index,
+                                         uint32_t chunks)
+    {
+        BOITATAH_ZONE("Renderer::record_draws_parallel");
+        //buffers come from the workers' pools before any thread touches them.
+        m_secondaryBuffers.resize(chunks);
+        for(uint32_t c = 0; c < chunks; c++)
+            m_secondaryBuffers[c] = acquire_secondary(m_recordWorkers[c], graph_index);
+
+        //any thread may run chunk c, but only chunk c uses worker c.
+        //a small capture keeps the jobs off the heap.
+        m_jobs->parallel_for(chunks, 1, [this, &inheritance](uint32_t first, uint32_t last){
+            uint32_t chunks = static_cast<uint32_t>(m_secondaryBuffers.size());
+            std::size_t per_chunk = (m_stageDraws.size() + chunks - 1) / chunks;
+            for(uint32_t c = first; c < last; c++){
+                std::size_t begin = std::min(c * per_chunk, m_stageDraws.size());
+                std::size_t count = std::min(per_chunk, m_stageDraws.size() - begin);
+
+                auto& chunk_writer = *m_recordWorkers[c].writer;
+                chunk_writer.set_commandbuffer(m_secondaryBuffers[c]);
+                chunk_writer.reset_stats();
+                chunk_writer.begin(inheritance);
+                record_draws(chunk_writer, std::span(m_stageDraws).subspan(begin, count));
+                chunk_writer.end({});
+            }
+        });
+
+        writer.execute_commands({.buffers = m_secondaryBuffers});
+    }
+
+    void Renderer::update_transforms(RenderScene &scene)
+    {
+        BOITATAH_ZONE("Renderer::update_transforms");
+        m_transformLevel.clear();
+        m_transformLevel.push_back(&scene);
+
+        while(!m_transformLevel.empty()){
+            m_jobs->parallel_for(static_cast<uint32_t>(m_transformLevel.size()),
+                                 TRANSFORMS_PER_JOB,
+                                 [this](uint32_t begin, uint32_t end){
+                                    for(uint32_t i = begin; i < end; i++)
+                                        m_transformLevel[i]->getGlobalMatrix();
+                                 });
+
+            m_transformNext.clear();
+            for(auto node : m_transformLevel)
+                for(auto& child : node->children)
+                    m_transformNext.push_back(child.get());
+            std::swap(m_transformLevel, m_transformNext);
+        }
+    }
+
+    VkCommandBuffer Renderer::acquire_secondary(RecordWorker &worker, uint32_t graph_index)
+    {
+        if(worker.pools.size() <= graph_index)
+            worker.pools.resize(graph_index + 1);
+
+        auto& pool = worker.pools[graph_index];
+        if(pool.pool == VK_NULL_HANDLE)
+            pool.pool = m_vk->create_commandpool(COMMAND_BUFFER_TYPE::GRAPHICS);
+
+        if(pool.used == pool.buffers.size())
+            pool.buffers.push_back(m_vk->allocate_commandbuffer({
+                                        .count = 1,
+                                        .level = COMMAND_BUFFER_LEVEL::SECONDARY,
+                                        .type = COMMAND_BUFFER_TYPE::GRAPHICS}, pool.pool).buffer);
+        return pool.buffers[pool.used++];
+    }
+
+    void Renderer::reset_record_pools(uint32_t graph_index)
+    {
+        for(auto& worker : m_recordWorkers){
+            if(worker.pools.size() <= graph_index)
+                continue;
+            auto& pool = worker.pools[graph_index];
+            if(pool.pool == VK_NULL_HANDLE)
+                continue;
+            m_vk->reset_commandpool(pool.pool);
+            pool.used = 0;
+        }
+    }
+
 #pragma endregion Command Buffers
 
 
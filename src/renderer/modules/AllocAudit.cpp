@@ -0,0 +1,277 @@
+#include <boitatah/modules/AllocAudit.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+//malloc and friends are replaced through glibc's own entry points,
+//elsewhere only operator new and delete are counted.
+#if defined(__GLIBC__)
+    #define BOITATAH_AUDIT_MALLOC
+    extern "C" {
+        void* __libc_malloc(std::size_t size);
+        void* __libc_calloc(std::size_t count, std::size_t size);
+        void* __libc_realloc(void* ptr, std::size_t size);
+        void* __libc_memalign(std::size_t alignment, std::size_t size);
+        void  __libc_free(void* ptr);
+    }
+#endif
+
+//the hooks run before dynamic tls is set up and must not allocate through it.
+#if defined(__GNUC__)
+    #define AUDIT_TLS __attribute__((tls_model("initial-exec")))
+#else
+    #define AUDIT_TLS
+#endif
+
+namespace boitatah::alloc_audit{
+
+    struct Counter{
+        std::atomic<const char*>    scope{nullptr};
+        std::atomic<uint64_t>       allocations{0};
+        std::atomic<uint64_t>       bytes{0};
+        std::atomic<uint64_t>       frees{0};
+    };
+
+    static const char NO_ZONE[] = "(no zone)";
+    static const char TABLE_FULL[] = "(table full)";
+
+    //open addressing on the name pointer, slots are claimed once and never freed.
+    //constant initialized, allocations made before main are counted too.
+    static std::array<Counter, AUDIT_SCOPES> s_counters;
+    static Counter s_overflow;
+
+    static std::array<ScopeAllocations, AUDIT_SCOPES + 1> s_frame;
+    static uint32_t s_frameCount = 0;
+
+    static thread_local const char* t_scopes[AUDIT_DEPTH] AUDIT_TLS;
+    static thread_local uint32_t t_depth AUDIT_TLS = 0;
+
+    static const char* current_scope()
+    {
+        if(t_depth == 0)
+            return NO_ZONE;
+        return t_scopes[std::min(t_depth, AUDIT_DEPTH) - 1];
+    }
+
+    static Counter& counter(const char* scope)
+    {
+        auto key = reinterpret_cast<std::uintptr_t>(scope);
+        uint32_t start = static_cast<uint32_t>((key >> 3) * 0x9E3779B97F4A7C15ull >> 32) % AUDIT_SCOPES;
+        for(uint32_t i = 0; i < AUDIT_SCOPES; i++){
+            auto& slot = s_counters[(start + i) % AUDIT_SCOPES];
+            const char* owner = slot.scope.load(std::memory_order_acquire);
+            if(owner == scope)
+                return slot;
+            if(owner == nullptr){
+                if(slot.scope.compare_exchange_strong(owner, scope, std::memory_order_acq_rel) ||
+                   owner == scope)
+                    return slot;
+            }
+        }
+        s_overflow.scope.store(TABLE_FULL, std::memory_order_relaxed);
+        return s_overflow;
+    }
+
+    static void record_allocation(std::size_t size)
+    {
+        auto& slot = counter(current_scope());
+        slot.allocations.fetch_add(1, std::memory_order_relaxed);
+        slot.bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    static void record_free(void* ptr)
+    {
+        if(ptr == nullptr)
+            return;
+        counter(current_scope()).frees.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void push_scope(const char *name)
+    {
+        if(t_depth < AUDIT_DEPTH)
+            t_scopes[t_depth] = name;
+        t_depth++;
+    }
+
+    void pop_scope()
+    {
+        if(t_depth > 0)
+            t_depth--;
+    }
+
+    static void take(Counter& slot)
+    {
+        const char* scope = slot.scope.load(std::memory_order_acquire);
+        if(scope == nullptr)
+            return;
+        ScopeAllocations counts{
+            .scope = scope,
+            .allocations = slot.allocations.exchange(0, std::memory_order_relaxed),
+            .bytes = slot.bytes.exchange(0, std::memory_order_relaxed),
+            .frees = slot.frees.exchange(0, std::memory_order_relaxed),
+        };
+        if(counts.allocations != 0 || counts.frees != 0)
+            s_frame[s_frameCount++] = counts;
+    }
+
+    void end_frame()
+    {
+        s_frameCount = 0;
+        for(auto& slot : s_counters)
+            take(slot);
+        take(s_overflow);
+
+        std::sort(s_frame.begin(), s_frame.begin() + s_frameCount,
+                  [](const ScopeAllocations& a, const ScopeAllocations& b){
+                      return a.bytes != b.bytes ? a.bytes > b.bytes : a.allocations > b.allocations;
+                  });
+    }
+
+    std::span<const ScopeAllocations> last_frame()
+    {
+        return {s_frame.data(), s_frameCount};
+    }
+
+    static void* allocate(std::size_t size)
+    {
+#ifdef BOITATAH_AUDIT_MALLOC
+        //counted by the malloc below.
+        return std::malloc(size);
+#else
+        record_allocation(size);
+        return std::malloc(size);
+#endif
+    }
+
+    static void* allocate_aligned(std::size_t size, std::size_t alignment)
+    {
+        //aligned_alloc wants a multiple of the alignment.
+        size = (size + alignment - 1) & ~(alignment - 1);
+#ifdef BOITATAH_AUDIT_MALLOC
+        return std::aligned_alloc(alignment, size);
+#else
+        record_allocation(size);
+        return std::aligned_alloc(alignment, size);
+#endif
+    }
+
+    static void deallocate(void* ptr)
+    {
+#ifndef BOITATAH_AUDIT_MALLOC
+        record_free(ptr);
+#endif
+        std::free(ptr);
+    }
+
+    template<typename Allocate>
+    static void* new_or_throw(Allocate allocate)
+    {
+        while(true){
+            if(void* ptr = allocate())
+                return ptr;
+            auto handler = std::get_new_handler();
+            if(handler == nullptr)
+                throw std::bad_alloc();
+            handler();
+        }
+    }
+}
+
+//the array and nothrow forms forward to these.
+void* operator new(std::size_t size)
+{
+    using namespace boitatah::alloc_audit;
+    if(size == 0)
+        size = 1;
+    return new_or_throw([size]{ return allocate(size); });
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    using namespace boitatah::alloc_audit;
+    if(size == 0)
+        size = 1;
+    auto align = static_cast<std::size_t>(alignment);
+    return new_or_throw([size, align]{ return allocate_aligned(size, align); });
+}
+
+void operator delete(void* ptr) noexcept
+{
+    boitatah::alloc_audit::deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+    boitatah::alloc_audit::deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    boitatah::alloc_audit::deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+    boitatah::alloc_audit::deallocate(ptr);
+}
+
+#ifdef BOITATAH_AUDIT_MALLOC
+extern "C" {
+
+    void* malloc(std::size_t size) noexcept
+    {
+        boitatah::alloc_audit::record_allocation(size);
+        return __libc_malloc(size);
+    }
+
+    void* calloc(std::size_t count, std::size_t size) noexcept
+    {
+        boitatah::alloc_audit::record_allocation(count * size);
+        return __libc_calloc(count, size);
+    }
+
+    //a resize is counted as an allocation, a realloc to 0 as a free.
+    void* realloc(void* ptr, std::size_t size) noexcept
+    {
+        if(size == 0 && ptr != nullptr)
+            boitatah::alloc_audit::record_free(ptr);
+        else
+            boitatah::alloc_audit::record_allocation(size);
+        return __libc_realloc(ptr, size);
+    }
+
+    void* memalign(std::size_t alignment, std::size_t size) noexcept
+    {
+        boitatah::alloc_audit::record_allocation(size);
+        return __libc_memalign(alignment, size);
+    }
+
+    void* aligned_alloc(std::size_t alignment, std::size_t size) noexcept
+    {
+        boitatah::alloc_audit::record_allocation(size);
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** out, std::size_t alignment, std::size_t size) noexcept
+    {
+        if(alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0)
+            return EINVAL;
+        boitatah::alloc_audit::record_allocation(size);
+        void* ptr = __libc_memalign(alignment, size);
+        if(ptr == nullptr)
+            return ENOMEM;
+        *out = ptr;
+        return 0;
+    }
+
+    void free(void* ptr) noexcept
+    {
+        boitatah::alloc_audit::record_free(ptr);
+        __libc_free(ptr);
+    }
+}
+#endif
@@ -177,14 +177,8 @@ namespace boitatah
     }
 
     std::vector<Handle<RenderStage>>& BackBufferManager::getNext_Graph(){
+        //the renderer waits for the graph's last frame on the queue timelines.
         current = (current + 1) % m_graphs.size();
-
-        auto present_handle = getPresentTarget();
-        auto& present_fence = m_renderTargetManager
-                                    ->get_sync_data(present_handle)
-                                    .in_flight_fence;
-        m_vulkan->wait_for_fence(present_fence);
-        m_vulkan->reset_fence(present_fence);
         return m_graphs[current];
     }
 
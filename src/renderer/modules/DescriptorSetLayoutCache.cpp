@@ -0,0 +1,61 @@
+#include "DescriptorSetLayoutCache.hpp"
+
+#include <algorithm>
+namespace boitatah::vk::descriptor_sets{
+    DescriptorSetLayoutCache::DescriptorSetLayoutCache(std::shared_ptr<VulkanInstance> vulkan)
+    {
+        m_vk =  vulkan;
+        m_layoutPool = std::unique_ptr<Pool<DescriptorSetLayout>>(
+            new Pool<DescriptorSetLayout>(PoolOptions{
+                .size = 100,
+                .dynamic = true,
+                .name = "descriptor layout pool"
+            })
+        );
+    }
+
+    Handle<DescriptorSetLayout> DescriptorSetLayoutCache::createSetLayout(const DescriptorSetLayoutDesc &description)
+    {
+        DescriptorSetLayout layout;
+        //std::vector<DescriptorSetRatio> ratios;
+        std::vector<BindingDesc> bindingDesc;
+        layout.layout = m_vk->create_descriptorlayout(description);
+
+        for(auto& bindDesc : description.bindingDescriptors){
+            for (std::size_t i = 0; i <= layout.ratios.size(); i++)
+            {
+                if(i == layout.ratios.size()){
+                    DescriptorSetRatio ratio;
+                    ratio.type = bindDesc.type;
+                    ratio.quantity = bindDesc.descriptorCount;
+                    layout.ratios.push_back(ratio);
+                    break;
+                }
+                if(layout.ratios[i].type == bindDesc.type)
+                {
+                    layout.ratios[i].quantity += bindDesc.descriptorCount;
+                    break;
+                }
+            }            
+        }
+        layout.description = description;
+        auto layout_handle = m_layoutPool->set(layout);
+        return layout_handle;
+    }
+
+    Handle<DescriptorSetLayout> DescriptorSetLayoutCache::getSetLayout(const DescriptorSetLayoutDesc &description)
+    {
+        auto it = m_layouts.find(description);
+        if(it != m_layouts.end())
+            return it->second;
+
+        auto handle = createSetLayout(description);
+        m_layouts[description] = handle;
+        return handle;
+    }
+
+    DescriptorSetLayout &DescriptorSetLayoutCache::getSetLayoutData(const Handle<DescriptorSetLayout> &handle)
+    {
+        return m_layoutPool->get(handle);
+    }
+}
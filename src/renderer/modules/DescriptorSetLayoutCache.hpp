@@ -0,0 +1,44 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <unordered_map>
+
+#include <boitatah/backend/vulkan/Vulkan.hpp>
+#include <boitatah/BoitatahEnums.hpp>
+
+#include <boitatah/types/Descriptors.hpp>
+#include <boitatah/collections/Pool.hpp>
+
+namespace boitatah::vk::descriptor_sets{
+
+    /// @brief hashes the full layout content, type, stages and count of every binding.
+    struct DescriptorSetLayoutDescHasher{
+        std::size_t operator()(const DescriptorSetLayoutDesc& description) const{
+            std::size_t res = 17;
+            for(auto& binding : description.bindingDescriptors){
+                res = res * 31 + std::hash<uint32_t>()(static_cast<uint32_t>(binding.type));
+                res = res * 31 + std::hash<uint32_t>()(static_cast<uint32_t>(binding.stages));
+                res = res * 31 + std::hash<uint32_t>()(binding.descriptorCount);
+            }
+            return res;
+        }
+    };
+
+    /// @brief Dedupes VkDescriptorSetLayouts by their create info content.
+    class DescriptorSetLayoutCache{
+        private:
+            std::shared_ptr<VulkanInstance> m_vk;
+            std::unique_ptr<Pool<DescriptorSetLayout>> m_layoutPool;
+            std::unordered_map<DescriptorSetLayoutDesc, 
+                               Handle<DescriptorSetLayout>,
+                               DescriptorSetLayoutDescHasher> m_layouts;
+
+            Handle<DescriptorSetLayout> createSetLayout(const DescriptorSetLayoutDesc& description);
+        public:
+            DescriptorSetLayoutCache(std::shared_ptr<VulkanInstance> vulkan);
+            Handle<DescriptorSetLayout> getSetLayout(const DescriptorSetLayoutDesc& description);
+            DescriptorSetLayout& getSetLayoutData(const Handle<DescriptorSetLayout>& handle);
+
+    };
+}
@@ -1,10 +1,12 @@
 #include <boitatah/modules/DescriptorSetManager.hpp>
-#include "DescriptorSetTree.hpp"
+#include "DescriptorSetLayoutCache.hpp"
 #include <boitatah/buffers/Buffer.hpp>
+#include <boitatah/modules/Profiler.hpp>
 namespace boitatah::vk {
 
-    DescriptorSetManager::DescriptorSetManager(std::shared_ptr<VulkanInstance> vulkan, uint32_t maximumSets)
-    : m_vk(vulkan), maxSets(maximumSets), m_descriptorTree(std::make_unique<descriptor_sets::DescriptorSetTree>(vulkan)){};
+    DescriptorSetManager::DescriptorSetManager(std::shared_ptr<VulkanInstance> vulkan, uint32_t maximumSets,
+                                               uint32_t initialSets)
+    : m_vk(vulkan), maxSets(maximumSets), m_initialSets(std::min(initialSets, maximumSets)), m_layoutCache(std::make_unique<descriptor_sets::DescriptorSetLayoutCache>(vulkan)){};
 
     DescriptorSetManager::~DescriptorSetManager(){
         //release all pools
@@ -16,19 +18,20 @@ namespace boitatah::vk {
 
     Handle<DescriptorSetLayout> DescriptorSetManager::getLayout(const DescriptorSetLayoutDesc &description)
     {
-        return m_descriptorTree->getSetLayout(description);
+        return m_layoutCache->getSetLayout(description);
     }
 
     DescriptorSetLayout& DescriptorSetManager::getLayoutContent(const Handle<DescriptorSetLayout> &handle)
     {
-        return m_descriptorTree->getSetLayoutData(handle);
+        return m_layoutCache->getSetLayoutData(handle);
     }
 
     DescriptorSet DescriptorSetManager::getSet(const DescriptorSetLayout &request, uint32_t frame_index)
     {
-        DescriptorSetPool pool = findCreatePool(request, frame_index);
+        auto& pool = findCreatePool(request, frame_index);
         DescriptorSet set;
         set.descriptorSet =  pool.allocate(request, frame_index, m_vk);
+        m_stats.allocations++;
 
         return set;
     }
@@ -37,13 +40,14 @@ namespace boitatah::vk {
                                         const DescriptorSet &set,
                                         uint32_t frame_index)
     {   
-        //TODO adjust with std::any or something.
-        // this will waste memory but preserve the pointers up to 10
-        std::vector<VkWriteDescriptorSet> writes{};
-        std::vector<VkDescriptorImageInfo> images(10);
-        std::vector<VkDescriptorBufferInfo> buffers(10);
-        std::vector<VkBufferView> views(10);
-        uint32_t count = 0;
+        BOITATAH_ZONE("DescriptorSetManager::writeSet");
+        // reserved up front so the writes can point into them.
+        std::pmr::vector<VkWriteDescriptorSet> writes(m_frameResource);
+        std::pmr::vector<VkDescriptorImageInfo> images(m_frameResource);
+        std::pmr::vector<VkDescriptorBufferInfo> buffers(m_frameResource);
+        writes.reserve(bindings.size());
+        images.reserve(bindings.size());
+        buffers.reserve(bindings.size());
         for(auto& binding : bindings){
             VkWriteDescriptorSet write{};
             write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
@@ -100,6 +104,32 @@ namespace boitatah::vk {
 
 
         vkUpdateDescriptorSets(m_vk->get_device(), writes.size(), writes.data(), 0, nullptr);
+        m_stats.writes += writes.size();
+    }
+
+    void DescriptorSetManager::setFrameResource(std::pmr::memory_resource *resource)
+    {
+        m_frameResource = resource;
+    }
+
+    std::pmr::memory_resource *DescriptorSetManager::getFrameResource() const
+    {
+        return m_frameResource;
+    }
+
+    const DescriptorStats &DescriptorSetManager::getStats() const
+    {
+        return m_stats;
+    }
+
+    void DescriptorSetManager::getPoolUsage(std::vector<DescriptorPoolUsage> &usage) const
+    {
+        for(auto& pool : m_pools){
+            uint32_t used = 0;
+            for(uint32_t frame = 0; frame < 3; frame++)
+                used = std::max(used, pool.getUsedSets(frame));
+            usage.push_back({.maxSets = pool.getMaxSets(), .usedSets = used, .peakSets = pool.getPeakSets()});
+        }
     }
 
     void DescriptorSetManager::bindSet(const CommandBuffer drawBuffer,
@@ -120,7 +150,14 @@ namespace boitatah::vk {
 
     size_t DescriptorSetManager::createPool(const DescriptorSetLayout &request)
     {
-        DescriptorSetPool<3> pool(maxSets, request.ratios, m_vk);
+        //size from the layout's own descriptor counts,
+        // growing geometrically when the same layout keeps running out.
+        uint32_t sets = m_initialSets;
+        for(auto& pool : m_pools)
+            if(pool.matches(request))
+                sets = std::max(sets, std::min(pool.getMaxSets() * 2, maxSets));
+
+        DescriptorSetPool<3> pool(sets, request.ratios, m_vk);
         m_pools.push_back(pool);
         return m_pools.size()-1;
     }
@@ -3,63 +3,359 @@
 #include <boitatah/resources/GPUResource.hpp>
 #include <boitatah/resources/GPUBuffer.hpp>
 #include <boitatah/modules/GPUResourcePool.hpp>
+#include <boitatah/modules/Profiler.hpp>
+
+#include <algorithm>
+#include <stdexcept>
 
 
 namespace boitatah{
     GPUResourceManager::GPUResourceManager( std::shared_ptr<vk::VulkanInstance>  vk_instance,
                                             std::shared_ptr<buffer::BufferManager> bufferManager,
                                             std::shared_ptr<ImageManager> imageManager,
+                                            std::shared_ptr<vk::VkSubmissionList> submissions,
                                             uint32_t buffer_writer_count = 10)
                                             : 
                                               m_vulkan(vk_instance),
                                               m_bufferManager(bufferManager),
                                               m_imageManager(imageManager),
+                                              m_submissions(submissions),
                                               m_resourcePool(std::make_unique<GPUResourcePool>())
     { 
+        //frame writers copy between graphics owned resources, so they run on the graphics queue.
+        //writers track completion on their queue's timeline, no fences or semaphores.
         for(int i = 0; i < buffer_writer_count; i++)
         {
             auto buffer_writer = std::make_shared<VkCommandBufferWriter>(m_vulkan);
             buffer_writer->set_commandbuffer(m_vulkan->allocate_commandbuffer({.count = 1,
                                                         .level = COMMAND_BUFFER_LEVEL::PRIMARY,
-                                                        .type = COMMAND_BUFFER_TYPE::TRANSFER}).buffer);
-            buffer_writer->set_fence(m_vulkan->create_fence(true));
-            buffer_writer->set_signal(m_vulkan->create_semaphore());
+                                                        .type = COMMAND_BUFFER_TYPE::GRAPHICS}).buffer);
+            buffer_writer->set_submission_list(m_submissions);
             m_buffer_writers.push_back(buffer_writer);
         }
+
+        //background uploads go to the transfer queue.
+        for(int i = 0; i < 3; i++)
+        {
+            auto upload_writer = std::make_shared<VkCommandBufferWriter>(m_vulkan);
+            upload_writer->set_commandbuffer(m_vulkan->allocate_commandbuffer({.count = 1,
+                                                        .level = COMMAND_BUFFER_LEVEL::PRIMARY,
+                                                        .type = COMMAND_BUFFER_TYPE::TRANSFER}).buffer);
+            upload_writer->set_submission_list(m_submissions);
+            m_upload_writers.push_back(upload_writer);
+        }
     }
 
     GPUResourceManager::~GPUResourceManager()
     {
-        for(int i = 0; i < m_buffer_writers.size(); i++){
-            auto& buffer_writer = m_buffer_writers[i];
-            m_vulkan->destroy_fence(*buffer_writer->get_fence());
-            m_vulkan->destroy_semaphore(*buffer_writer->get_signal());
-        }
+        m_submissions->wait(m_submissions->frontier());
+        for(auto& deferred : m_deferredReleases)
+            deferred.release();
     }
 
     void GPUResourceManager::beginCommitCommands()
     {
-        
+        BOITATAH_ZONE("GPUResourceManager::beginCommitCommands");
+
         recording = true;
         m_current_writer = (m_current_writer+1u) % m_buffer_writers.size();
+        m_commitBatch++;
 
         auto& buffer_writer = m_buffer_writers[m_current_writer];
         
         buffer_writer->waitForTransfers();
         buffer_writer->reset({});
         buffer_writer->begin({});
+        buffer_writer->set_batch_id(m_commitBatch);
         
     }
     
     void GPUResourceManager::submitCommitCommands()
     {
+        BOITATAH_ZONE("GPUResourceManager::submitCommitCommands");
         auto& buffer_writer = m_buffer_writers[m_current_writer];
         
         buffer_writer->submit({
-            .submitType = COMMAND_BUFFER_TYPE::TRANSFER,
-            .signal = true
+            .submitType = COMMAND_BUFFER_TYPE::GRAPHICS,
+            .signal = false
         });
         recording = false;
+        m_commandStats += buffer_writer->get_stats();
+        buffer_writer->reset_stats();
+    }
+
+    const vk::VulkanWriterStats &GPUResourceManager::getCommandStats() const
+    {
+        return m_commandStats;
+    }
+
+    uint64_t GPUResourceManager::getCommitBatch() const
+    {
+        return m_commitBatch;
+    }
+
+    bool GPUResourceManager::isBatchComplete(uint64_t batch)
+    {
+        if(batch == 0)
+            return true;
+
+        if(batch & UPLOAD_BATCH_BIT){
+            uint64_t upload = batch & ~UPLOAD_BATCH_BIT;
+            if(upload == m_uploadBatch && uploadRecording)
+                return false;
+            auto& upload_writer = m_upload_writers[upload % m_upload_writers.size()];
+            if(upload_writer->get_batch_id() != batch)
+                return true;
+            return upload_writer->checkTransfers();
+        }
+
+        if(batch == m_commitBatch && recording)
+            return false;
+
+        //the writer was reused since, which waited on the batch.
+        auto& buffer_writer = m_buffer_writers[batch % m_buffer_writers.size()];
+        if(buffer_writer->get_batch_id() != batch)
+            return true;
+        return buffer_writer->checkTransfers();
+    }
+
+    void GPUResourceManager::waitForBatch(uint64_t batch)
+    {
+        if(batch & UPLOAD_BATCH_BIT){
+            uint64_t upload = batch & ~UPLOAD_BATCH_BIT;
+            if(upload == m_uploadBatch && uploadRecording)
+                submitUploads();
+            auto& upload_writer = m_upload_writers[upload % m_upload_writers.size()];
+            if(upload_writer->get_batch_id() == batch)
+                upload_writer->waitForTransfers();
+            return;
+        }
+
+        if(batch == 0 || (batch == m_commitBatch && recording))
+            return;
+
+        auto& buffer_writer = m_buffer_writers[batch % m_buffer_writers.size()];
+        if(buffer_writer->get_batch_id() == batch)
+            buffer_writer->waitForTransfers();
+    }
+
+    void GPUResourceManager::beginUploadCommands()
+    {
+        if(uploadRecording)
+            return;
+        uploadRecording = true;
+        m_uploadBatch++;
+
+        auto& upload_writer = m_upload_writers[m_uploadBatch % m_upload_writers.size()];
+        upload_writer->waitForTransfers();
+        upload_writer->reset({});
+        upload_writer->begin({});
+        upload_writer->set_batch_id(m_uploadBatch | UPLOAD_BATCH_BIT);
+    }
+
+    void GPUResourceManager::uploadAsync(Handle<GPUBuffer> handle)
+    {
+        beginUploadCommands();
+        auto& upload_writer = *m_upload_writers[m_uploadBatch % m_upload_writers.size()];
+        auto& resource = getResource(handle);
+
+        //uploaded before, queued frames may still read it.
+        for(uint32_t i = 0; i < GPUBuffer::COPIES; i++)
+            if(resource.get_upload_batch(i) != 0)
+                m_recordingUpload.waitFrontier = true;
+
+        resource.commit_all(upload_writer);
+        resource.visible = false;
+        m_recordingUpload.buffers.push_back(handle);
+
+        //one family, the timeline wait alone makes the copy visible.
+        if(!m_vulkan->has_dedicated_transfer())
+            return;
+
+        //releases each copy's range to the graphics family.
+        auto families = m_vulkan->get_queuefamily_indices();
+        for(uint32_t i = 0; i < GPUBuffer::COPIES; i++){
+            auto access = resource.get_render_data(i);
+            vk::VulkanWriterBufferBarrier barrier{
+                .buffer = access.buffer->getBuffer(),
+                .offset = access.offset,
+                .size = access.size,
+                .srcQueueFamily = families.transferFamily.value(),
+                .dstQueueFamily = families.graphicsFamily.value(),
+                .srcStage = VK_PIPELINE_STAGE_TRANSFER_BIT,
+                .dstStage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                .srcAccess = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .dstAccess = 0,
+            };
+            upload_writer.buffer_barrier(barrier);
+
+            //the matching acquire, recorded on the graphics queue.
+            barrier.srcStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+            barrier.dstStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+            barrier.srcAccess = 0;
+            barrier.dstAccess = VK_ACCESS_MEMORY_READ_BIT;
+            m_recordingUpload.barriers.push_back(barrier);
+        }
+    }
+
+    void GPUResourceManager::uploadAsync(Handle<RenderTexture> handle)
+    {
+        auto& texture = getResource(handle);
+        //image to image copies transition on graphics stages.
+        if(!texture.uploadsFromBuffer())
+            throw std::runtime_error("async texture upload without copyImageFromBuffer data");
+
+        beginUploadCommands();
+        auto& upload_writer = *m_upload_writers[m_uploadBatch % m_upload_writers.size()];
+
+        //uploaded before, queued frames may still sample it.
+        for(uint32_t i = 0; i < RenderTexture::COPIES; i++)
+            if(texture.get_upload_batch(i) != 0)
+                m_recordingUpload.waitFrontier = true;
+
+        //with a dedicated family the copy's final transition is the release.
+        bool dedicated = m_vulkan->has_dedicated_transfer();
+        auto families = m_vulkan->get_queuefamily_indices();
+        if(dedicated)
+            texture.setQueueTransfer(families.transferFamily.value(), families.graphicsFamily.value());
+        texture.commit_all(upload_writer);
+        texture.setQueueTransfer(VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED);
+
+        texture.visible = false;
+        m_recordingUpload.textures.push_back(handle);
+        m_hiddenTextures++;
+
+        if(!dedicated)
+            return;
+
+        //the matching acquires, same layouts, recorded on the graphics queue.
+        for(uint32_t i = 0; i < RenderTexture::COPIES; i++){
+            auto access = texture.get_render_data(i);
+            m_recordingUpload.imageBarriers.push_back({
+                .src = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                .dst = access.layout,
+                .image = access.image,
+                .srcStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                .dstStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                .srcQueueFamily = families.transferFamily.value(),
+                .dstQueueFamily = families.graphicsFamily.value(),
+            });
+        }
+    }
+
+    void GPUResourceManager::uploadTexture(Handle<RenderTexture> handle, void *data)
+    {
+        auto& texture = getResource(handle);
+        texture.copyImageFromBuffer(data);
+        if(texture.byteSize() >= ASYNC_UPLOAD_THRESHOLD)
+            uploadAsync(handle);
+    }
+
+    bool GPUResourceManager::hasHiddenTextures() const
+    {
+        return m_hiddenTextures != 0;
+    }
+
+    void GPUResourceManager::submitUploads()
+    {
+        BOITATAH_ZONE("GPUResourceManager::submitUploads");
+        if(!uploadRecording)
+            return;
+
+        auto& upload_writer = *m_upload_writers[m_uploadBatch % m_upload_writers.size()];
+        if(m_recordingUpload.waitFrontier){
+            auto frontier = m_submissions->frontier();
+            for(uint32_t i = 0; i < vk::MAX_SUBMISSION_QUEUES; i++)
+                upload_writer.add_timeline_wait({.queue = i, .value = frontier.values[i]});
+        }
+
+        upload_writer.submit({
+            .submitType = COMMAND_BUFFER_TYPE::TRANSFER,
+            .signal = false
+        });
+        uploadRecording = false;
+        m_commandStats += upload_writer.get_stats();
+        upload_writer.reset_stats();
+
+        m_recordingUpload.point = upload_writer.get_timeline_point();
+        m_pendingAcquires.push_back(std::move(m_recordingUpload));
+        m_recordingUpload = {};
+    }
+
+    void GPUResourceManager::acquireUploads(vk::VkCommandBufferWriter &writer)
+    {
+        BOITATAH_ZONE("GPUResourceManager::acquireUploads");
+        //only finished uploads, so graphics never stalls on the transfer queue.
+        vk::TimelinePoint last{};
+        for(auto it = m_pendingAcquires.begin(); it != m_pendingAcquires.end();){
+            if(!m_submissions->is_complete(it->point)){
+                ++it;
+                continue;
+            }
+
+            for(uint32_t i = 0; i < it->buffers.size(); i++){
+                if(!m_resourcePool->contains(it->buffers[i]))
+                    continue;
+                if(!it->barriers.empty()){
+                    writer.buffer_barrier(it->barriers[2 * i]);
+                    writer.buffer_barrier(it->barriers[2 * i + 1]);
+                }
+                getResource(it->buffers[i]).visible = true;
+            }
+
+            for(uint32_t i = 0; i < it->textures.size(); i++){
+                m_hiddenTextures--;
+                if(!m_resourcePool->contains(it->textures[i]))
+                    continue;
+                if(!it->imageBarriers.empty())
+                    for(uint32_t c = 0; c < RenderTexture::COPIES; c++)
+                        writer.transition_image(it->imageBarriers[RenderTexture::COPIES * i + c]);
+                getResource(it->textures[i]).visible = true;
+            }
+
+            last.queue = it->point.queue;
+            last.value = std::max(last.value, it->point.value);
+            it = m_pendingAcquires.erase(it);
+        }
+
+        //the acquire must wait on the release.
+        if(last.value != 0)
+            writer.add_timeline_wait(last);
+    }
+
+    bool GPUResourceManager::isVisible(Handle<Geometry> handle)
+    {
+        auto& geo = getResource(handle);
+        for(auto& buffer : geo.m_buffers){
+            if(!isVisible(buffer))
+                return false;
+        }
+        return geo.indexBuffer.isNull() || isVisible(geo.indexBuffer);
+    }
+
+    void GPUResourceManager::collectReleases()
+    {
+        auto frontier = m_submissions->frontier();
+
+        //releases may destroy more resources, run them after the sweep.
+        std::vector<std::function<void()>> ready;
+        for(auto it = m_deferredReleases.begin(); it != m_deferredReleases.end();){
+            if(!it->stamped){
+                it->frontier = frontier;
+                it->stamped = true;
+                ++it;
+                continue;
+            }
+            if(m_submissions->is_complete(it->frontier)){
+                ready.push_back(std::move(it->release));
+                it = m_deferredReleases.erase(it);
+                continue;
+            }
+            ++it;
+        }
+
+        for(auto& release : ready)
+            release();
     }
 
     bool GPUResourceManager::checkTransfers()
@@ -82,6 +378,11 @@ namespace boitatah{
         return *m_imageManager;
     }
 
+    void GPUResourceManager::getPoolStats(std::vector<PoolStats> &stats) const
+    {
+        m_resourcePool->getPoolStats(stats);
+    }
+
     Handle<GPUBuffer> GPUResourceManager::create(const GPUBufferCreateDescription &description)
     {
         auto buffer = GPUBuffer(description, shared_from_this());
@@ -100,7 +401,7 @@ namespace boitatah{
             Handle<GPUBuffer> bufferHandle;
             if(bufferDesc.data_type == GEO_DATA_TYPE::Ptr)
             {
-                uint32_t data_size = static_cast<uint32_t>(bufferDesc.vertexCount * bufferDesc.vertexSize);
+                VkDeviceSize data_size = static_cast<VkDeviceSize>(bufferDesc.vertexCount) * bufferDesc.vertexSize;
                 bufferHandle = create(GPUBufferCreateDescription{
                     .size = data_size,
                     .usage = BUFFER_USAGE::VERTEX,
@@ -111,6 +412,8 @@ namespace boitatah{
 
 
                 buffer.copyData(bufferDesc.vertexDataPtr, data_size);
+                if(data_size >= ASYNC_UPLOAD_THRESHOLD)
+                    uploadAsync(bufferHandle);
                 geo.addOwnedBuffer(bufferHandle, bufferDesc.buffer_type);
             }
 
@@ -124,7 +427,7 @@ namespace boitatah{
         {
 
             if(description.indexData.data_type == GEO_DATA_TYPE::Ptr){
-                uint32_t data_size = static_cast<uint32_t>(description.indexData.count  * sizeof(uint32_t));
+                VkDeviceSize data_size = static_cast<VkDeviceSize>(description.indexData.count) * sizeof(uint32_t);
                 auto bufferHandle = create(GPUBufferCreateDescription{
                     .size = data_size,
                     .usage = BUFFER_USAGE::INDEX,
@@ -132,6 +435,8 @@ namespace boitatah{
                 });
                 auto& buffer = getResource(bufferHandle);
                 buffer.copyData(description.indexData.dataPtr, data_size);
+                if(data_size >= ASYNC_UPLOAD_THRESHOLD)
+                    uploadAsync(bufferHandle);
                 geo.indexBuffer = bufferHandle;
                 geo.indiceCount = description.indexData.count;
             }
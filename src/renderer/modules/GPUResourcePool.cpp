@@ -72,6 +72,16 @@ namespace boitatah{
         return m_gpuBufferPool->clear(handle);
     }
 
+    bool GPUResourcePool::contains(Handle<GPUBuffer> handle)
+    {
+        return m_gpuBufferPool->contains(handle);
+    }
+
+    bool GPUResourcePool::contains(Handle<RenderTexture> handle)
+    {
+        return m_renderTexPool->contains(handle);
+    }
+
 
 
     RenderTexture& GPUResourcePool::get(Handle<RenderTexture> handle)
@@ -93,6 +103,13 @@ namespace boitatah{
         return m_renderTexPool->clear(handle);
     }
 
+    void GPUResourcePool::getPoolStats(std::vector<PoolStats> &stats) const
+    {
+        stats.push_back(m_geometryPool->getStats());
+        stats.push_back(m_gpuBufferPool->getStats());
+        stats.push_back(m_renderTexPool->getStats());
+    }
+
 
     // FixedTexture& GPUResourcePool::get(Handle<FixedTexture> handle)
     // {
@@ -0,0 +1,140 @@
+#include <boitatah/modules/GpuProfiler.hpp>
+
+#include <algorithm>
+#include <iostream>
+
+namespace boitatah
+{
+    GpuProfiler::GpuProfiler(std::shared_ptr<vk::VulkanInstance> vk_instance,
+                             uint32_t slots,
+                             bool enable,
+                             uint32_t maxScopes)
+        : m_vk(vk_instance), m_maxScopes(maxScopes)
+    {
+        m_enabled = enable && slots != 0 && maxScopes != 0;
+        if(m_enabled && !m_vk->supports_gpu_timestamps()){
+            std::cout << "gpu profiling disabled, the graphics queue has no timestamps "
+                         "or queries can't be reset from the host" << std::endl;
+            m_enabled = false;
+        }
+        if(!m_enabled)
+            return;
+
+        uint32_t bits = m_vk->get_timestamp_valid_bits();
+        m_mask = bits >= 64 ? UINT64_MAX : (uint64_t{1} << bits) - 1;
+        m_period = m_vk->get_timestamp_period();
+
+        //a begin and an end query per scope.
+        m_pool = m_vk->create_timestamp_querypool(slots * maxScopes * 2);
+        m_slices.resize(slots);
+        for(auto& slice : m_slices)
+            slice.names.reserve(maxScopes);
+        m_results.resize(maxScopes * 2 * 2);
+        m_timings.reserve(maxScopes);
+        m_track = &profiler::create_track("gpu graphics queue");
+    }
+
+    GpuProfiler::~GpuProfiler()
+    {
+        if(m_pool != VK_NULL_HANDLE)
+            m_vk->destroy_querypool(m_pool);
+    }
+
+    bool GpuProfiler::isEnabled() const
+    {
+        return m_enabled;
+    }
+
+    void GpuProfiler::beginFrame(uint32_t slot)
+    {
+        if(!m_enabled)
+            return;
+
+        m_slot = slot % m_slices.size();
+        auto& slice = m_slices[m_slot];
+        uint32_t first = m_slot * m_maxScopes * 2;
+        if(!slice.names.empty()){
+            readBack(slice, first);
+            m_vk->reset_querypool(m_pool, first, static_cast<uint32_t>(slice.names.size()) * 2);
+            slice.names.clear();
+            slice.submitted = 0;
+        }
+        m_open = true;
+    }
+
+    void GpuProfiler::endFrame()
+    {
+        if(!m_open)
+            return;
+        m_slices[m_slot].submitted = profiler::now_ns();
+        m_open = false;
+    }
+
+    uint32_t GpuProfiler::beginScope(vk::VkCommandBufferWriter &writer, const char *name)
+    {
+        if(!m_open)
+            return UINT32_MAX;
+        auto& slice = m_slices[m_slot];
+        if(slice.names.size() == m_maxScopes)
+            return UINT32_MAX;
+
+        uint32_t scope = static_cast<uint32_t>(slice.names.size());
+        slice.names.push_back(name);
+        writer.write_timestamp({
+            .pool = m_pool,
+            .query = (m_slot * m_maxScopes + scope) * 2,
+            .stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        });
+        return scope;
+    }
+
+    void GpuProfiler::endScope(vk::VkCommandBufferWriter &writer, uint32_t scope)
+    {
+        if(!m_open || scope == UINT32_MAX)
+            return;
+        writer.write_timestamp({
+            .pool = m_pool,
+            .query = (m_slot * m_maxScopes + scope) * 2 + 1,
+            .stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        });
+    }
+
+    std::span<const GpuTiming> GpuProfiler::getTimings() const
+    {
+        return m_timings;
+    }
+
+    void GpuProfiler::readBack(FrameSlice &slice, uint32_t first)
+    {
+        uint32_t scopes = static_cast<uint32_t>(slice.names.size());
+        //the frame is complete, unavailable queries were never written, like an unclosed scope.
+        m_vk->get_timestamp_results(m_pool, first, scopes * 2, m_results.data());
+
+        //the gpu clock has its own origin, the earliest scope is placed at the submit.
+        uint64_t origin = UINT64_MAX;
+        m_timings.clear();
+        for(uint32_t i = 0; i < scopes; i++){
+            const uint64_t* query = &m_results[i * 4];
+            if(query[1] == 0 || query[3] == 0)
+                continue;
+            origin = std::min(origin, query[0] & m_mask);
+            uint64_t ticks = ((query[2] & m_mask) - (query[0] & m_mask)) & m_mask;
+            m_timings.push_back({.name = slice.names[i], .ms = ticks * m_period * 1e-6});
+        }
+
+        //never went to the queues through endFrame, nothing to place it on the trace.
+        if(slice.submitted == 0)
+            return;
+
+        uint32_t timing = 0;
+        for(uint32_t i = 0; i < scopes; i++){
+            const uint64_t* query = &m_results[i * 4];
+            if(query[1] == 0 || query[3] == 0)
+                continue;
+            uint64_t begin = slice.submitted +
+                static_cast<uint64_t>((((query[0] & m_mask) - origin) & m_mask) * m_period);
+            uint64_t duration = static_cast<uint64_t>(m_timings[timing++].ms * 1e6);
+            profiler::record_track_zone(*m_track, slice.names[i], begin, begin + duration);
+        }
+    }
+}
@@ -44,6 +44,9 @@ Handle<Image> ImageManager::createImage(const ImageDesc &description)
     if(!description.skip_view)
         image.view = m_vk->create_imageview(image.image, description);
 
+    auto& stats = memoryStats(image);
+    stats.count++;
+    stats.bytes += image.memorySize;
     return m_imagePool->set(image);
 }
 bool ImageManager::check_image(const Handle<Image> &handle)
@@ -64,9 +67,31 @@ void ImageManager::destroyImage(const Handle<Image> &handle)
         return;
 
     m_vk->destroy_image(image);
+    m_imagePool->clear(handle);
+    if(!image.swapchain){
+        auto& stats = memoryStats(image);
+        stats.count--;
+        stats.bytes -= image.memorySize;
+    }
 }
 Image &ImageManager::getImage(Handle<Image> &handle)
 {
     return m_imagePool->get(handle);
 }
+std::span<const ImageMemoryStats> ImageManager::getMemoryStats() const
+{
+    return m_memoryStats;
+}
+void ImageManager::getPoolStats(std::vector<PoolStats> &stats) const
+{
+    stats.push_back(m_imagePool->getStats());
+    stats.push_back(m_sampler_pool->getStats());
+}
+ImageMemoryStats &ImageManager::memoryStats(const Image &image)
+{
+    for(auto& stats : m_memoryStats)
+        if(stats.format == image.format && stats.usage == image.usage)
+            return stats;
+    return m_memoryStats.emplace_back(ImageMemoryStats{.format = image.format, .usage = image.usage});
+}
 };
\ No newline at end of file
@@ -0,0 +1,194 @@
+#include <boitatah/modules/JobSystem.hpp>
+#include <boitatah/modules/Profiler.hpp>
+
+#include <algorithm>
+
+namespace boitatah{
+
+    //the queue of the running thread, set for workers only.
+    static thread_local const JobSystem* t_system = nullptr;
+    static thread_local uint32_t t_queue = 0;
+
+    JobSystem::JobSystem(uint32_t threads)
+    {
+        if(threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+
+        //the calling thread works on queue 0 while it waits.
+        for(uint32_t i = 0; i < threads; i++)
+            m_queues.push_back(std::make_unique<WorkerQueue>());
+
+        for(uint32_t i = 1; i < threads; i++)
+            m_threads.emplace_back([this, i](){ worker_loop(i); });
+    }
+
+    JobSystem::~JobSystem()
+    {
+        {
+            std::lock_guard lock(m_sleepMutex);
+            m_running = false;
+        }
+        m_wake.notify_all();
+        for(auto& thread : m_threads)
+            thread.join();
+    }
+
+    void JobSystem::run(JobCounter &counter, std::function<void()> job)
+    {
+        counter.m_pending.fetch_add(1, std::memory_order_relaxed);
+        push({.counter = &counter, .work = std::move(job)});
+    }
+
+    void JobSystem::run_after(JobCounter &dependency, JobCounter &counter, std::function<void()> job)
+    {
+        counter.m_pending.fetch_add(1, std::memory_order_relaxed);
+        {
+            //finish takes the continuations under the same lock.
+            std::lock_guard lock(dependency.m_mutex);
+            if(!dependency.done()){
+                dependency.m_continuations.push_back({.counter = &counter, .work = std::move(job)});
+                return;
+            }
+        }
+        push({.counter = &counter, .work = std::move(job)});
+    }
+
+    void JobSystem::wait(JobCounter &counter)
+    {
+        uint32_t queue = current_queue();
+        while(!counter.done()){
+            if(!run_one(queue))
+                std::this_thread::yield();
+        }
+    }
+
+    void JobSystem::parallel_for(uint32_t count,
+                                 uint32_t grain,
+                                 const std::function<void(uint32_t, uint32_t)> &body)
+    {
+        if(count == 0)
+            return;
+
+        //a few ranges per thread leaves room for stealing.
+        uint32_t ranges = std::min(std::max(1u, count / std::max(1u, grain)),
+                                   thread_count() * 4);
+        uint32_t size = (count + ranges - 1) / ranges;
+
+        if(ranges == 1){
+            body(0, count);
+            return;
+        }
+
+        JobCounter counter;
+        for(uint32_t begin = 0; begin < count; begin += size){
+            uint32_t end = std::min(count, begin + size);
+            run(counter, [&body, begin, end](){ body(begin, end); });
+        }
+        wait(counter);
+    }
+
+    uint32_t JobSystem::thread_count() const
+    {
+        return static_cast<uint32_t>(m_queues.size());
+    }
+
+    void JobSystem::push(Job job)
+    {
+        //counted before it is visible, so the count never drops below the queues.
+        m_queued.fetch_add(1, std::memory_order_release);
+
+        auto& queue = *m_queues[current_queue()];
+        {
+            std::lock_guard lock(queue.mutex);
+            if(queue.count == queue.jobs.size()){
+                std::vector<Job> grown(std::max<std::size_t>(16, queue.jobs.size() * 2));
+                for(uint32_t i = 0; i < queue.count; i++)
+                    grown[i] = std::move(queue.jobs[(queue.head + i) % queue.jobs.size()]);
+                queue.jobs.swap(grown);
+                queue.head = 0;
+            }
+            queue.jobs[(queue.head + queue.count) % queue.jobs.size()] = std::move(job);
+            queue.count++;
+        }
+
+        //a worker between its check and its wait holds the sleep lock.
+        { std::lock_guard lock(m_sleepMutex); }
+        m_wake.notify_one();
+    }
+
+    bool JobSystem::pop(uint32_t queue, Job &job)
+    {
+        auto& own = *m_queues[queue];
+        std::lock_guard lock(own.mutex);
+        if(own.count == 0)
+            return false;
+        //newest first, its data is likely still in cache.
+        own.count--;
+        job = std::move(own.jobs[(own.head + own.count) % own.jobs.size()]);
+        return true;
+    }
+
+    bool JobSystem::steal(uint32_t thief, Job &job)
+    {
+        for(uint32_t i = 1; i < m_queues.size(); i++){
+            auto& victim = *m_queues[(thief + i) % m_queues.size()];
+            std::lock_guard lock(victim.mutex);
+            if(victim.count == 0)
+                continue;
+            job = std::move(victim.jobs[victim.head]);
+            victim.head = (victim.head + 1) % victim.jobs.size();
+            victim.count--;
+            return true;
+        }
+        return false;
+    }
+
+    bool JobSystem::run_one(uint32_t queue)
+    {
+        Job job;
+        if(!pop(queue, job) && !steal(queue, job))
+            return false;
+
+        m_queued.fetch_sub(1, std::memory_order_relaxed);
+        job.work();
+        finish(*job.counter);
+        return true;
+    }
+
+    void JobSystem::finish(JobCounter &counter)
+    {
+        std::vector<JobCounter::Continuation> ready;
+        {
+            std::lock_guard lock(counter.m_mutex);
+            if(counter.m_pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                return;
+            ready.swap(counter.m_continuations);
+        }
+        for(auto& continuation : ready)
+            push({.counter = continuation.counter, .work = std::move(continuation.work)});
+    }
+
+    void JobSystem::worker_loop(uint32_t queue)
+    {
+        t_system = this;
+        t_queue = queue;
+        BOITATAH_PROFILER_THREAD("job worker");
+
+        while(true){
+            if(run_one(queue))
+                continue;
+
+            std::unique_lock lock(m_sleepMutex);
+            m_wake.wait(lock, [this](){
+                return !m_running || m_queued.load(std::memory_order_acquire) > 0;
+            });
+            if(!m_running)
+                return;
+        }
+    }
+
+    uint32_t JobSystem::current_queue() const
+    {
+        return t_system == this ? t_queue : 0;
+    }
+}
@@ -1,6 +1,7 @@
 #include <boitatah/modules/MaterialManager.hpp>
 #include <algorithm>
 #include <boitatah/utils/utils.hpp>
+#include <spirv_reflect.h>
 
 namespace boitatah{
     
@@ -81,11 +82,12 @@ namespace boitatah{
     MaterialManager::MaterialManager(std::shared_ptr<VulkanInstance> vulkan,
                                      std::shared_ptr<RenderTargetManager> targetManager,
                                      std::shared_ptr<DescriptorSetManager> setManager,
-                                     std::shared_ptr<GPUResourceManager> resourceManager) 
+                                     std::shared_ptr<GPUResourceManager> resourceManager,
+                                     JobSystem* jobs) 
      : m_vk(vulkan), m_targetManager(targetManager), m_descriptorManager(setManager),
        m_resourceManager(resourceManager)
     {
-        m_shaderManager = std::make_unique<ShaderManager>(m_vk, m_targetManager, m_descriptorManager);
+        m_shaderManager = std::make_unique<ShaderManager>(m_vk, m_targetManager, m_descriptorManager, jobs);
         m_materialPool = std::make_unique<Pool<Material>>(PoolOptions{
             .size = 4096,
             .dynamic = true,
@@ -297,7 +299,20 @@ namespace boitatah{
                                                     const uint32_t set, const uint32_t binding)
     {
         auto& mat = getMaterialContent(material);
-        getBinding(mat.bindings[set]).bindings[binding].binding_handle.buffer = gpu_buffer;
+        auto& att = getBinding(mat.bindings[set]).bindings[binding];
+        att.transient = false;
+        att.binding_handle.buffer = gpu_buffer;
+        return true;
+    }
+
+    bool MaterialManager::setTransientBindingAttribute(const Handle<Material> material,
+                                                       const BufferAccessData &access,
+                                                       const uint32_t set, const uint32_t binding)
+    {
+        auto& mat = getMaterialContent(material);
+        auto& att = getBinding(mat.bindings[set]).bindings[binding];
+        att.transient = true;
+        att.binding_handle.transient = access;
         return true;
     }
 
@@ -321,7 +336,131 @@ namespace boitatah{
     void MaterialManager::resetBindings()
     {
         m_currentBindings.clear();
-        m_currentPipeline = Handle<Shader>();
+        m_currentSets.clear();
+    }
+
+    void MaterialManager::getPoolStats(std::vector<PoolStats> &stats) const
+    {
+        stats.push_back(m_materialPool->getStats());
+        stats.push_back(m_bindingsPool->getStats());
+    }
+
+    bool MaterialManager::ResolveMaterial(Handle<Material> &handle,
+                                          uint32_t frame_index,
+                                          MaterialDrawData &data)
+    {
+        auto& material = m_materialPool->get(handle);
+        if(material.bindings.size() > data.sets.size())
+            throw std::runtime_error("too many material bindings");
+
+        data = {};
+        if(!material.shader || !m_shaderManager->isValid(material.shader))
+            return false;
+        //left undrawn, like geometry still uploading.
+        if(m_resourceManager->hasHiddenTextures() && !texturesVisible(material))
+            return false;
+
+        auto& shader = m_shaderManager->get(material.shader);
+        data.pipeline = shader.pipeline;
+        data.layout = shader.layout.pipeline;
+
+        if(m_currentBindings.size() < material.bindings.size()){
+            m_currentBindings.resize(material.bindings.size());
+            m_currentSets.resize(material.bindings.size(), VK_NULL_HANDLE);
+        }
+
+        bool success = true;
+        data.setCount = static_cast<uint32_t>(material.bindings.size());
+        for(uint32_t i = 0; i < material.bindings.size(); i++){
+            data.sets[i] = resolveBinding(material.bindings[i],
+                                          shader.layout.descriptorSets[i],
+                                          i,
+                                          frame_index);
+            success &= data.sets[i] != VK_NULL_HANDLE;
+        }
+        return success;
+    }
+
+    bool MaterialManager::texturesVisible(Material &material)
+    {
+        for(auto& handle : material.bindings){
+            if(!m_bindingsPool->contains(handle))
+                continue;
+            for(auto& att : getBinding(handle).bindings)
+                if(att.type == DESCRIPTOR_TYPE::COMBINED_IMAGE_SAMPLER &&
+                   !m_resourceManager->isVisible(att.binding_handle.renderTex))
+                    return false;
+        }
+        return true;
+    }
+
+    VkDescriptorSet MaterialManager::resolveBinding(Handle<MaterialBinding> &handle,
+                                                    Handle<DescriptorSetLayout> setLayout,
+                                                    uint32_t set_index,
+                                                    uint32_t frame_index)
+    {
+        //invalid binding
+        if(!m_bindingsPool->contains(handle))
+            return VK_NULL_HANDLE;
+
+        //already written
+        if(m_currentBindings[set_index] == handle)
+            return m_currentSets[set_index];
+
+        auto& binding = getBinding(handle);
+
+        auto& layoutContent = m_descriptorManager->getLayoutContent(setLayout);
+        auto set = m_descriptorManager->getSet(layoutContent, frame_index);
+
+        std::pmr::vector<BindBindingDesc> bindings(m_descriptorManager->getFrameResource());
+        bindings.reserve(binding.bindings.size());
+        for(int i = 0; i < binding.bindings.size(); i++){
+            BindBindingDesc desc;
+            desc.binding = i;
+            desc.type = binding.bindings[i].type;
+            switch(desc.type){
+                case DESCRIPTOR_TYPE::UNIFORM_BUFFER:
+                    if(binding.bindings[i].transient){
+                        desc.access.bufferData = binding.bindings[i].binding_handle.transient;
+                        break;
+                    }
+                    desc.access.bufferData = m_resourceManager->
+                                                    getCommitResourceAccessData(
+                                                        binding.bindings[i].binding_handle.buffer,
+                                                        frame_index);
+                    break;
+
+                case DESCRIPTOR_TYPE::COMBINED_IMAGE_SAMPLER:
+                    desc.access.textureData = m_resourceManager->
+                                                    getCommitResourceAccessData(
+                                                        binding.bindings[i].binding_handle.renderTex,
+                                                    frame_index);
+                    break;
+
+                case DESCRIPTOR_TYPE::IMAGE:{
+                    auto& image = m_resourceManager->getImageManager().
+                                                    getImage(
+                                                        binding.bindings[i].binding_handle.image);
+                    desc.access.imageData = {.view = image.view};
+                    break;}
+
+                case DESCRIPTOR_TYPE::SAMPLER:{
+                    auto& sampler = m_resourceManager->getImageManager().
+                                        getSampler(binding.bindings[i].binding_handle.sampler);
+                    desc.access.samplerData = {.sampler = sampler.sampler};
+                    break; }
+
+            }
+
+            bindings.push_back(desc);
+        }
+        m_descriptorManager->writeSet(bindings,
+                                    set,
+                                    frame_index);
+
+        m_currentBindings[set_index] = handle;
+        m_currentSets[set_index] = set.descriptorSet;
+        return set.descriptorSet;
     }
 
     ShaderModule ShaderManager::compileShaderModule(const std::vector<char> &bytecode, std::string entryPoint)
@@ -333,10 +472,14 @@ namespace boitatah{
         return m_shaderPool->get(handle);
     }
 
-    ShaderManager::ShaderManager(std::shared_ptr<VulkanInstance> vulkan, std::shared_ptr<RenderTargetManager> targetManager, std::shared_ptr<DescriptorSetManager> descriptorManager)
+    ShaderManager::ShaderManager(std::shared_ptr<VulkanInstance> vulkan,
+                                 std::shared_ptr<RenderTargetManager> targetManager,
+                                 std::shared_ptr<DescriptorSetManager> descriptorManager,
+                                 JobSystem* jobs)
     :   m_vk(vulkan), 
         m_targetManager(targetManager),
-        m_descriptorManager(descriptorManager)
+        m_descriptorManager(descriptorManager),
+        m_jobs(jobs)
     {
         m_layoutPool = std::make_unique<Pool<ShaderLayout>>(PoolOptions{
             .size = 4096,
@@ -351,13 +494,20 @@ namespace boitatah{
         });
     }
 
+    ShaderManager::~ShaderManager()
+    {
+        //pending jobs still point at this manager.
+        waitShaderCompilation();
+    }
+
     ShaderLayout& ShaderManager::get(const Handle<ShaderLayout>& handle){
         return m_layoutPool->get(handle);
     };
 
     bool ShaderManager::isValid(Handle<Shader> &handle)
     {
-        return m_shaderPool->contains(handle);
+        std::lock_guard<std::mutex> lock(m_shaderPoolMutex);
+        return m_shaderPool->contains(handle) && !m_pendingShaders.contains(handle);
     }
     Handle<ShaderLayout> ShaderManager::makeShaderLayout(const ShaderLayoutDesc &description)
     {   
@@ -366,34 +516,365 @@ namespace boitatah{
             auto& layout = m_descriptorManager->getLayoutContent(description.setLayouts[i]);
             vkLayouts.push_back(layout.layout);
         }
+
+        auto pushConstants = description.pushConstants;
+        if(pushConstants.empty())
+            pushConstants.push_back(PushConstantDesc{
+                                .offset = 0, //<-- must be larger or equal than sizeof(glm::mat4)
+                                .size = sizeof(glm::mat4), //<- M matrices
+                                .stages = SHADER_STAGE::ALL_GRAPHICS});
+
+        PipelineLayoutKey key{.setLayouts = description.setLayouts};
+        for(auto& pushConstant : pushConstants){
+            key.pushConstants.push_back(pushConstant.offset);
+            key.pushConstants.push_back(pushConstant.size);
+            key.pushConstants.push_back(static_cast<uint32_t>(pushConstant.stages));
+        }
+
+        auto cached = m_layoutCache.find(key);
+        if(cached != m_layoutCache.end()){
+            cached->second.users++;
+            return cached->second.layout;
+        }
         
         ShaderLayout layout{ 
                                 .pipeline = m_vk->create_shaderlayout(
                                     {
                                         .materialLayouts = vkLayouts,
-                                        .pushConstants ={
-                                            PushConstantDesc{
-                                            .offset = 0, //<-- must be larger or equal than sizeof(glm::mat4)
-                                            .size = sizeof(glm::mat4), //<- M matrices
-                                            .stages = SHADER_STAGE::ALL_GRAPHICS}},
+                                        .pushConstants = pushConstants,
                                     }),
                                 .descriptorSets = description.setLayouts,
                                 };
 
-        return m_layoutPool->set(layout);
+        auto handle = m_layoutPool->set(layout);
+        m_layoutCache[key] = {.layout = handle, .users = 1};
+        return handle;
 
 
     }
+
+    Handle<ShaderLayout> ShaderManager::makeShaderLayout(const ShaderReflection &reflection,
+                                                         const std::vector<Handle<DescriptorSetLayout>> &overrides)
+    {
+        ShaderLayoutDesc description{
+            .setLayouts = overrides,
+            .pushConstants = reflection.pushConstants,
+        };
+
+        for(std::size_t i = overrides.size(); i < reflection.setLayouts.size(); i++)
+            description.setLayouts.push_back(m_descriptorManager->getLayout(reflection.setLayouts[i]));
+
+        return makeShaderLayout(description);
+    }
+
+    static IMAGE_FORMAT reflectedFormat(SpvReflectFormat format){
+        switch(format){
+            case SPV_REFLECT_FORMAT_R32_SFLOAT:             return IMAGE_FORMAT::R_32_SFLOAT;
+            case SPV_REFLECT_FORMAT_R32G32_SFLOAT:          return IMAGE_FORMAT::RG_32_SFLOAT;
+            case SPV_REFLECT_FORMAT_R32G32B32_SFLOAT:       return IMAGE_FORMAT::RGB_32_SFLOAT;
+            case SPV_REFLECT_FORMAT_R32G32B32A32_SFLOAT:    return IMAGE_FORMAT::RGBA_32_SFLOAT;
+            case SPV_REFLECT_FORMAT_R32_SINT:               return IMAGE_FORMAT::R_32_SINT;
+            case SPV_REFLECT_FORMAT_R32G32_SINT:            return IMAGE_FORMAT::RG_32_SINT;
+            case SPV_REFLECT_FORMAT_R32G32B32_SINT:         return IMAGE_FORMAT::RGB_32_SINT;
+            case SPV_REFLECT_FORMAT_R32G32B32A32_SINT:      return IMAGE_FORMAT::RGBA_32_SINT;
+            case SPV_REFLECT_FORMAT_R32_UINT:               return IMAGE_FORMAT::R_32_UINT;
+            case SPV_REFLECT_FORMAT_R32G32_UINT:            return IMAGE_FORMAT::RG_32_UINT;
+            case SPV_REFLECT_FORMAT_R32G32B32_UINT:         return IMAGE_FORMAT::RGB_32_UINT;
+            case SPV_REFLECT_FORMAT_R32G32B32A32_UINT:      return IMAGE_FORMAT::RGBA_32_UINT;
+            case SPV_REFLECT_FORMAT_R64_SFLOAT:             return IMAGE_FORMAT::R_64_SFLOAT;
+            case SPV_REFLECT_FORMAT_R64G64_SFLOAT:          return IMAGE_FORMAT::RG_64_SFLOAT;
+            case SPV_REFLECT_FORMAT_R64G64B64_SFLOAT:       return IMAGE_FORMAT::RGB_64_SFLOAT;
+            case SPV_REFLECT_FORMAT_R64G64B64A64_SFLOAT:    return IMAGE_FORMAT::RGBA_64_SFLOAT;
+            default:
+                throw std::runtime_error("unsupported reflected vertex input format");
+        }
+    }
+
+    static DESCRIPTOR_TYPE reflectedDescriptorType(SpvReflectDescriptorType type){
+        switch(type){
+            case SPV_REFLECT_DESCRIPTOR_TYPE_UNIFORM_BUFFER:            return DESCRIPTOR_TYPE::UNIFORM_BUFFER;
+            case SPV_REFLECT_DESCRIPTOR_TYPE_SAMPLED_IMAGE:             return DESCRIPTOR_TYPE::IMAGE;
+            case SPV_REFLECT_DESCRIPTOR_TYPE_SAMPLER:                   return DESCRIPTOR_TYPE::SAMPLER;
+            case SPV_REFLECT_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:    return DESCRIPTOR_TYPE::COMBINED_IMAGE_SAMPLER;
+            default:
+                throw std::runtime_error("unsupported reflected descriptor type");
+        }
+    }
+
+    ShaderReflection ShaderManager::reflectShader(const ShaderStage &vert, const ShaderStage &frag)
+    {
+        struct ReflectedBinding{
+            bool used = false;
+            DESCRIPTOR_TYPE type;
+            uint32_t count;
+            bool vertex = false;
+            bool fragment = false;
+        };
+        std::vector<std::vector<ReflectedBinding>> sets;
+        ShaderReflection reflection;
+        uint32_t pushConstantEnd = 0;
+
+        for(auto stage : {&vert, &frag}){
+            SpvReflectShaderModule module;
+            if(spvReflectCreateShaderModule(stage->byteCode.size(),
+                                            stage->byteCode.data(),
+                                            &module) != SPV_REFLECT_RESULT_SUCCESS)
+                throw std::runtime_error("failed to reflect shader module");
+
+            bool isVertex = module.shader_stage == SPV_REFLECT_SHADER_STAGE_VERTEX_BIT;
+
+            //vertex inputs, one buffer per location like the geometry buffers.
+            if(isVertex){
+                uint32_t count = 0;
+                spvReflectEnumerateInputVariables(&module, &count, nullptr);
+                std::vector<SpvReflectInterfaceVariable*> inputs(count);
+                spvReflectEnumerateInputVariables(&module, &count, inputs.data());
+
+                std::erase_if(inputs, [](SpvReflectInterfaceVariable* input){
+                    return (input->decoration_flags & SPV_REFLECT_DECORATION_BUILT_IN) != 0;
+                });
+                std::sort(inputs.begin(), inputs.end(), 
+                    [](SpvReflectInterfaceVariable* a, SpvReflectInterfaceVariable* b){
+                        return a->location < b->location;
+                    });
+
+                //bindings are numbered by position, a gap would shift them off the
+                // material's vertexBufferBindings, which are bound in order from 0.
+                for(uint32_t i = 0; i < inputs.size(); i++)
+                    if(inputs[i]->location != i)
+                        throw std::runtime_error("reflected vertex inputs have location gaps, expected location "
+                                                 + std::to_string(i));
+
+                for(auto input : inputs){
+                    auto format = reflectedFormat(input->format);
+                    reflection.vertexBindings.push_back({
+                        .stride = formatSize(format),
+                        .attributes = {{.location = input->location,
+                                        .format = format,
+                                        .offset = 0}}
+                    });
+                }
+            }
+
+            uint32_t setCount = 0;
+            spvReflectEnumerateDescriptorSets(&module, &setCount, nullptr);
+            std::vector<SpvReflectDescriptorSet*> reflectedSets(setCount);
+            spvReflectEnumerateDescriptorSets(&module, &setCount, reflectedSets.data());
+
+            for(auto set : reflectedSets){
+                if(sets.size() <= set->set)
+                    sets.resize(set->set + 1);
+                auto& bindings = sets[set->set];
+
+                for(uint32_t i = 0; i < set->binding_count; i++){
+                    auto reflected = set->bindings[i];
+                    if(bindings.size() <= reflected->binding)
+                        bindings.resize(reflected->binding + 1);
+                    auto& binding = bindings[reflected->binding];
+                    binding.used = true;
+                    binding.type = reflectedDescriptorType(reflected->descriptor_type);
+                    binding.count = reflected->count;
+                    binding.vertex |= isVertex;
+                    binding.fragment |= !isVertex;
+                }
+            }
+
+            uint32_t blockCount = 0;
+            spvReflectEnumeratePushConstantBlocks(&module, &blockCount, nullptr);
+            std::vector<SpvReflectBlockVariable*> blocks(blockCount);
+            spvReflectEnumeratePushConstantBlocks(&module, &blockCount, blocks.data());
+            for(auto block : blocks)
+                pushConstantEnd = std::max(pushConstantEnd, block->offset + block->size);
+
+            spvReflectDestroyShaderModule(&module);
+        }
+
+        for(uint32_t set = 0; set < sets.size(); set++){
+            DescriptorSetLayoutDesc layout;
+            for(auto& binding : sets[set]){
+                //layouts number their bindings sequentially.
+                if(!binding.used)
+                    throw std::runtime_error("reflected set " + std::to_string(set) + " has binding gaps");
+
+                auto stages = SHADER_STAGE::VERTEX_FRAGMENT;
+                if(!binding.vertex)
+                    stages = SHADER_STAGE::FRAGMENT;
+                if(!binding.fragment)
+                    stages = SHADER_STAGE::VERTEX;
+
+                layout.bindingDescriptors.push_back({
+                    .type = binding.type,
+                    .stages = stages,
+                    .descriptorCount = binding.count,
+                });
+            }
+            reflection.setLayouts.push_back(layout);
+        }
+
+        //the renderer always pushes the model matrix for every graphics stage.
+        if(pushConstantEnd > 0)
+            reflection.pushConstants.push_back({
+                .offset = 0,
+                .size = std::max<uint32_t>(pushConstantEnd, sizeof(glm::mat4)),
+                .stages = SHADER_STAGE::ALL_GRAPHICS,
+            });
+
+        return reflection;
+    }
+
+    static bool buildFailed(const std::shared_future<Handle<Shader>> &shader)
+    {
+        if(shader.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return false;
+        try{
+            shader.get();
+            return false;
+        }catch(...){
+            return true;
+        }
+    }
+
     Handle<Shader> ShaderManager::makeShader(const MakeShaderDesc &data)
     {
-        Shader shader{
-            .name = data.name,
-            .vert = compileShaderModule(data.vert.byteCode, data.vert.entryFunction),
-            .frag = compileShaderModule(data.frag.byteCode, data.vert.entryFunction)};
-        shader.description = data;
+        auto build = prepareShader(data);
+        auto key = pipelineKey(build);
+
+        auto cached = m_pipelineCache.find(key);
+        if(cached != m_pipelineCache.end()){
+            //still in a batch, help it along instead of blocking on the future.
+            if(cached->second.shader.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                waitShaderCompilation();
+            if(!buildFailed(cached->second.shader)){
+                cached->second.users++;
+                return cached->second.shader.get();
+            }
+            //failed builds aren't kept, this request retries it.
+            m_pipelineCache.erase(cached);
+        }
+
+        buildShader(build);
+        auto handle = storeShader(build.shader);
+
+        std::promise<Handle<Shader>> ready;
+        ready.set_value(handle);
+        m_pipelineCache[key] = {.shader = ready.get_future().share(), .users = 1};
+        return handle;
+    }
+
+    std::vector<std::shared_future<Handle<Shader>>> ShaderManager::makeShaders(
+                                            const std::vector<MakeShaderDesc> &descriptions)
+    {
+        auto batch = std::make_shared<ShaderBatch>();
+        //promises can't move once their futures are out.
+        batch->promises.reserve(descriptions.size());
+
+        std::vector<std::shared_future<Handle<Shader>>> futures;
+        for(std::size_t i = 0; i < descriptions.size(); i++){
+            //pool lookups are not thread safe, resolve them here.
+            auto build = prepareShader(descriptions[i]);
+            auto key = pipelineKey(build);
+
+            //already built or earlier in this batch, failed builds are retried.
+            auto cached = m_pipelineCache.find(key);
+            if(cached != m_pipelineCache.end() && buildFailed(cached->second.shader)){
+                m_pipelineCache.erase(cached);
+                cached = m_pipelineCache.end();
+            }
+            if(cached != m_pipelineCache.end()){
+                cached->second.users++;
+                futures.push_back(cached->second.shader);
+                continue;
+            }
+
+            batch->builds.push_back(std::move(build));
+            batch->handles.push_back(reserveShader());
+            auto future = batch->promises.emplace_back().get_future().share();
+            m_pipelineCache[key] = {.shader = future, .users = 1};
+            futures.push_back(future);
+        }
+
+        //drop batches that already finished.
+        std::erase_if(m_compileBatches, [](const std::shared_ptr<ShaderBatch>& done){
+            return done->counter.done();
+        });
+        if(batch->builds.empty())
+            return futures;
+
+        for(std::size_t i = 0; i < batch->builds.size(); i++){
+            m_jobs->run(batch->counter, [this, batch, i](){
+                try{
+                    buildShader(batch->builds[i]);
+                    fillShader(batch->handles[i], batch->builds[i].shader);
+                    batch->promises[i].set_value(batch->handles[i]);
+                }catch(...){
+                    releaseShader(batch->handles[i]);
+                    batch->promises[i].set_exception(std::current_exception());
+                }
+            });
+        }
+        m_compileBatches.push_back(batch);
+
+        return futures;
+    }
+
+    ShaderCodeKey ShaderManager::internCode(const std::vector<char> &byteCode)
+    {
+        auto hash = std::hash<std::string_view>()({byteCode.data(), byteCode.size()});
+        auto [first, last] = m_byteCode.equal_range(hash);
+        for(auto it = first; it != last; it++)
+            if(*it->second == byteCode)
+                return {.hash = hash, .code = it->second};
+
+        auto code = std::make_shared<const std::vector<char>>(byteCode);
+        m_byteCode.emplace(hash, code);
+        return {.hash = hash, .code = code};
+    }
+
+    PipelineKey ShaderManager::pipelineKey(const ShaderBuild &build)
+    {
+        auto& data = build.shader.description;
+        PipelineKey key{
+            .vert = build.vertCode,
+            .vertEntry = data.vert.entryFunction,
+            .frag = build.fragCode,
+            .fragEntry = data.frag.entryFunction,
+            .renderpass = build.description.renderpass,
+            .layout = build.description.layout,
+            .use_depth = build.description.use_depth,
+            .colorBlends = build.description.colorBlends.size(),
+            .specialization = build.description.specialization,
+        };
+        for(auto& binding : build.description.bindings){
+            key.vertexInput.push_back(binding.binding);
+            key.vertexInput.push_back(binding.stride);
+        }
+        for(auto& attribute : build.description.attributes){
+            key.vertexInput.push_back(attribute.location);
+            key.vertexInput.push_back(attribute.binding);
+            key.vertexInput.push_back(attribute.format);
+            key.vertexInput.push_back(attribute.offset);
+        }
+        return key;
+    }
+
+    void ShaderManager::waitShaderCompilation()
+    {
+        //the calling thread runs compile jobs while it waits.
+        for(auto& batch : m_compileBatches)
+            m_jobs->wait(batch->counter);
+        m_compileBatches.clear();
+    }
+
+    ShaderManager::ShaderBuild ShaderManager::prepareShader(const MakeShaderDesc &data)
+    {
+        ShaderBuild build;
+        build.shader.name = data.name;
+        build.shader.description = data;
+        build.shader.vert.entryFunction = data.vert.entryFunction;
+        build.shader.frag.entryFunction = data.frag.entryFunction;
 
         ShaderLayout layoutData = m_layoutPool->get(data.layout);
-        shader.layout = layoutData;
+        build.shader.layout = layoutData;
 
         // TODO Convert bindings in vulkan class?
         std::vector<VkVertexInputAttributeDescription> vkattributes;
@@ -425,34 +906,152 @@ namespace boitatah{
             }
         }
         auto& pass = m_targetManager->get(data.renderPass);
-        m_vk->build_shader({
+        build.description = {
             .name = data.name,
             .renderpass = pass.renderPass,
-            .layout = shader.layout.pipeline,
+            .layout = build.shader.layout.pipeline,
             .use_depth = pass.description.use_depthStencil,
             .colorBlends = data.colorBlends,
             .bindings = vkbindings,
             .attributes = vkattributes,
-            
-        }, shader);
+            .specialization = data.specialization,
+        };
+        build.vertCode = internCode(data.vert.byteCode);
+        build.fragCode = internCode(data.frag.byteCode);
+        return build;
+    }
+
+    //runs on the compile workers, only touches the device.
+    void ShaderManager::buildShader(ShaderBuild &build)
+    {
+        auto& data = build.shader.description;
+        build.shader.vert = compileShaderModule(data.vert.byteCode, data.vert.entryFunction);
+        build.shader.frag = compileShaderModule(data.frag.byteCode, data.frag.entryFunction);
+        m_vk->build_shader(build.description, build.shader);
+    }
+
+    Handle<Shader> ShaderManager::storeShader(Shader &shader)
+    {
+        std::lock_guard<std::mutex> lock(m_shaderPoolMutex);
         return m_shaderPool->move_set(shader);
     }
+
+    Handle<Shader> ShaderManager::reserveShader()
+    {
+        std::lock_guard<std::mutex> lock(m_shaderPoolMutex);
+        auto handle = m_shaderPool->getHandle();
+        m_pendingShaders.insert(handle);
+        return handle;
+    }
+
+    void ShaderManager::fillShader(Handle<Shader> handle, Shader &shader)
+    {
+        //the slot is only known to this job, the pool storage doesn't move under the lock.
+        std::lock_guard<std::mutex> lock(m_shaderPoolMutex);
+        m_shaderPool->get(handle) = std::move(shader);
+        m_pendingShaders.erase(handle);
+    }
+
+    void ShaderManager::releaseShader(Handle<Shader> handle)
+    {
+        std::lock_guard<std::mutex> lock(m_shaderPoolMutex);
+        m_shaderPool->clear(handle);
+        m_pendingShaders.erase(handle);
+    }
+
+    Handle<Shader> ShaderManager::getVariant(const Handle<Shader> &shader,
+                                             std::vector<SpecializationConstant> constants)
+    {
+        if(constants.empty())
+            return shader;
+
+        //same constants in any order are the same variant.
+        std::sort(constants.begin(), constants.end(),
+            [](const SpecializationConstant& a, const SpecializationConstant& b){
+                return a.id < b.id;
+            });
+
+        ShaderVariantKey key{.shader = shader, .constants = constants};
+        auto it = m_variants.find(key);
+        if(it != m_variants.end() && isValid(it->second))
+            return it->second;
+
+        auto description = get(shader).description;
+        for(auto& constant : constants){
+            auto existing = std::find_if(description.specialization.begin(),
+                                         description.specialization.end(),
+                [&constant](const SpecializationConstant& c){ return c.id == constant.id; });
+            if(existing != description.specialization.end())
+                existing->value = constant.value;
+            else
+                description.specialization.push_back(constant);
+        }
+
+        auto variant = makeShader(description);
+        m_variants[key] = variant;
+        return variant;
+    }
+
     void ShaderManager::destroy(Handle<Shader> &handle)
     {
+        //shared pipelines only go away with their last user.
+        auto cached = std::find_if(m_pipelineCache.begin(), m_pipelineCache.end(),
+            [&handle](const auto& entry){
+                auto& future = entry.second.shader;
+                if(future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                    return false;
+                try{
+                    return future.get() == handle;
+                }catch(...){
+                    return false;
+                }
+            });
+        if(cached != m_pipelineCache.end()){
+            if(--cached->second.users > 0)
+                return;
+            m_pipelineCache.erase(cached);
+            //bytecode no pipeline key refers to anymore.
+            std::erase_if(m_byteCode, [](const auto& entry){ return entry.second.use_count() == 1; });
+        }
+
+        //variants go with their base shader
+        std::vector<Handle<Shader>> variants;
+        std::erase_if(m_variants, [&handle, &variants](const auto& entry){
+            if(!(entry.first.shader == handle))
+                return false;
+            variants.push_back(entry.second);
+            return true;
+        });
+        for(auto& variant : variants)
+            destroy(variant);
+
         Shader shader;
-        if (m_shaderPool->clear(handle, shader))
+        bool cleared;
+        {
+            std::lock_guard<std::mutex> lock(m_shaderPoolMutex);
+            cleared = m_shaderPool->clear(handle, shader);
+        }
+        if (cleared)
         {
             m_vk->destroy_shader(shader);
-            m_currentShaders.erase(
-                std::find(
-                    m_currentShaders.begin(),
-                    m_currentShaders.end(), 
-                    handle));
+            auto current = std::find(m_currentShaders.begin(),
+                                     m_currentShaders.end(), 
+                                     handle);
+            if(current != m_currentShaders.end())
+                m_currentShaders.erase(current);
         }
     }
 
     void ShaderManager::destroy(Handle<ShaderLayout> &handle)
     {
+        auto cached = std::find_if(m_layoutCache.begin(), m_layoutCache.end(),
+            [&handle](const auto& entry){ return entry.second.layout == handle; });
+        if(cached != m_layoutCache.end()){
+            if(--cached->second.users > 0)
+                return;
+            m_layoutCache.erase(cached);
+        }
+
         ShaderLayout layout;
         if (m_layoutPool->clear(handle, layout))
         {
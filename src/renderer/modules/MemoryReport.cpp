@@ -0,0 +1,187 @@
+#include <boitatah/modules/MemoryReport.hpp>
+
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+
+namespace boitatah
+{
+    enum BUDGET_LIMIT : uint32_t{
+        DEVICE_LOCAL_LIMIT  = 1u << 0,
+        HOST_VISIBLE_LIMIT  = 1u << 1,
+        STAGING_LIMIT       = 1u << 2,
+        HEAP_USAGE_LIMIT    = 1u << 3,
+    };
+
+    static const char* format_name(IMAGE_FORMAT format)
+    {
+        static const char* names[] = {
+            "UNKNOWN", "RGBA_8_SRGB", "BGRA_8_SRGB", "RGBA_8_UNORM", "BGRA_8_UNORM",
+            "R_32_SFLOAT", "RG_32_SFLOAT", "RGB_32_SFLOAT", "RGBA_32_SFLOAT",
+            "R_32_SINT", "RG_32_SINT", "RGB_32_SINT", "RGBA_32_SINT",
+            "R_32_UINT", "RG_32_UINT", "RGB_32_UINT", "RGBA_32_UINT",
+            "R_64_SFLOAT", "RG_64_SFLOAT", "RGB_64_SFLOAT", "RGBA_64_SFLOAT",
+            "DEPTH_32_SFLOAT", "DEPTH_32_SFLOAT_UINT_STENCIL", "DEPTH_24_UNORM_UINT_STENCIL",
+        };
+        auto index = static_cast<uint32_t>(format);
+        return index < std::size(names) ? names[index] : names[0];
+    }
+
+    static const char* image_usage_name(IMAGE_USAGE usage)
+    {
+        static const char* names[] = {
+            "UNKNOWN", "TRANSFER_SRC", "TRANSFER_DST", "COLOR_ATT", "DEPTH_STENCIL", "SAMPLED",
+            "TRANSFER_DST_SAMPLED", "COLOR_ATT_TRANSFER_DST", "COLOR_ATT_TRANSFER_SRC",
+            "RENDER_GRAPH_COLOR", "RENDER_GRAPH_DEPTH", "STAGING",
+        };
+        auto index = static_cast<uint32_t>(usage);
+        return index < std::size(names) ? names[index] : names[0];
+    }
+
+    static const char* buffer_usage_name(BUFFER_USAGE usage)
+    {
+        static const char* names[] = {
+            "UNKNOWN", "VERTEX", "INDEX", "TRANSFER_SRC", "TRANSFER_DST", "UNIFORM_BUFFER", "TRANSIENT",
+        };
+        auto index = static_cast<uint32_t>(usage);
+        return index < std::size(names) ? names[index] : names[0];
+    }
+
+    std::string MemoryReport::toJson() const
+    {
+        std::ostringstream out;
+        out << "{\n  \"heaps\": [\n";
+        for(std::size_t i = 0; i < heaps.size(); i++){
+            auto& heap = heaps[i];
+            out << "    {\"index\": " << i
+                << ", \"device_local\": " << (heap.deviceLocal ? "true" : "false")
+                << ", \"size\": " << heap.size
+                << ", \"allocated\": " << heap.allocated
+                << ", \"allocations\": " << heap.allocations
+                << ", \"budget\": " << heap.budget
+                << ", \"usage\": " << heap.usage << "}"
+                << (i + 1 < heaps.size() ? "," : "") << "\n";
+        }
+
+        out << "  ],\n  \"buffers\": [\n";
+        for(std::size_t i = 0; i < buffers.size(); i++){
+            auto& buffer = buffers[i];
+            out << "    {\"id\": " << buffer.id
+                << ", \"usage\": \"" << buffer_usage_name(buffer.usage) << "\""
+                << ", \"sharing\": \"" << (buffer.sharing == SHARING_MODE::CONCURRENT ? "CONCURRENT" : "EXCLUSIVE") << "\""
+                << ", \"size\": " << buffer.size
+                << ", \"occupied\": " << buffer.occupied
+                << ", \"largest_free\": " << buffer.largestFree
+                << ", \"slab_slot_size\": " << buffer.slabSlotSize << "}"
+                << (i + 1 < buffers.size() ? "," : "") << "\n";
+        }
+
+        out << "  ],\n  \"staging\": {\"reserved\": " << staging.reserved
+            << ", \"capacity\": " << staging.capacity
+            << ", \"transient_used\": " << staging.transientUsed
+            << ", \"transient_capacity\": " << staging.transientCapacity << "},\n";
+
+        out << "  \"images\": [\n";
+        for(std::size_t i = 0; i < images.size(); i++){
+            auto& image = images[i];
+            out << "    {\"format\": \"" << format_name(image.format) << "\""
+                << ", \"usage\": \"" << image_usage_name(image.usage) << "\""
+                << ", \"count\": " << image.count
+                << ", \"bytes\": " << image.bytes << "}"
+                << (i + 1 < images.size() ? "," : "") << "\n";
+        }
+
+        out << "  ],\n  \"descriptor_pools\": [\n";
+        for(std::size_t i = 0; i < descriptorPools.size(); i++){
+            auto& pool = descriptorPools[i];
+            out << "    {\"max_sets\": " << pool.maxSets
+                << ", \"used_sets\": " << pool.usedSets
+                << ", \"peak_sets\": " << pool.peakSets << "}"
+                << (i + 1 < descriptorPools.size() ? "," : "") << "\n";
+        }
+
+        out << "  ],\n  \"pools\": [\n";
+        for(std::size_t i = 0; i < pools.size(); i++){
+            auto& pool = pools[i];
+            out << "    {\"name\": " << std::quoted(pool.name)
+                << ", \"capacity\": " << pool.capacity
+                << ", \"live\": " << pool.live
+                << ", \"high_water\": " << pool.highWater << "}"
+                << (i + 1 < pools.size() ? "," : "") << "\n";
+        }
+
+        out << "  ],\n  \"warnings\": [";
+        for(std::size_t i = 0; i < warnings.size(); i++)
+            out << (i == 0 ? "" : ", ") << std::quoted(warnings[i]);
+        out << "]\n}\n";
+        return out.str();
+    }
+
+    namespace memory_budget{
+
+        //bytes allocated from device local heaps, and from the others.
+        static void allocated(std::span<const vk::MemoryHeapUsage> heaps,
+                              uint64_t &deviceLocal,
+                              uint64_t &hostVisible)
+        {
+            deviceLocal = 0;
+            hostVisible = 0;
+            for(auto& heap : heaps)
+                (heap.deviceLocal ? deviceLocal : hostVisible) += heap.allocated;
+        }
+
+        static bool over_heap_budget(const MemoryBudget &budget, const vk::MemoryHeapUsage &heap)
+        {
+            return budget.heapUsage > 0.0f && heap.budget != 0 &&
+                   static_cast<double>(heap.usage) > budget.heapUsage * static_cast<double>(heap.budget);
+        }
+
+        uint32_t exceeded(const MemoryBudget &budget,
+                          std::span<const vk::MemoryHeapUsage> heaps,
+                          uint64_t staging)
+        {
+            uint64_t deviceLocal, hostVisible;
+            allocated(heaps, deviceLocal, hostVisible);
+
+            uint32_t limits = 0;
+            if(budget.deviceLocal != 0 && deviceLocal > budget.deviceLocal)
+                limits |= DEVICE_LOCAL_LIMIT;
+            if(budget.hostVisible != 0 && hostVisible > budget.hostVisible)
+                limits |= HOST_VISIBLE_LIMIT;
+            if(budget.staging != 0 && staging > budget.staging)
+                limits |= STAGING_LIMIT;
+            for(auto& heap : heaps)
+                if(over_heap_budget(budget, heap))
+                    limits |= HEAP_USAGE_LIMIT;
+            return limits;
+        }
+
+        void describe(uint32_t exceeded,
+                      const MemoryBudget &budget,
+                      std::span<const vk::MemoryHeapUsage> heaps,
+                      uint64_t staging,
+                      std::vector<std::string> &lines)
+        {
+            uint64_t deviceLocal, hostVisible;
+            allocated(heaps, deviceLocal, hostVisible);
+
+            if(exceeded & DEVICE_LOCAL_LIMIT)
+                lines.push_back("device local memory at " + std::to_string(deviceLocal) +
+                                " bytes, over the budget of " + std::to_string(budget.deviceLocal));
+            if(exceeded & HOST_VISIBLE_LIMIT)
+                lines.push_back("host visible memory at " + std::to_string(hostVisible) +
+                                " bytes, over the budget of " + std::to_string(budget.hostVisible));
+            if(exceeded & STAGING_LIMIT)
+                lines.push_back("staging reservations at " + std::to_string(staging) +
+                                " bytes, over the budget of " + std::to_string(budget.staging));
+            if(exceeded & HEAP_USAGE_LIMIT){
+                for(std::size_t i = 0; i < heaps.size(); i++){
+                    if(!over_heap_budget(budget, heaps[i]))
+                        continue;
+                    lines.push_back("heap " + std::to_string(i) + " uses " + std::to_string(heaps[i].usage) +
+                                    " of its " + std::to_string(heaps[i].budget) + " bytes driver budget");
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,138 @@
+#include <boitatah/modules/Profiler.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_set>
+#include <vector>
+
+namespace boitatah::profiler{
+
+    //rings outlive their threads, so a dump still shows finished workers.
+    static std::mutex s_ringsMutex;
+    static std::vector<std::unique_ptr<ThreadRing>> s_rings;
+
+    static thread_local ThreadRing* t_ring = nullptr;
+
+    //set nodes don't move, the strings live as long as the program.
+    static std::mutex s_namesMutex;
+    static std::unordered_set<std::string> s_names;
+
+    static ThreadRing& register_ring()
+    {
+        std::lock_guard lock(s_ringsMutex);
+        s_rings.push_back(std::make_unique<ThreadRing>());
+        auto& ring = *s_rings.back();
+        ring.id = static_cast<uint32_t>(s_rings.size());
+        return ring;
+    }
+
+    static ThreadRing& thread_ring()
+    {
+        if(t_ring == nullptr)
+            t_ring = &register_ring();
+        return *t_ring;
+    }
+
+    static void write_zone(ThreadRing &ring, const char *name, uint64_t begin, uint64_t end)
+    {
+        uint64_t head = ring.head.load(std::memory_order_relaxed);
+        auto& zone = ring.zones[head % PROFILER_RING_ZONES];
+        zone.name.store(name, std::memory_order_relaxed);
+        zone.begin.store(begin, std::memory_order_relaxed);
+        zone.end.store(end, std::memory_order_relaxed);
+        //publishes the zone to dumps.
+        ring.head.store(head + 1, std::memory_order_release);
+    }
+
+    uint64_t now_ns()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    void set_thread_name(const char *name)
+    {
+        thread_ring().name.store(name, std::memory_order_relaxed);
+    }
+
+    void record_zone(const char *name, uint64_t begin, uint64_t end)
+    {
+        write_zone(thread_ring(), name, begin, end);
+    }
+
+    ThreadRing &create_track(const char *name)
+    {
+        auto& track = register_ring();
+        track.name.store(name, std::memory_order_relaxed);
+        return track;
+    }
+
+    void record_track_zone(ThreadRing &track, const char *name, uint64_t begin, uint64_t end)
+    {
+        write_zone(track, name, begin, end);
+    }
+
+    const char *intern(const std::string &text)
+    {
+        std::lock_guard lock(s_namesMutex);
+        return s_names.insert(text).first->c_str();
+    }
+
+    //names are code identifiers and literals, only quotes and backslashes need escaping.
+    static void write_json_string(std::ofstream &out, const char *text)
+    {
+        out << '"';
+        for(const char* c = text; *c != '\0'; c++){
+            if(*c == '"' || *c == '\\')
+                out << '\\';
+            out << *c;
+        }
+        out << '"';
+    }
+
+    void write_chrome_trace(const std::string &path)
+    {
+        std::ofstream out(path);
+        if(!out)
+            throw std::runtime_error("failed to open profiler trace " + path);
+
+        out << std::fixed << std::setprecision(3);
+        out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+
+        std::lock_guard lock(s_ringsMutex);
+        bool first = true;
+        for(auto& ring : s_rings){
+            const char* name = ring->name.load(std::memory_order_relaxed);
+            out << (first ? "" : ",\n")
+                << "{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 1, \"tid\": " << ring->id
+                << ", \"args\": {\"name\": ";
+            write_json_string(out, name != nullptr ? name : "thread");
+            out << "}}";
+            first = false;
+
+            uint64_t head = ring->head.load(std::memory_order_acquire);
+            uint64_t tail = head > PROFILER_RING_ZONES ? head - PROFILER_RING_ZONES : 0;
+            for(uint64_t i = tail; i < head; i++){
+                auto& zone = ring->zones[i % PROFILER_RING_ZONES];
+                const char* zoneName = zone.name.load(std::memory_order_relaxed);
+                uint64_t begin = zone.begin.load(std::memory_order_relaxed);
+                uint64_t end = zone.end.load(std::memory_order_relaxed);
+
+                //the slot was reused, or is being, while it was read.
+                if(ring->head.load(std::memory_order_acquire) >= i + PROFILER_RING_ZONES)
+                    continue;
+
+                out << ",\n{\"ph\": \"X\", \"name\": ";
+                write_json_string(out, zoneName);
+                out << ", \"pid\": 1, \"tid\": " << ring->id
+                    << ", \"ts\": " << begin / 1000.0
+                    << ", \"dur\": " << (end - begin) / 1000.0 << "}";
+            }
+        }
+        out << "\n]}\n";
+    }
+}
@@ -9,15 +9,35 @@ namespace boitatah{
 
     void Materials::GenerateStageBaseMaterials() {
         std::cout << "generating rendergraph base materials" << std::endl;
-        for(auto& target_handle : m_back_buffer->getCurrent_Graph()){
+        auto& graph = m_back_buffer->getCurrent_Graph();
+
+        //compile every stage base shader in one batch
+        std::vector<MakeShaderDesc> shader_descs;
+        for(auto& target_handle : graph){
+            auto& stage = m_back_buffer->getStage(target_handle);
+            switch(stage.type){
+                case StageType::CAMERA:
+                    shader_descs.push_back(BaseCameraShaderDesc(target_handle));
+                    break;
+                case StageType::SCREEN_QUAD:
+                    shader_descs.push_back(BaseScreenQuadShaderDesc(target_handle));
+                    break;
+            }
+        }
+        auto shaders = m_material_mngr->getShaderManager().makeShaders(shader_descs);
+        //this thread compiles too until the batch is done.
+        m_material_mngr->getShaderManager().waitShaderCompilation();
+
+        for(std::size_t i = 0; i < graph.size(); i++){
+            auto& target_handle = graph[i];
             auto& stage = m_back_buffer->getStage(target_handle);
             std::cout << "creating base material for stage " << stage.stage_index << std::endl;
             switch(stage.type){
                 case StageType::CAMERA:
-                    base_materials.push_back(GenerateBaseCameraMaterial(target_handle));
+                    base_materials.push_back(GenerateBaseCameraMaterial(target_handle, shaders[i].get()));
                     break;
                 case StageType::SCREEN_QUAD:
-                    base_materials.push_back(GenerateBaseScreenQuadMaterial(target_handle));
+                    base_materials.push_back(GenerateBaseScreenQuadMaterial(target_handle, shaders[i].get()));
                     break;
             }
             std::cout << "created base material for stage " << stage.stage_index << std::endl;
@@ -30,9 +50,21 @@ namespace boitatah{
     
     }
 
+    SpecializationConstant Materials::vertexColor(bool enabled)
+    {
+        return {.id = static_cast<uint32_t>(BaseShaderConstant::UseVertexColor),
+                .value = enabled ? VK_TRUE : VK_FALSE};
+    }
+
+    SpecializationConstant Materials::maxLights(uint32_t count)
+    {
+        return {.id = static_cast<uint32_t>(BaseShaderConstant::MaxLights), .value = count};
+    }
+
     Handle<Material> Materials::createUnlitMaterial(uint32_t                stage_mask,
                                                     uint32_t                priority,
-                                                    Handle<RenderTexture>   texture){
+                                                    Handle<RenderTexture>   texture,
+                                                    const std::vector<SpecializationConstant>& specialization){
 
         auto compat_stage_handle = m_back_buffer->getCompatibleRenderStage( 1u << stage_mask);
         auto& compatible_stage = m_back_buffer->getStage(compat_stage_handle);
@@ -51,7 +83,7 @@ namespace boitatah{
         auto material =  m_material_mngr->createMaterial({
             .stage_mask = stage_mask,
             .priority = priority,
-            .shader = shader.first,
+            .shader = m_material_mngr->getShaderManager().getVariant(shader.first, specialization),
             .bindings = bindings,
             .vertexBufferBindings = {
                 VERTEX_BUFFER_TYPE::POSITION,
@@ -66,7 +98,8 @@ namespace boitatah{
 
     Handle<Material> Materials::createLambertMaterial(uint32_t stage_mask, 
                                                       uint32_t priority, 
-                                                      Handle<RenderTexture> texture)
+                                                      Handle<RenderTexture> texture,
+                                                      const std::vector<SpecializationConstant>& specialization)
     {
         auto compat_stage_handle = m_back_buffer->getCompatibleRenderStage( 1u << stage_mask);
         auto& compatible_stage = m_back_buffer->getStage(compat_stage_handle);
@@ -85,7 +118,7 @@ namespace boitatah{
         auto material =  m_material_mngr->createMaterial({
             .stage_mask = stage_mask,
             .priority = priority,
-            .shader = shader.first,
+            .shader = m_material_mngr->getShaderManager().getVariant(shader.first, specialization),
             .bindings = bindings,
             .vertexBufferBindings = {
                 VERTEX_BUFFER_TYPE::POSITION,
@@ -99,7 +132,8 @@ namespace boitatah{
         return material;
     }
     Handle<Material> Materials::createUnlitDeferredComposeMaterial(uint32_t stage_mask,
-                                                                   uint32_t priority)
+                                                                   uint32_t priority,
+                                                                   const std::vector<SpecializationConstant>& specialization)
     {
         auto compat_stage_handle = m_back_buffer->getCompatibleRenderStage( 1u<< stage_mask);
         auto& compatible_stage = m_back_buffer->getStage(compat_stage_handle);
@@ -116,7 +150,7 @@ namespace boitatah{
         auto material =  m_material_mngr->createMaterial({
             .stage_mask = stage_mask,
             .priority = priority,
-            .shader = shader.first,
+            .shader = m_material_mngr->getShaderManager().getVariant(shader.first, specialization),
             .bindings = override_binding,
             .vertexBufferBindings = {
                 VERTEX_BUFFER_TYPE::POSITION,
@@ -128,7 +162,8 @@ namespace boitatah{
         return material;
     }
     Handle<Material> Materials::createLambertDeferredComposeMaterial(uint32_t stage_mask,
-                                                                     uint32_t priority)
+                                                                     uint32_t priority,
+                                                                     const std::vector<SpecializationConstant>& specialization)
     {
         auto compat_stage_handle = m_back_buffer->getCompatibleRenderStage( 1u<< stage_mask);
         auto& compatible_stage = m_back_buffer->getStage(compat_stage_handle);
@@ -146,7 +181,7 @@ namespace boitatah{
         auto material =  m_material_mngr->createMaterial({
             .stage_mask = stage_mask,
             .priority = priority,
-            .shader = shader.first,
+            .shader = m_material_mngr->getShaderManager().getVariant(shader.first, specialization),
             .bindings = bindings,
             .vertexBufferBindings = {
                 VERTEX_BUFFER_TYPE::POSITION,
@@ -161,21 +196,28 @@ namespace boitatah{
 
     void Materials::BuildShaderMap()
     {
+        std::vector<MakeShaderDesc> shader_descs;
         for(std::size_t i = 0; i < m_back_buffer->getStageCount(); ++i){
-            BuildUnlitShader(i);
-            BuildLambertShader(i);
+            shader_descs.push_back(BuildUnlitShader(i));
+            shader_descs.push_back(BuildLambertShader(i));
+        }
+
+        auto shaders = m_material_mngr->getShaderManager().makeShaders(shader_descs);
+        //this thread compiles too until the batch is done.
+        m_material_mngr->getShaderManager().waitShaderCompilation();
+
+        for(std::size_t i = 0; i < m_back_buffer->getStageCount(); ++i){
+            base_shaders[i][static_cast<uint32_t>(ShaderType::Unlit)].first = shaders[2 * i].get();
+            base_shaders[i][static_cast<uint32_t>(ShaderType::Lambert)].first = shaders[2 * i + 1].get();
         }
     }
 
-    void Materials::BuildUnlitShader(uint32_t stage_index)
+    MakeShaderDesc Materials::BuildUnlitShader(uint32_t stage_index)
     {
         std::cout << "building unlit shader" << std::endl;
         auto stage = m_back_buffer->getStage(stage_index);
         auto base_material_handle = getStageBaseMaterial(stage_index);
         auto& base_material = m_material_mngr->getMaterialContent(base_material_handle);
-        auto& base_shader = m_material_mngr->getShaderManager()
-                                          .get(base_material.shader);
-
         //TODO make this less cumbersome.
         auto setLayouts = m_material_mngr->getShaderManager()
                                           .get(base_material.shader)
@@ -188,25 +230,12 @@ namespace boitatah{
         auto shader_desc = MakeShaderDesc{
                         .name = "unlit shader",
                         .renderPass = pass,
-                        .vertexBindings = base_shader.description.vertexBindings,
                       };
 
 
         //TODO make this less hardcoded.
         switch(stage.type){
             case StageType::CAMERA:{
-                //add a texture to the base camera
-                auto texture_layout = m_descriptor_mngr->getLayout({
-                                        .bindingDescriptors = {
-                                        {//.binding = 0,
-                                        .type = DESCRIPTOR_TYPE::COMBINED_IMAGE_SAMPLER,
-                                        .stages = SHADER_STAGE::FRAGMENT,
-                                        .descriptorCount= 1,
-                                            }
-                                        }
-                                    });
-                setLayouts.push_back(texture_layout);
-
                 shader_desc.vert = {.byteCode =  utils::readFile(
                                             "./shaders/base_shaders/unlit_camera_mat.vert.spv"),
                                     .entryFunction = "main"};
@@ -225,7 +254,6 @@ namespace boitatah{
             }
             case StageType::SCREEN_QUAD:
                 std::cout << "building defered unlit compose shader" << std::endl;
-\
                 shader_desc.vert = {.byteCode =  utils::readFile(
                                             "./shaders/base_shaders/base_screen_quad.vert.spv"),
                                     .entryFunction = "main"};
@@ -236,9 +264,14 @@ namespace boitatah{
 
         }
 
+        //texture and light sets come from the shaders, the base material sets are kept.
+        auto reflection = m_material_mngr
+                            ->getShaderManager()
+                            .reflectShader(shader_desc.vert, shader_desc.frag);
+        shader_desc.vertexBindings = reflection.vertexBindings;
         auto shader_layout = m_material_mngr
                             ->getShaderManager()
-                            .makeShaderLayout({.setLayouts = setLayouts});
+                            .makeShaderLayout(reflection, setLayouts);
         shader_desc.layout = shader_layout;
 
         //TODO temp workaround
@@ -250,25 +283,19 @@ namespace boitatah{
             blends.push_back({});
         shader_desc.colorBlends = blends;
 
-        auto shader = m_material_mngr
-                      ->getShaderManager()
-                      .makeShader(shader_desc);
-
+        //the pipeline is filled by BuildShaderMap once the batch resolves.
         base_shaders[stage_index][static_cast<uint32_t>(ShaderType::Unlit)] = {
-            shader, shader_layout
+            Handle<Shader>{}, shader_layout
         };
-
+        return shader_desc;
     }
 
-    void Materials::BuildLambertShader(uint32_t stage_index)
+    MakeShaderDesc Materials::BuildLambertShader(uint32_t stage_index)
     {
              std::cout << "building lit shader" << std::endl;
         auto stage = m_back_buffer->getStage(stage_index);
         auto base_material_handle = getStageBaseMaterial(stage_index);
         auto& base_material = m_material_mngr->getMaterialContent(base_material_handle);
-        auto& base_shader = m_material_mngr->getShaderManager()
-                                          .get(base_material.shader);
-
         //TODO make this less cumbersome.
         auto setLayouts = m_material_mngr->getShaderManager()
                                           .get(base_material.shader)
@@ -278,41 +305,13 @@ namespace boitatah{
         auto& pass = m_target_mngr->get(stage.target).renderpass;
 
         auto shader_desc = MakeShaderDesc{
-                        .name = "unlit shader",
+                        .name = "lambert shader",
                         .renderPass = pass,
-                        .vertexBindings = base_shader.description.vertexBindings,
                       };
 
-        auto lights_layout = m_descriptor_mngr->getLayout({
-                                        .bindingDescriptors = {
-                                        {//.binding = 0,
-                                            .type = DESCRIPTOR_TYPE::UNIFORM_BUFFER,
-                                            .stages = SHADER_STAGE::FRAGMENT,
-                                            .descriptorCount= 1,
-                                        },
-                                        {//.binding = 0,
-                                            .type = DESCRIPTOR_TYPE::UNIFORM_BUFFER,
-                                            .stages = SHADER_STAGE::FRAGMENT,
-                                            .descriptorCount= 1,
-                                        }
-                                        }
-                                    });
-
         //TODO make this less hardcoded.
         switch(stage.type){
             case StageType::CAMERA:{
-                //add a texture to the base camera
-                auto texture_layout = m_descriptor_mngr->getLayout({
-                                        .bindingDescriptors = {
-                                        {//.binding = 0,
-                                        .type = DESCRIPTOR_TYPE::COMBINED_IMAGE_SAMPLER,
-                                        .stages = SHADER_STAGE::FRAGMENT,
-                                        .descriptorCount= 1,
-                                            }
-                                        }
-                                    });
-                setLayouts.push_back(texture_layout);
-
                 shader_desc.vert = {.byteCode =  utils::readFile(
                                             "./shaders/base_shaders/lit_camera_mat.vert.spv"),
                                     .entryFunction = "main"};
@@ -331,7 +330,6 @@ namespace boitatah{
             }
             case StageType::SCREEN_QUAD:
                 std::cout << "building defered unlit compose shader" << std::endl;
-                setLayouts.push_back(lights_layout);
                 shader_desc.vert = {.byteCode =  utils::readFile(
                                             "./shaders/base_shaders/base_screen_quad.vert.spv"),
                                     .entryFunction = "main"};
@@ -342,9 +340,14 @@ namespace boitatah{
 
         }
 
+        //texture and light sets come from the shaders, the base material sets are kept.
+        auto reflection = m_material_mngr
+                            ->getShaderManager()
+                            .reflectShader(shader_desc.vert, shader_desc.frag);
+        shader_desc.vertexBindings = reflection.vertexBindings;
         auto shader_layout = m_material_mngr
                             ->getShaderManager()
-                            .makeShaderLayout({.setLayouts = setLayouts});
+                            .makeShaderLayout(reflection, setLayouts);
         shader_desc.layout = shader_layout;
 
         //TODO temp workaround
@@ -356,48 +359,15 @@ namespace boitatah{
             blends.push_back({});
         shader_desc.colorBlends = blends;
 
-        auto shader = m_material_mngr
-                      ->getShaderManager()
-                      .makeShader(shader_desc);
-
         base_shaders[stage_index][static_cast<uint32_t>(ShaderType::Lambert)] = {
-            shader, shader_layout
-        };   
+            Handle<Shader>{}, shader_layout
+        };
+        return shader_desc;
     }
 
-    Handle<Material> Materials::GenerateBaseCameraMaterial(Handle<RenderStage> stage_handle)
+    MakeShaderDesc Materials::BaseCameraShaderDesc(Handle<RenderStage> stage_handle)
     {
-        std::cout <<  "making base camera" << std::endl;
         auto& stage = m_back_buffer->getStage(stage_handle);
-        //binds one camera transform
-        auto base_setLayout = m_descriptor_mngr->getLayout({
-                            .bindingDescriptors = {
-                                {//.binding = 0,
-                                .type = DESCRIPTOR_TYPE::UNIFORM_BUFFER,
-                                .stages = SHADER_STAGE::ALL_GRAPHICS,
-                                .descriptorCount= 1,
-                                }
-                            }
-                        });
-        auto uniforms = m_material_mngr->createBinding(base_setLayout);
-
-        std::vector<VertexBindings> vertex_bindings = {
-                                {.stride = 12, 
-                                .attributes = {{.location = 0, 
-                                                .format = IMAGE_FORMAT::RGB_32_SFLOAT, 
-                                                .offset = 0}}},
-                                {.stride = 8, .
-                                attributes = {{ .location = 1, 
-                                                .format = IMAGE_FORMAT::RG_32_SFLOAT, 
-                                                .offset = 0}}},
-                                {.stride = 12, 
-                                .attributes = {{.location = 2, 
-                                                .format = IMAGE_FORMAT::RGB_32_SFLOAT, 
-                                                .offset = 0}}},
-                                {.stride = 12, 
-                                .attributes = {{.location = 3, 
-                                                .format = IMAGE_FORMAT::RGB_32_SFLOAT, 
-                                                .offset = 0}}}};
 
         //TODO temp workaround
         std::vector<ColorBlend> blends;
@@ -407,12 +377,9 @@ namespace boitatah{
         for(uint32_t i = 0; i < color_atts_count; i++)
             blends.push_back({});
 
-        //make the shader and material
-        auto shader_layout = m_material_mngr
-                            ->getShaderManager()
-                            .makeShaderLayout({.setLayouts={base_setLayout}});
         auto& pass = m_target_mngr->get(stage.target).renderpass;
-        auto shader = m_material_mngr->getShaderManager().makeShader({
+        auto shader_desc = MakeShaderDesc{
+            .name = "base camera shader",
             .vert = {.byteCode = utils::readFile(
                                     "./shaders/base_shaders/base_camera_mat.vert.spv"),
                      .entryFunction = "main"},
@@ -420,11 +387,29 @@ namespace boitatah{
                                     "./shaders/base_shaders/base_camera_mat.frag.spv"),
                      .entryFunction = "main"},
             .renderPass = pass,
-            .layout = shader_layout,
             .colorBlends = blends,
-            .vertexBindings = vertex_bindings
-            });
+            };
 
+        //camera uniforms and vertex inputs come from the shaders.
+        auto reflection = m_material_mngr
+                            ->getShaderManager()
+                            .reflectShader(shader_desc.vert, shader_desc.frag);
+        shader_desc.vertexBindings = reflection.vertexBindings;
+        shader_desc.layout = m_material_mngr
+                            ->getShaderManager()
+                            .makeShaderLayout(reflection);
+        return shader_desc;
+    }
+
+    Handle<Material> Materials::GenerateBaseCameraMaterial(Handle<RenderStage> stage_handle,
+                                                           Handle<Shader> shader)
+    {
+        std::cout <<  "making base camera" << std::endl;
+        auto& base_setLayout = m_material_mngr->getShaderManager()
+                                              .get(shader)
+                                              .layout
+                                              .descriptorSets[0];
+        auto uniforms = m_material_mngr->createBinding(base_setLayout);
 
         auto material = m_material_mngr->createMaterial({
             .stage_mask = 0,
@@ -440,31 +425,13 @@ namespace boitatah{
         return material;
     }
 
-    Handle<Material> Materials::GenerateBaseScreenQuadMaterial(Handle<RenderStage> stage_handle)
+    MakeShaderDesc Materials::BaseScreenQuadShaderDesc(Handle<RenderStage> stage_handle)
     {
-
-        std::cout <<  "making base Screen Quad" << std::endl;
         auto& stage = m_back_buffer->getStage(stage_handle);
         auto stage_binding = m_back_buffer->getStageBinding(stage_handle);
-        
 
         //add stage uniforms
         auto stage_layout = m_material_mngr->createBindingsSetLayout(stage_binding);
-        std::vector<Handle<MaterialBinding>> uniforms;
-        uniforms.push_back(stage_binding);
-
-        std::vector<VertexBindings> vertex_bindings = {{.stride = 12, 
-                                .attributes = {{.location = 0, 
-                                                .format = IMAGE_FORMAT::RGB_32_SFLOAT, 
-                                                .offset = 0}}},
-                                {.stride = 8, .
-                                attributes = {{ .location = 1, 
-                                                .format = IMAGE_FORMAT::RG_32_SFLOAT, 
-                                                .offset = 0}}},
-                                {.stride = 12, 
-                                .attributes = {{.location = 2, 
-                                                .format = IMAGE_FORMAT::RGB_32_SFLOAT, 
-                                                .offset = 0}}}};
 
         //TODO temp workaround
         std::vector<ColorBlend> blends;
@@ -474,13 +441,9 @@ namespace boitatah{
         for(uint32_t i = 0; i < color_atts_count; i++)
             blends.push_back({});
 
-        //auto tex_layout_desc = m_material_mngr->createBindingsSetLayout(stage.materialBinding);
-
-        auto shader_layout = m_material_mngr
-                            ->getShaderManager()
-                            .makeShaderLayout({.setLayouts={stage_layout}});//, tex_layout_desc}});
         auto& pass = m_target_mngr->get(stage.target).renderpass;
-        auto shader = m_material_mngr->getShaderManager().makeShader({
+        auto shader_desc = MakeShaderDesc{
+            .name = "base screen quad shader",
             .vert = {.byteCode = utils::readFile(
                                     "./shaders/base_shaders/base_screen_quad.vert.spv"),
                      .entryFunction = "main"},
@@ -488,10 +451,26 @@ namespace boitatah{
                                     "./shaders/base_shaders/base_screen_quad.frag.spv"),
                      .entryFunction = "main"},
             .renderPass = pass,
-            .layout = shader_layout,
             .colorBlends  = blends,
-            .vertexBindings = vertex_bindings,
-            });
+            };
+
+        //set 0 follows the backbuffer stage binding, the rest is reflected.
+        auto reflection = m_material_mngr
+                            ->getShaderManager()
+                            .reflectShader(shader_desc.vert, shader_desc.frag);
+        shader_desc.vertexBindings = reflection.vertexBindings;
+        shader_desc.layout = m_material_mngr
+                            ->getShaderManager()
+                            .makeShaderLayout(reflection, {stage_layout});
+        return shader_desc;
+    }
+
+    Handle<Material> Materials::GenerateBaseScreenQuadMaterial(Handle<RenderStage> stage_handle,
+                                                               Handle<Shader> shader)
+    {
+        std::cout <<  "making base Screen Quad" << std::endl;
+        std::vector<Handle<MaterialBinding>> uniforms;
+        uniforms.push_back(m_back_buffer->getStageBinding(stage_handle));
 
         auto material = m_material_mngr->createMaterial({
             .stage_mask = 0,
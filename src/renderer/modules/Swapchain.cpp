@@ -57,16 +57,16 @@ namespace boitatah
         this->window = window;
     }
 
-    void Swapchain::createSwapchain()
+    void Swapchain::createSwapchain(VkExtent2D framebufferSize)
     {
         clearSwapchainViews();
         swapchainImageCache.clear();
         vkDestroySwapchainKHR(vulkan->get_device(), swapchain, nullptr);
-        createVkSwapchain();
+        createVkSwapchain(framebufferSize);
         createViews();
     }
 
-    void Swapchain::createVkSwapchain()
+    void Swapchain::createVkSwapchain(VkExtent2D framebufferSize)
     {
         SwapchainSupport support = getSwapchainSupport(vulkan->get_physical_device());
 
@@ -75,7 +75,7 @@ namespace boitatah
                                                             COLOR_SPACE::SRGB_NON_LINEAR);
 
         VkPresentModeKHR mode = chooseSwapPresentMode(support.presentModes);
-        VkExtent2D extent = chooseSwapExtent(support.capabilities);
+        VkExtent2D extent = chooseSwapExtent(support.capabilities, framebufferSize);
 
         uint32_t imageCount = support.capabilities.minImageCount;
         imageCount += 1;
@@ -246,7 +246,7 @@ namespace boitatah
         throw std::runtime_error("Unable to select Swapchain format");
     }
 
-    VkExtent2D Swapchain::chooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities)
+    VkExtent2D Swapchain::chooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities, VkExtent2D framebufferSize)
     {
         if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max())
         {
@@ -254,12 +254,8 @@ namespace boitatah
         }
         else
         {
-            int width, height;
-            glfwGetFramebufferSize(window->window, &width, &height);
-
-            VkExtent2D extent{
-                .width = static_cast<uint32_t>(width),
-                .height = static_cast<uint32_t>(height)};
+            //glfw may only be queried on the main thread, this can run on the render thread.
+            VkExtent2D extent = framebufferSize;
 
             extent.width = std::clamp(extent.width,
                                       capabilities.minImageExtent.width,
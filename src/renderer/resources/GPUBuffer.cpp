@@ -13,7 +13,7 @@ namespace boitatah{
         return addr;
     }
 
-    void GPUBuffer::copyData(const void *data, uint32_t length)
+    void GPUBuffer::copyData(const void *data, VkDeviceSize length)
     {
         
         set_dirty();
@@ -31,6 +31,8 @@ namespace boitatah{
                     .sharing = SHARING_MODE::CONCURRENT,
                 });
             }
+            //reuse the staging buffer only once its last copy executed.
+            manager->waitForBatch(stagingBatch);
             bufferManager->memoryCopy(std::min(size, length), data, stagingBuffer);
         }
         else{
@@ -55,7 +57,7 @@ namespace boitatah{
     {     
         auto manager = std::shared_ptr(m_manager);
         auto data = BufferGPUData{.buffer =  manager->getBufferManager()->reserveBuffer({
-                            .request = std::max(size, 64u),
+                            .request = std::max<VkDeviceSize>(size, 64),
                             .usage = usage,
                             .sharing = m_descriptor.sharing,}),
                             .buffer_capacity = size};
@@ -68,6 +70,7 @@ namespace boitatah{
         if(m_descriptor.sharing == SHARING_MODE::EXCLUSIVE){
             auto manager = std::shared_ptr(m_manager)->getBufferManager();
             manager->queueCopy(writer, stagingBuffer, data.buffer);
+            stagingBatch = writer.self().get_batch_id();
         }
     };
 
@@ -11,7 +11,7 @@ namespace boitatah{
         texProps.width = description.width;
         texProps.height = description.height;
         texProps.format = description.format;
-        texProps.byteSize = texProps.width * 
+        texProps.byteSize = static_cast<VkDeviceSize>(texProps.width) *
                             texProps.height * 
                             texProps.depth * 
                             formatSize(description.format);
@@ -121,6 +121,19 @@ namespace boitatah{
     {
         m_mode = mode;
     }
+    void Texture::setQueueTransfer(uint32_t srcFamily, uint32_t dstFamily)
+    {
+        m_srcQueueFamily = srcFamily;
+        m_dstQueueFamily = dstFamily;
+    }
+    bool Texture::uploadsFromBuffer() const
+    {
+        return update_from == TextureUpdateFrom::STAGING_BUFFER;
+    }
+    VkDeviceSize Texture::byteSize() const
+    {
+        return texProps.byteSize;
+    }
     TextureAccessData Texture::GetRenderData(TextureGPUData &gpu_data)
     {
         auto& image = m_manager->getImageManager().getImage(gpu_data.image);
@@ -198,7 +211,9 @@ namespace boitatah{
                 .offset = {0, 0, 0},
                 .extent = {texProps.width, texProps.height, 1},
                 .srcImgLayout = castEnum<VkImageLayout>(IMAGE_LAYOUT::UNDEFINED),
-                .dstImgLayout = castEnum<VkImageLayout>(m_desiredLayout),});
+                .dstImgLayout = castEnum<VkImageLayout>(m_desiredLayout),
+                .srcQueueFamily = m_srcQueueFamily,
+                .dstQueueFamily = m_dstQueueFamily,});
                 data.generation = image_generation;
         }
 